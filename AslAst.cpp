@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslAst - Compact, arena allocated lowering of the
+//           parse tree of an Asl program
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "AslAst.h"
+
+#include "antlr4-runtime.h"
+#include "AslParser.h"
+
+#include <utility>    // std::pair
+
+
+// Whether the token type is one of the names kept in the AST
+static bool isNameToken(std::size_t type) {
+  return type == AslParser::ID      or type == AslParser::INTVAL  or
+         type == AslParser::FLOATVAL or type == AslParser::CHARVAL or
+         type == AslParser::BOOLVAL or type == AslParser::STRING;
+}
+
+// Kind of the node of a context
+static AslAst::Kind kindOf(antlr4::ParserRuleContext *ctx) {
+  switch (ctx->getRuleIndex()) {
+  case AslParser::RuleProgram:        return AslAst::Program;
+  case AslParser::RuleFunction:       return AslAst::Function;
+  case AslParser::RuleReturn_type:    return AslAst::Return_type;
+  case AslParser::RuleParameter_decl: return AslAst::Parameter_decl;
+  case AslParser::RulePdObj:          return AslAst::PdObj;
+  case AslParser::RuleDeclarations:   return AslAst::Declarations;
+  case AslParser::RuleVariable_decl:  return AslAst::Variable_decl;
+  case AslParser::RuleType:           return AslAst::Type;
+  case AslParser::RuleVect:           return AslAst::Vect;
+  case AslParser::RuleBasic_type:     return AslAst::Basic_type;
+  case AslParser::RuleStatements:     return AslAst::Statements;
+  case AslParser::RuleLeft_expr:      return AslAst::Left_expr;
+  case AslParser::RuleIdent:          return AslAst::Ident;
+  case AslParser::RuleStatement:
+    if (antlrcpp::is<AslParser::AssignStmtContext *>(ctx))  return AslAst::AssignStmt;
+    if (antlrcpp::is<AslParser::ReturnContext *>(ctx))      return AslAst::Return;
+    if (antlrcpp::is<AslParser::WhileStmtContext *>(ctx))   return AslAst::WhileStmt;
+    if (antlrcpp::is<AslParser::IfStmtContext *>(ctx))      return AslAst::IfStmt;
+    if (antlrcpp::is<AslParser::ProcCallContext *>(ctx))    return AslAst::ProcCall;
+    if (antlrcpp::is<AslParser::ReadStmtContext *>(ctx))    return AslAst::ReadStmt;
+    if (antlrcpp::is<AslParser::WriteExprContext *>(ctx))   return AslAst::WriteExpr;
+    if (antlrcpp::is<AslParser::WriteStringContext *>(ctx)) return AslAst::WriteString;
+    break;
+  case AslParser::RuleExpr:
+    if (antlrcpp::is<AslParser::ParContext *>(ctx))          return AslAst::Par;
+    if (antlrcpp::is<AslParser::Array_readContext *>(ctx))   return AslAst::Array_read;
+    if (antlrcpp::is<AslParser::Return_funcContext *>(ctx))  return AslAst::Return_func;
+    if (antlrcpp::is<AslParser::NotplusminusContext *>(ctx)) return AslAst::Notplusminus;
+    if (antlrcpp::is<AslParser::ArithmeticContext *>(ctx))   return AslAst::Arithmetic;
+    if (antlrcpp::is<AslParser::RelationalContext *>(ctx))   return AslAst::Relational;
+    if (antlrcpp::is<AslParser::LogicContext *>(ctx))        return AslAst::Logic;
+    if (antlrcpp::is<AslParser::ValueContext *>(ctx))        return AslAst::Value;
+    if (antlrcpp::is<AslParser::ExprIdentContext *>(ctx))    return AslAst::ExprIdent;
+    break;
+  }
+  // only a tree with syntax errors has other contexts
+  return AslAst::NumKinds;
+}
+
+void AslAst::lower(antlr4::ParserRuleContext *root) {
+  Nodes.clear();
+  ChildIds.clear();
+  NameRefs.clear();
+
+  // preorder, with an explicit stack of (context, slot in ChildIds
+  // where its number goes)
+  const uint32_t noSlot = UINT32_MAX;
+  std::vector<std::pair<antlr4::ParserRuleContext *, uint32_t>> pending;
+  pending.push_back(std::make_pair(root, noSlot));
+  while (not pending.empty()) {
+    antlr4::ParserRuleContext *ctx  = pending.back().first;
+    uint32_t                   slot = pending.back().second;
+    pending.pop_back();
+
+    NodeId n = Nodes.size();
+    if (slot != noSlot)
+      ChildIds[slot] = n;
+
+    Node node;
+    node.kind        = kindOf(ctx);
+    node.op          = 0;
+    node.line        = ctx->getStart() ? ctx->getStart()->getLine() : 0;
+    node.end         = n + 1;
+    node.firstChild  = ChildIds.size();
+    node.numChildren = 0;
+    node.firstName   = NameRefs.size();
+    node.numNames    = 0;
+    for (auto child : ctx->children) {
+      if (antlrcpp::is<antlr4::tree::TerminalNode *>(child)) {
+        antlr4::Token *tok = static_cast<antlr4::tree::TerminalNode *>(child)->getSymbol();
+        if (node.op == 0)
+          node.op = tok->getType();
+        if (isNameToken(tok->getType())) {
+          NameRefs.push_back(intern(tok->getText()));
+          ++node.numNames;
+        }
+      }
+      else
+        ++node.numChildren;
+    }
+    Nodes.push_back(node);
+
+    // the children are pushed in reverse order, to be numbered in order
+    ChildIds.resize(ChildIds.size() + node.numChildren);
+    uint32_t childSlot = node.firstChild + node.numChildren;
+    for (auto it = ctx->children.rbegin(); it != ctx->children.rend(); ++it)
+      if (not antlrcpp::is<antlr4::tree::TerminalNode *>(*it))
+        pending.push_back(std::make_pair(static_cast<antlr4::ParserRuleContext *>(*it), --childSlot));
+  }
+
+  // the subtree of a node ends where the subtree of its last child does
+  for (std::size_t n = Nodes.size(); n-- > 0; ) {
+    Node & node = Nodes[n];
+    if (node.numChildren > 0)
+      node.end = Nodes[ChildIds[node.firstChild + node.numChildren - 1]].end;
+  }
+}
+
+std::vector<antlr4::ParserRuleContext *> AslAst::contexts(antlr4::ParserRuleContext *root) {
+  // the same preorder as lower()
+  std::vector<antlr4::ParserRuleContext *> result;
+  std::vector<antlr4::ParserRuleContext *> pending(1, root);
+  while (not pending.empty()) {
+    antlr4::ParserRuleContext *ctx = pending.back();
+    pending.pop_back();
+    result.push_back(ctx);
+    for (auto it = ctx->children.rbegin(); it != ctx->children.rend(); ++it)
+      if (not antlrcpp::is<antlr4::tree::TerminalNode *>(*it))
+        pending.push_back(static_cast<antlr4::ParserRuleContext *>(*it));
+  }
+  return result;
+}
+
+std::size_t AslAst::size() const {
+  return Nodes.size();
+}
+
+std::size_t AslAst::numNames() const {
+  return Names.size();
+}
+
+const AslAst::Node & AslAst::node(NodeId n) const {
+  return Nodes[n];
+}
+
+AslAst::NodeId AslAst::child(NodeId n, std::size_t i) const {
+  return ChildIds[Nodes[n].firstChild + i];
+}
+
+AslAst::NodeId AslAst::findChild(NodeId n, Kind kind) const {
+  for (std::size_t i = 0; i < Nodes[n].numChildren; ++i)
+    if (Nodes[child(n, i)].kind == kind)
+      return child(n, i);
+  return NoNode;
+}
+
+const std::string & AslAst::name(NodeId n, std::size_t i) const {
+  return Names[nameId(n, i)];
+}
+
+AslAst::NameId AslAst::nameId(NodeId n, std::size_t i) const {
+  return NameRefs[Nodes[n].firstName + i];
+}
+
+const std::string & AslAst::nameText(NameId id) const {
+  return Names[id];
+}
+
+AslAst::NameId AslAst::intern(const std::string & s) {
+  auto it = NameIndex.find(s);
+  if (it != NameIndex.end())
+    return it->second;
+  NameId id = Names.size();
+  Names.push_back(s);
+  NameIndex.emplace(s, id);
+  return id;
+}
@@ -0,0 +1,125 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslAst - Compact, arena allocated lowering of the
+//           parse tree of an Asl program
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>    // uint16_t, uint32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class AslAst: a compact copy of the parse tree, built right after
+// parsing, on which all the passes run: once it is built the parse
+// tree and the tokens are freed. The nodes are stored contiguously in
+// preorder, so the subtree of a node is the range [n, end(n));
+// children are integer indices and every identifier and literal is
+// interned once, so the passes get names as references instead of
+// building them again with getText(). Terminal nodes are not kept as
+// nodes: the operator of a rule and its identifiers and literals are
+// attributes of its node. Each node has the kind of its context: its
+// rule, or its labeled alternative for the rules statement and expr.
+
+class AslAst {
+
+public:
+
+  typedef uint32_t NodeId;    // index of a node
+  typedef uint32_t NameId;    // index of an interned name
+
+  // No node, e.g. an optional child that is not there
+  static const NodeId NoNode = UINT32_MAX;
+
+  // Kinds of nodes, named as the contexts of AslParser
+  enum Kind : uint16_t {
+    Program, Function, Return_type, Parameter_decl, PdObj, Declarations,
+    Variable_decl, Type, Vect, Basic_type, Statements,
+    // statement
+    AssignStmt, Return, WhileStmt, IfStmt, ProcCall, ReadStmt,
+    WriteExpr, WriteString,
+    Left_expr,
+    // expr
+    Par, Array_read, Return_func, Notplusminus, Arithmetic, Relational,
+    Logic, Value, ExprIdent,
+    Ident,
+    NumKinds
+  };
+
+  struct Node {
+    Kind     kind;            // rule or alternative of the context
+    uint16_t op;              // token type of the first terminal child
+    uint32_t line;            // line of the first token
+    uint32_t end;             // one past the last node of the subtree
+    uint32_t firstChild;      // children: ChildIds[firstChild ...
+    uint32_t numChildren;     //            ... firstChild+numChildren)
+    uint32_t firstName;       // names (identifiers and literals):
+    uint32_t numNames;        //   NameRefs[firstName ... +numNames)
+  };
+
+  // Build the AST of the parse tree rooted at 'root'. Iterative, so
+  // any depth of the tree is fine. The tree is not needed afterwards
+  void lower(antlr4::ParserRuleContext *root);
+
+  // The contexts of the parse tree rooted at 'root', indexed by the
+  // number that lower() gives to their nodes
+  static std::vector<antlr4::ParserRuleContext *> contexts(antlr4::ParserRuleContext *root);
+
+  // Number of nodes and interned names
+  std::size_t size() const;
+  std::size_t numNames() const;
+
+  // Node of a number, its i-th child, and its first child of a kind
+  // (NoNode if there is none)
+  const Node &  node(NodeId n) const;
+  NodeId        child(NodeId n, std::size_t i) const;
+  NodeId        findChild(NodeId n, Kind kind) const;
+
+  // The i-th identifier or literal of the node, e.g. the ID of an
+  // ident, the name of a function, the text of a value
+  const std::string & name(NodeId n, std::size_t i = 0) const;
+  NameId              nameId(NodeId n, std::size_t i = 0) const;
+  const std::string & nameText(NameId id) const;
+
+private:
+
+  // Intern a name: equal names get the same NameId
+  NameId intern(const std::string & s);
+
+  // Attributes
+  std::vector<Node>                       Nodes;
+  std::vector<NodeId>                     ChildIds;
+  std::vector<NameId>                     NameRefs;
+  std::vector<std::string>                Names;
+  std::unordered_map<std::string, NameId> NameIndex;
+
+};  // class AslAst
@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslAstListener - Base class of the passes that walk
+//               the AslAst
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "AslAst.h"
+
+
+//////////////////////////////////////////////////////////////////////
+// Class AslAstListener: the methods that AslTreeWalker calls when it
+// enters and exits each node of the AslAst, one pair per kind of node,
+// named as the ones of AslBaseListener but taking the number of the
+// node instead of its context. They do nothing: a pass redefines only
+// the ones that have an associated task.
+
+class AslAstListener {
+
+public:
+
+  virtual ~AslAstListener() {}
+
+  virtual void enterProgram(AslAst::NodeId n) {}
+  virtual void exitProgram(AslAst::NodeId n) {}
+
+  virtual void enterFunction(AslAst::NodeId n) {}
+  virtual void exitFunction(AslAst::NodeId n) {}
+
+  virtual void enterReturn_type(AslAst::NodeId n) {}
+  virtual void exitReturn_type(AslAst::NodeId n) {}
+
+  virtual void enterParameter_decl(AslAst::NodeId n) {}
+  virtual void exitParameter_decl(AslAst::NodeId n) {}
+
+  virtual void enterPdObj(AslAst::NodeId n) {}
+  virtual void exitPdObj(AslAst::NodeId n) {}
+
+  virtual void enterDeclarations(AslAst::NodeId n) {}
+  virtual void exitDeclarations(AslAst::NodeId n) {}
+
+  virtual void enterVariable_decl(AslAst::NodeId n) {}
+  virtual void exitVariable_decl(AslAst::NodeId n) {}
+
+  virtual void enterType(AslAst::NodeId n) {}
+  virtual void exitType(AslAst::NodeId n) {}
+
+  virtual void enterVect(AslAst::NodeId n) {}
+  virtual void exitVect(AslAst::NodeId n) {}
+
+  virtual void enterBasic_type(AslAst::NodeId n) {}
+  virtual void exitBasic_type(AslAst::NodeId n) {}
+
+  virtual void enterStatements(AslAst::NodeId n) {}
+  virtual void exitStatements(AslAst::NodeId n) {}
+
+  virtual void enterAssignStmt(AslAst::NodeId n) {}
+  virtual void exitAssignStmt(AslAst::NodeId n) {}
+
+  virtual void enterReturn(AslAst::NodeId n) {}
+  virtual void exitReturn(AslAst::NodeId n) {}
+
+  virtual void enterWhileStmt(AslAst::NodeId n) {}
+  virtual void exitWhileStmt(AslAst::NodeId n) {}
+
+  virtual void enterIfStmt(AslAst::NodeId n) {}
+  virtual void exitIfStmt(AslAst::NodeId n) {}
+
+  virtual void enterProcCall(AslAst::NodeId n) {}
+  virtual void exitProcCall(AslAst::NodeId n) {}
+
+  virtual void enterReadStmt(AslAst::NodeId n) {}
+  virtual void exitReadStmt(AslAst::NodeId n) {}
+
+  virtual void enterWriteExpr(AslAst::NodeId n) {}
+  virtual void exitWriteExpr(AslAst::NodeId n) {}
+
+  virtual void enterWriteString(AslAst::NodeId n) {}
+  virtual void exitWriteString(AslAst::NodeId n) {}
+
+  virtual void enterLeft_expr(AslAst::NodeId n) {}
+  virtual void exitLeft_expr(AslAst::NodeId n) {}
+
+  virtual void enterPar(AslAst::NodeId n) {}
+  virtual void exitPar(AslAst::NodeId n) {}
+
+  virtual void enterArray_read(AslAst::NodeId n) {}
+  virtual void exitArray_read(AslAst::NodeId n) {}
+
+  virtual void enterReturn_func(AslAst::NodeId n) {}
+  virtual void exitReturn_func(AslAst::NodeId n) {}
+
+  virtual void enterNotplusminus(AslAst::NodeId n) {}
+  virtual void exitNotplusminus(AslAst::NodeId n) {}
+
+  virtual void enterArithmetic(AslAst::NodeId n) {}
+  virtual void exitArithmetic(AslAst::NodeId n) {}
+
+  virtual void enterRelational(AslAst::NodeId n) {}
+  virtual void exitRelational(AslAst::NodeId n) {}
+
+  virtual void enterLogic(AslAst::NodeId n) {}
+  virtual void exitLogic(AslAst::NodeId n) {}
+
+  virtual void enterValue(AslAst::NodeId n) {}
+  virtual void exitValue(AslAst::NodeId n) {}
+
+  virtual void enterExprIdent(AslAst::NodeId n) {}
+  virtual void exitExprIdent(AslAst::NodeId n) {}
+
+  virtual void enterIdent(AslAst::NodeId n) {}
+  virtual void exitIdent(AslAst::NodeId n) {}
+
+};  // class AslAstListener
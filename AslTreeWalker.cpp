@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslTreeWalker - Walks the AslAst calling the methods
+//               of a listener
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "AslTreeWalker.h"
+
+#include "AslAst.h"
+#include "AslAstListener.h"
+
+#include <vector>
+
+
+void AslTreeWalker::walk(AslAstListener & listener, const AslAst & ast,
+                         AslAst::NodeId root) const {
+  // the nodes entered and not exited yet: each one is exited before
+  // the first node past its subtree is entered
+  std::vector<AslAst::NodeId> open;
+  AslAst::NodeId last = ast.node(root).end;
+  for (AslAst::NodeId n = root; n < last; ++n) {
+    while (not open.empty() and ast.node(open.back()).end <= n) {
+      exit(listener, ast, open.back());
+      open.pop_back();
+    }
+    enter(listener, ast, n);
+    open.push_back(n);
+  }
+  while (not open.empty()) {
+    exit(listener, ast, open.back());
+    open.pop_back();
+  }
+}
+
+void AslTreeWalker::enter(AslAstListener & listener, const AslAst & ast,
+                          AslAst::NodeId n) const {
+  switch (ast.node(n).kind) {
+  case AslAst::Program:        listener.enterProgram(n);        break;
+  case AslAst::Function:       listener.enterFunction(n);       break;
+  case AslAst::Return_type:    listener.enterReturn_type(n);    break;
+  case AslAst::Parameter_decl: listener.enterParameter_decl(n); break;
+  case AslAst::PdObj:          listener.enterPdObj(n);          break;
+  case AslAst::Declarations:   listener.enterDeclarations(n);   break;
+  case AslAst::Variable_decl:  listener.enterVariable_decl(n);  break;
+  case AslAst::Type:           listener.enterType(n);           break;
+  case AslAst::Vect:           listener.enterVect(n);           break;
+  case AslAst::Basic_type:     listener.enterBasic_type(n);     break;
+  case AslAst::Statements:     listener.enterStatements(n);     break;
+  case AslAst::AssignStmt:     listener.enterAssignStmt(n);     break;
+  case AslAst::Return:         listener.enterReturn(n);         break;
+  case AslAst::WhileStmt:      listener.enterWhileStmt(n);      break;
+  case AslAst::IfStmt:         listener.enterIfStmt(n);         break;
+  case AslAst::ProcCall:       listener.enterProcCall(n);       break;
+  case AslAst::ReadStmt:       listener.enterReadStmt(n);       break;
+  case AslAst::WriteExpr:      listener.enterWriteExpr(n);      break;
+  case AslAst::WriteString:    listener.enterWriteString(n);    break;
+  case AslAst::Left_expr:      listener.enterLeft_expr(n);      break;
+  case AslAst::Par:            listener.enterPar(n);            break;
+  case AslAst::Array_read:     listener.enterArray_read(n);     break;
+  case AslAst::Return_func:    listener.enterReturn_func(n);    break;
+  case AslAst::Notplusminus:   listener.enterNotplusminus(n);   break;
+  case AslAst::Arithmetic:     listener.enterArithmetic(n);     break;
+  case AslAst::Relational:     listener.enterRelational(n);     break;
+  case AslAst::Logic:          listener.enterLogic(n);          break;
+  case AslAst::Value:          listener.enterValue(n);          break;
+  case AslAst::ExprIdent:      listener.enterExprIdent(n);      break;
+  case AslAst::Ident:          listener.enterIdent(n);          break;
+  default: break;
+  }
+}
+
+void AslTreeWalker::exit(AslAstListener & listener, const AslAst & ast,
+                         AslAst::NodeId n) const {
+  switch (ast.node(n).kind) {
+  case AslAst::Program:        listener.exitProgram(n);        break;
+  case AslAst::Function:       listener.exitFunction(n);       break;
+  case AslAst::Return_type:    listener.exitReturn_type(n);    break;
+  case AslAst::Parameter_decl: listener.exitParameter_decl(n); break;
+  case AslAst::PdObj:          listener.exitPdObj(n);          break;
+  case AslAst::Declarations:   listener.exitDeclarations(n);   break;
+  case AslAst::Variable_decl:  listener.exitVariable_decl(n);  break;
+  case AslAst::Type:           listener.exitType(n);           break;
+  case AslAst::Vect:           listener.exitVect(n);           break;
+  case AslAst::Basic_type:     listener.exitBasic_type(n);     break;
+  case AslAst::Statements:     listener.exitStatements(n);     break;
+  case AslAst::AssignStmt:     listener.exitAssignStmt(n);     break;
+  case AslAst::Return:         listener.exitReturn(n);         break;
+  case AslAst::WhileStmt:      listener.exitWhileStmt(n);      break;
+  case AslAst::IfStmt:         listener.exitIfStmt(n);         break;
+  case AslAst::ProcCall:       listener.exitProcCall(n);       break;
+  case AslAst::ReadStmt:       listener.exitReadStmt(n);       break;
+  case AslAst::WriteExpr:      listener.exitWriteExpr(n);      break;
+  case AslAst::WriteString:    listener.exitWriteString(n);    break;
+  case AslAst::Left_expr:      listener.exitLeft_expr(n);      break;
+  case AslAst::Par:            listener.exitPar(n);            break;
+  case AslAst::Array_read:     listener.exitArray_read(n);     break;
+  case AslAst::Return_func:    listener.exitReturn_func(n);    break;
+  case AslAst::Notplusminus:   listener.exitNotplusminus(n);   break;
+  case AslAst::Arithmetic:     listener.exitArithmetic(n);     break;
+  case AslAst::Relational:     listener.exitRelational(n);     break;
+  case AslAst::Logic:          listener.exitLogic(n);          break;
+  case AslAst::Value:          listener.exitValue(n);          break;
+  case AslAst::ExprIdent:      listener.exitExprIdent(n);      break;
+  case AslAst::Ident:          listener.exitIdent(n);          break;
+  default: break;
+  }
+}
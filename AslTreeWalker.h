@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    AslTreeWalker - Walks the AslAst calling the methods
+//               of a listener
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "AslAst.h"
+#include "AslAstListener.h"
+
+
+//////////////////////////////////////////////////////////////////////
+// Class AslTreeWalker: calls the methods of an AslAstListener on the
+// nodes of a subtree of the AslAst, in the same order as antlr4's
+// ParseTreeWalker does on the parse tree. The nodes are stored in
+// preorder, so the walk is a loop over the range of the subtree that
+// keeps the nodes entered and not exited yet in a vector: it does not
+// recurse, and the left recursive expr rule, that makes a chain
+// a+b+c+... a tree as deep as its number of operands, uses no stack.
+
+class AslTreeWalker {
+
+public:
+
+  // Walk the subtree of 'root', calling the methods of 'listener'
+  void walk(AslAstListener & listener, const AslAst & ast,
+            AslAst::NodeId root) const;
+
+private:
+
+  // Call the enter and the exit method of the kind of node 'n'
+  void enter(AslAstListener & listener, const AslAst & ast, AslAst::NodeId n) const;
+  void exit(AslAstListener & listener, const AslAst & ast, AslAst::NodeId n) const;
+
+};  // class AslTreeWalker
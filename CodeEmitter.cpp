@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CodeEmitter - Writes the generated code function by
+//           function, as soon as each one is complete
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "CodeEmitter.h"
+
+#include "../common/code.h"
+#include "IrCode.h"
+#include "CompileStats.h"
+
+#include <chrono>
+
+
+// Constructor
+CodeEmitter::CodeEmitter(std::ostream & out, std::size_t bufferSize,
+                         CompileStats * stats) :
+  Out(out),
+  BufferSize{bufferSize},
+  NumSubroutines{0},
+  NumBytes{0},
+  Stats{stats},
+  DumpSeconds{0.0},
+  DumpBytes{0},
+  DumpAllocations{0} {
+  Buffer.reserve(BufferSize);
+}
+
+CodeEmitter::~CodeEmitter() {
+  flush();
+}
+
+void CodeEmitter::emit(const subroutine & subr) {
+  std::string text = subr.dump();
+  ++NumSubroutines;
+  NumBytes += text.size();
+  if (Buffer.size() + text.size() > BufferSize) {
+    flush();
+    // a subroutine larger than the buffer goes straight to the output
+    if (text.size() > BufferSize) {
+      Out << text;
+      return;
+    }
+  }
+  Buffer += text;
+}
+
+void CodeEmitter::emit(const IrFunction & fn) {
+  if (not Stats) {
+    emit(fn.toSubroutine());
+    return;
+  }
+  Stats->addSubroutine(fn.name(), fn.instructions().size(), fn.numTemps(),
+                       fn.numTempsCreated());
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint64_t bytes = CompileStats::allocatedBytes();
+  uint64_t allocations = CompileStats::numAllocations();
+  emit(fn.toSubroutine());
+  DumpSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                               start).count();
+  DumpBytes += CompileStats::allocatedBytes() - bytes;
+  DumpAllocations += CompileStats::numAllocations() - allocations;
+}
+
+void CodeEmitter::flush() {
+  if (not Buffer.empty()) {
+    Out.write(Buffer.data(), Buffer.size());
+    Buffer.clear();
+  }
+}
+
+std::size_t CodeEmitter::numSubroutines() const {
+  return NumSubroutines;
+}
+
+std::size_t CodeEmitter::numBytes() const {
+  return NumBytes;
+}
+
+double CodeEmitter::dumpSeconds() const {
+  return DumpSeconds;
+}
+
+uint64_t CodeEmitter::dumpBytes() const {
+  return DumpBytes;
+}
+
+uint64_t CodeEmitter::dumpAllocations() const {
+  return DumpAllocations;
+}
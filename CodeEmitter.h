@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CodeEmitter - Writes the generated code function by
+//           function, as soon as each one is complete
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../common/code.h"
+#include "IrCode.h"
+#include "CompileStats.h"
+
+#include <string>
+#include <ostream>
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint64_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class CodeEmitter: the sink of the generated code. The code
+// generator hands it each subroutine when its function is complete,
+// and the emitter writes its text to a buffer that is flushed to the
+// output stream when it is full. So the program is never kept whole
+// in memory, neither as subroutines nor as one big string.
+
+class CodeEmitter {
+
+public:
+
+  // Constructor: the code is written to 'out'. If 'stats' is given,
+  // every subroutine is recorded there and its conversion to text is
+  // timed
+  CodeEmitter(std::ostream & out, std::size_t bufferSize = 64 * 1024,
+              CompileStats * stats = nullptr);
+  // Destructor: flushes what is left
+  ~CodeEmitter();
+
+  CodeEmitter(const CodeEmitter &) = delete;
+  CodeEmitter & operator=(const CodeEmitter &) = delete;
+
+  // Write a complete subroutine
+  void emit(const subroutine & subr);
+  // Write the subroutine of a complete function
+  void emit(const IrFunction & fn);
+  // Write the buffer to the output stream
+  void flush();
+
+  // Number of subroutines and of bytes written
+  std::size_t numSubroutines() const;
+  std::size_t numBytes() const;
+  // Time and allocations spent converting the functions to text
+  // (only measured with a CompileStats)
+  double      dumpSeconds() const;
+  uint64_t    dumpBytes() const;
+  uint64_t    dumpAllocations() const;
+
+private:
+
+  // Attributes
+  std::ostream & Out;
+  std::string    Buffer;
+  std::size_t    BufferSize;
+  std::size_t    NumSubroutines;
+  std::size_t    NumBytes;
+  CompileStats * Stats;
+  double         DumpSeconds;
+  uint64_t       DumpBytes;
+  uint64_t       DumpAllocations;
+
+};  // class CodeEmitter
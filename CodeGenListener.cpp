@@ -1,6 +1,6 @@
 //////////////////////////////////////////////////////////////////////
 //
-//    CodeGenListener - Walk the parser tree to do
+//    CodeGenListener - Walk the AST to do
 //                             the generation of code
 //
 //    Copyright (C) 2018  Universitat Politecnica de Catalunya
@@ -29,14 +29,18 @@
 
 #include "CodeGenListener.h"
 
-#include "antlr4-runtime.h"
+#include "AslParser.h"
 
 #include "../common/TypesMgr.h"
-#include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
+#include "NodeDecorations.h"
+#include "IrCode.h"
+#include "CodeEmitter.h"
+#include "IrOptimizer.h"
+#include "DeadCodeEliminator.h"
 #include "../common/code.h"
 
 #include <cstddef>    // std::size_t
+#include <utility>    // std::move
 
 // uncomment the following line to enable debugging messages with DEBUG*
 // #define DEBUG_BUILD
@@ -44,67 +48,71 @@
 
 // using namespace std;
 
+// Array assignments: the arrays of up to CopyUnrollMax elements are
+// copied by a straight line of code, and the larger ones by a loop
+// that copies CopyLoopStep elements per iteration
+static const std::size_t CopyUnrollMax = 16;
+static const std::size_t CopyLoopStep  = 4;
+
 
 // Constructor
-CodeGenListener::CodeGenListener(TypesMgr       & Types,
-				 SymTable       & Symbols,
-				 TreeDecoration & Decorations,
-				 code           & Code) :
+CodeGenListener::CodeGenListener(TypesMgr        & Types,
+				 NodeDecorations & Decorations,
+				 CodeEmitter     & Emitter,
+				 const IrOptimizer & Optimizer,
+				 LogicEval         Logic,
+				 const AslAst    & Ast) :
   Types{Types},
-  Symbols{Symbols},
   Decorations{Decorations},
-  Code{Code} {
+  Emitter{Emitter},
+  Optimizer{Optimizer},
+  Logic{Logic},
+  Ast{Ast},
+  FirstVarSlot{0} {
 }
 
-void CodeGenListener::enterProgram(AslParser::ProgramContext *ctx) {
+void CodeGenListener::enterProgram(AslAst::NodeId n) {
   DEBUG_ENTER();
-  SymTable::ScopeId sc = getScopeDecor(ctx);
-  Symbols.pushThisScope(sc);
 }
-void CodeGenListener::exitProgram(AslParser::ProgramContext *ctx) {
-  Symbols.popScope();
+void CodeGenListener::exitProgram(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterFunction(AslParser::FunctionContext *ctx) {
+void CodeGenListener::enterFunction(AslAst::NodeId n) {
   DEBUG_ENTER();
-  subroutine subr(ctx->ID()->getText());
-  Code.add_subroutine(subr);
+  Fn.reset(Ast.name(n));
   //Aqui estem modificant els parametres per en cas de que retorni alguna cosa, afegeix la variable _result
-  subroutine & subrRef = Code.get_last_subroutine();
-  if(ctx->return_type()) subrRef.add_param("_result");
-
-  SymTable::ScopeId sc = getScopeDecor(ctx);
-  Symbols.pushThisScope(sc);
-  codeCounters.reset();
+  ResultVar = IrOperand();
+  if(Ast.findChild(n, AslAst::Return_type) != AslAst::NoNode) ResultVar = Fn.addParam("_result");
+  // the slots of the symbols follow the result parameter
+  FirstVarSlot = Fn.numVars();
 }
-void CodeGenListener::exitFunction(AslParser::FunctionContext *ctx) {
-  subroutine & subrRef = Code.get_last_subroutine();
-  instructionList code = getCodeDecor(ctx->statements());
-  code = code || instruction::RETURN();
-  subrRef.set_instructions(code);
-
-  Symbols.popScope();
+void CodeGenListener::exitFunction(AslAst::NodeId n) {
+  IrList & code = Fn.instructions();
+  code.splice(code.end(), getCodeDecor(Ast.findChild(n, AslAst::Statements)));
+  code.push_back(IrInstr::RETURN());
+  Optimizer.run(Fn);
+  // the function is converted to text once, when it is complete, and
+  // written out: its code and the attributes of its nodes are dropped
+  Emitter.emit(Fn);
+  code.clear();
+  Decorations.release(n, Ast.node(n).end);
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterDeclarations(AslParser::DeclarationsContext *ctx) {
+void CodeGenListener::enterDeclarations(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitDeclarations(AslParser::DeclarationsContext *ctx) {
+void CodeGenListener::exitDeclarations(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterParameter_decl(AslParser::Parameter_declContext *ctx){
+void CodeGenListener::enterParameter_decl(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitParameter_decl(AslParser::Parameter_declContext *ctx){
-   subroutine       & subrRef = Code.get_last_subroutine();
-   for(auto ipdObj: ctx->pdObj()){
-     //TypesMgr::TypeId        t1 = getTypeDecor(ipdObj->type());
-     //std::size_t           size = Types.getSizeOfType(t1);
-    // subrRef.add_var(ipdObj->ID()->getText(), size);           //add_var ha de fer algo pero amb parametres
-     subrRef.add_param(ipdObj->ID()->getText());
+void CodeGenListener::exitParameter_decl(AslAst::NodeId n){
+   for(std::size_t i = 0; i < Ast.node(n).numChildren; ++i){
+     Fn.addParam(Ast.name(Ast.child(n, i)));
    }
 
     DEBUG_EXIT();
@@ -114,56 +122,56 @@ void CodeGenListener::exitParameter_decl(AslParser::Parameter_declContext *ctx){
 
 
 
-void CodeGenListener::enterVariable_decl(AslParser::Variable_declContext *ctx) {
+void CodeGenListener::enterVariable_decl(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitVariable_decl(AslParser::Variable_declContext *ctx) {
-  for(auto i : ctx->ID()) {
-    subroutine       & subrRef = Code.get_last_subroutine();
-    TypesMgr::TypeId        t1 = getTypeDecor(ctx->type());
+void CodeGenListener::exitVariable_decl(AslAst::NodeId n) {
+  for(std::size_t i = 0; i < Ast.node(n).numNames; ++i) {
+    TypesMgr::TypeId        t1 = getTypeDecor(Ast.child(n, 0));
     std::size_t           size = Types.getSizeOfType(t1);
-    subrRef.add_var(i->getText(), size);
+    Fn.addVar(Ast.name(n, i), size);
   }
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterType(AslParser::TypeContext *ctx) {
+void CodeGenListener::enterType(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitType(AslParser::TypeContext *ctx) {
+void CodeGenListener::exitType(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterStatements(AslParser::StatementsContext *ctx) {
+void CodeGenListener::enterStatements(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitStatements(AslParser::StatementsContext *ctx) {
-  instructionList code;
-  for (auto stCtx : ctx->statement()) {
-    code = code || getCodeDecor(stCtx);
+void CodeGenListener::exitStatements(AslAst::NodeId n) {
+  IrList code;
+  for (std::size_t i = 0; i < Ast.node(n).numChildren; ++i) {
+    code.splice(code.end(), getCodeDecor(Ast.child(n, i)));
   }
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterAssignStmt(AslParser::AssignStmtContext *ctx) {
+void CodeGenListener::enterAssignStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitAssignStmt(AslParser::AssignStmtContext *ctx) {
-  instructionList  code;
-
-  TypesMgr::TypeId tid1 = getTypeDecor(ctx->left_expr());
-  std::string     addr1 = getAddrDecor(ctx->left_expr());
-  instructionList code1 = getCodeDecor(ctx->left_expr());
-  std::string resultat;
-
-  TypesMgr::TypeId tid2 = getTypeDecor(ctx->expr());
-  std::string     addr2 = getAddrDecor(ctx->expr());
-  instructionList code2 = getCodeDecor(ctx->expr());
-  code = code1 || code2;
+void CodeGenListener::exitAssignStmt(AslAst::NodeId n) {
+  IrList  code;
+
+  TypesMgr::TypeId tid1 = getTypeDecor(Ast.child(n, 0));
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList code1 = getCodeDecor(Ast.child(n, 0));
+  IrOperand resultat;
+
+  TypesMgr::TypeId tid2 = getTypeDecor(Ast.child(n, 1));
+  IrOperand     addr2 = getAddrDecor(Ast.child(n, 1));
+  IrList code2 = getCodeDecor(Ast.child(n, 1));
+  code.splice(code.end(), code1);
+  code.splice(code.end(), code2);
   if(Types.isFloatTy(tid1) and Types.isIntegerTy(tid2)){
-        std::string temp = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(temp, addr2);
+        IrOperand temp = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(temp, addr2));
         resultat = temp;
 
   }
@@ -174,842 +182,925 @@ void CodeGenListener::exitAssignStmt(AslParser::AssignStmtContext *ctx) {
 
   //AQUI resultat ja te el valor a escriure
 
-  if(ctx->left_expr()->expr()){                         //IS ARRAY
-    std::string     addrA = getAddrDecor(ctx->left_expr());
-    std::string     offsA = getOffsetDecor(ctx->left_expr());
-    code = code  || instruction::XLOAD(addrA, offsA, resultat);
+  if(Ast.node(Ast.child(n, 0)).numChildren > 1){                         //IS ARRAY
+    IrOperand     addrA = getAddrDecor(Ast.child(n, 0));
+    IrOperand     offsA = getOffsetDecor(Ast.child(n, 0));
+    code.push_back(IrInstr::XLOAD(addrA, offsA, resultat));
   }
   else{
     if(Types.isArrayTy(tid1) and Types.isArrayTy(tid2)){
-      std::string       label = codeCounters.newLabelWHILE();
-      std::string labelEndWhile = "endwhile"+label;
-      std::string labelWhile = "while" + label;
-      std::string     adA = addr1;
-      std::string     adB = addr2;
-
-      std::string index = "%"+codeCounters.newTEMP();
-      std::string offset = "%"+codeCounters.newTEMP();
-      std::string midaA = "%"+codeCounters.newTEMP();
-      //si es vol fer el de float a int i ocupen diferent shauria de canviar aixo fent dos offset!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-      code = code || instruction::LOAD(index, "0"); //i = 0
-
-      code = code || instruction::LOAD(midaA, "1");       // AQUI DETETRMINEM LA MIDA DE LES POSIS DEL ARRAY
-
-      code = code || instruction::LABEL(labelWhile);
-
-      std::size_t numParametres = Types.getArraySize(tid1);     //TOT AIXO ES PEL TAMANY DELS VECTORS
-      int nP = static_cast<int>(numParametres);                 //amb un ja fem perque son de la mateixa mida
-      std::string strSizeA =  std::to_string(nP);               //
-      std::string sizeA = "%"+codeCounters.newTEMP();           //
-      code = code || instruction::LOAD(sizeA, strSizeA);        //
-
-      std::string condicio = "%"+codeCounters.newTEMP();
-      code = code || instruction::LT(condicio, index, sizeA);   // condicio = i < A.size()
-      code = code || instruction::FJUMP(condicio, labelEndWhile); // Salta si i >= A.size()
-
-      code = code || instruction::MUL(offset, index, midaA);  //[i]
-
-
-      //Si es
-      std::string tAux = "%"+codeCounters.newTEMP();
-      if(not Symbols.isLocalVarClass(adB)){                                  //B ESTA PER REFERENCIA
-        std::string contingutB = "%"+codeCounters.newTEMP();
-        code = code || instruction::LOAD(contingutB, adB);
-        code = code || instruction::LOADX(tAux, contingutB,offset);
-      }
-      else{
-        code = code || instruction::LOADX(tAux, adB,offset);
-      }
-
-      if(not Symbols.isLocalVarClass(adA)){                                  //B ESTA PER REFERENCIA
-        std::string contingutA = "%"+codeCounters.newTEMP();
-        code = code || instruction::LOAD(contingutA, adA);
-        code = code || instruction::XLOAD(contingutA, offset, tAux);
-      }
-      else{
-        code = code || instruction::XLOAD(adA, offset, tAux);
-      }
-
-
-
-      std::string masUno = "%"+codeCounters.newTEMP();
-
-      code = code || instruction::LOAD(masUno, "1") || instruction::ADD(index, index, masUno) || instruction::UJUMP(labelWhile) || instruction::LABEL(labelEndWhile);
-
+      code.splice(code.end(), copyArray(addr1, addr2, Types.getArraySize(tid1)));
     }
     else{
-      code = code ||  instruction::LOAD(addr1, resultat);                                                               //NO ES ASSIGNACIO DE ARRAYS
+      code.push_back(IrInstr::LOAD(addr1, resultat));                                                               //NO ES ASSIGNACIO DE ARRAYS
     }
   }
 
 
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterArray_read(AslParser::Array_readContext *ctx){
+void CodeGenListener::enterArray_read(AslAst::NodeId n){
   DEBUG_ENTER();
 }
 
-void CodeGenListener::exitArray_read(AslParser::Array_readContext * ctx){
-  if(Symbols.isLocalVarClass(ctx->ident()->getText())){
-    instructionList code;
-    std::string addrA = getAddrDecor(ctx->ident());
-    instructionList codeE = getCodeDecor(ctx->expr());
-    std::string addrE = getAddrDecor(ctx->expr());
+void CodeGenListener::exitArray_read(AslAst::NodeId n){
+  if(getSymbolDecor(Ast.child(n, 0)).isLocalVar()){
+    IrList code;
+    IrOperand addrA = getAddrDecor(Ast.child(n, 0));
+    IrList codeE = getCodeDecor(Ast.child(n, 1));
+    IrOperand addrE = getAddrDecor(Ast.child(n, 1));
 
-    std::string temp = "%"+codeCounters.newTEMP();
-    code = codeE || instruction::LOAD(temp, "1");
-    code = code || instruction::MUL(temp, addrE, temp);
+    IrOperand temp = Fn.newTemp();
+    code.splice(code.end(), codeE);
+    code.push_back(IrInstr::LOAD(temp, IrOperand::imm(1)));
+    code.push_back(IrInstr::MUL(temp, addrE, temp));
 
-    code = code || instruction::LOADX(temp, addrA, temp);
+    code.push_back(IrInstr::LOADX(temp, addrA, temp));
 
-    putCodeDecor(ctx, code);
-    putAddrDecor(ctx, temp);
-    putOffsetDecor(ctx, "");
+    putCodeDecor(n, std::move(code));
+    putAddrDecor(n, temp);
+    putOffsetDecor(n, IrOperand());
   }
   else{
-    instructionList code;
-    std::string tempRef = "%"+codeCounters.newTEMP();
+    IrList code;
+    IrOperand tempRef = Fn.newTemp();
 
-    std::string addrA = getAddrDecor(ctx->ident());
-    code = code || instruction::LOAD(tempRef, addrA);
+    IrOperand addrA = getAddrDecor(Ast.child(n, 0));
+    code.push_back(IrInstr::LOAD(tempRef, addrA));
 
-    instructionList codeE = getCodeDecor(ctx->expr());
-    std::string addrE = getAddrDecor(ctx->expr());
+    IrList codeE = getCodeDecor(Ast.child(n, 1));
+    IrOperand addrE = getAddrDecor(Ast.child(n, 1));
 
-    std::string temp = "%"+codeCounters.newTEMP();
-    code = code || codeE || instruction::LOAD(temp, "1");
-    code = code || instruction::MUL(temp, addrE, temp);
+    IrOperand temp = Fn.newTemp();
+    code.splice(code.end(), codeE);
+    code.push_back(IrInstr::LOAD(temp, IrOperand::imm(1)));
+    code.push_back(IrInstr::MUL(temp, addrE, temp));
 
-    code = code || instruction::LOADX(temp, tempRef, temp);
-    putCodeDecor(ctx, code);
-    putAddrDecor(ctx, temp);
-    putOffsetDecor(ctx, "");
+    code.push_back(IrInstr::LOADX(temp, tempRef, temp));
+    putCodeDecor(n, std::move(code));
+    putAddrDecor(n, temp);
+    putOffsetDecor(n, IrOperand());
   }
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterIfStmt(AslParser::IfStmtContext *ctx) {
+void CodeGenListener::enterIfStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitIfStmt(AslParser::IfStmtContext *ctx) {
-  instructionList   code;
-  std::string      addr1 = getAddrDecor(ctx->expr());
-  instructionList  code1 = getCodeDecor(ctx->expr());
-  instructionList  code2 = getCodeDecor(ctx->statements(0));
-
-  std::string      label2 = codeCounters.newLabelIF();
-  std::string      label3 = "else"+label2;
-  std::string labelEndIf = "endif"+label2;
-  if(ctx->ELSE()){
-    instructionList  code3 = getCodeDecor(ctx->statements(1));
-    code = code1 || instruction::FJUMP(addr1, label3) ||
-         code2 || instruction::UJUMP(labelEndIf) || instruction::LABEL(label3)        ||
-         code3 || instruction::LABEL(labelEndIf);
+void CodeGenListener::exitIfStmt(AslAst::NodeId n) {
+  IrList   code;
+  IrOperand      addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList  code1 = getCodeDecor(Ast.child(n, 0));
+  IrList  code2 = getCodeDecor(Ast.child(n, 1));
+
+  IrOperand      label3 = Fn.newLabel("else");
+  IrOperand  labelEndIf = Fn.newLabel("endif");
+  bool negated = false;
+  addr1 = branchCondition(code1, addr1, negated);
+  if(negated){
+    // FJUMP jumps when the condition (not addr1) holds: the then
+    // part goes to the jump target
+    IrList code3;
+    if(Ast.node(n).numChildren > 2) code3 = getCodeDecor(Ast.child(n, 2));
+    code.splice(code.end(), code1);
+    code.push_back(IrInstr::FJUMP(addr1, label3));
+    code.splice(code.end(), code3);
+    code.push_back(IrInstr::UJUMP(labelEndIf));
+    code.push_back(IrInstr::LABEL(label3));
+    code.splice(code.end(), code2);
+    code.push_back(IrInstr::LABEL(labelEndIf));
+  }
+  else if(Ast.node(n).numChildren > 2){
+    IrList  code3 = getCodeDecor(Ast.child(n, 2));
+    code.splice(code.end(), code1);
+    code.push_back(IrInstr::FJUMP(addr1, label3));
+    code.splice(code.end(), code2);
+    code.push_back(IrInstr::UJUMP(labelEndIf));
+    code.push_back(IrInstr::LABEL(label3));
+    code.splice(code.end(), code3);
+    code.push_back(IrInstr::LABEL(labelEndIf));
   }
   else{
-    code = code1 || instruction::FJUMP(addr1, labelEndIf) ||
-         code2 || instruction::LABEL(labelEndIf);
+    code.splice(code.end(), code1);
+    code.push_back(IrInstr::FJUMP(addr1, labelEndIf));
+    code.splice(code.end(), code2);
+    code.push_back(IrInstr::LABEL(labelEndIf));
   }
 
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterWhileStmt(AslParser::WhileStmtContext *ctx){
+void CodeGenListener::enterWhileStmt(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitWhileStmt(AslParser::WhileStmtContext *ctx){
-  instructionList   code;
-  std::string       addr1 = getAddrDecor(ctx->expr());
-  instructionList   code1 = getCodeDecor(ctx->expr());
-  instructionList   code2 = getCodeDecor(ctx->statements());
-  std::string       label = codeCounters.newLabelWHILE();
-  std::string labelEndWhile = "endwhile"+label;
-  std::string labelWhile = "while" + label;
-  code = instruction::LABEL(labelWhile) || code1 || instruction::FJUMP(addr1, labelEndWhile) ||
-        code2  || instruction::UJUMP(labelWhile) || instruction::LABEL(labelEndWhile);
-  putCodeDecor(ctx, code);
+void CodeGenListener::exitWhileStmt(AslAst::NodeId n){
+  IrList   code;
+  IrOperand       addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList   code1 = getCodeDecor(Ast.child(n, 0));
+  IrList   code2 = getCodeDecor(Ast.child(n, 1));
+  IrOperand    labelWhile = Fn.newLabel("while");
+  IrOperand labelEndWhile = Fn.newLabel("endwhile");
+  bool negated = false;
+  addr1 = branchCondition(code1, addr1, negated);
+  if(negated or negateComparison(code1, addr1)){
+    // The test goes after the body, and FJUMP on the negation of the
+    // condition jumps back while it holds: each iteration runs the
+    // condition and one jump
+    IrOperand labelTest = Fn.newLabel("whiletest");
+    code.push_back(IrInstr::UJUMP(labelTest));
+    code.push_back(IrInstr::LABEL(labelWhile));
+    code.splice(code.end(), code2);
+    code.push_back(IrInstr::LABEL(labelTest));
+    code.splice(code.end(), code1);
+    code.push_back(IrInstr::FJUMP(addr1, labelWhile));
+    code.push_back(IrInstr::LABEL(labelEndWhile));
+    putCodeDecor(n, std::move(code));
+    DEBUG_EXIT();
+    return;
+  }
+  code.push_back(IrInstr::LABEL(labelWhile));
+  code.splice(code.end(), code1);
+  code.push_back(IrInstr::FJUMP(addr1, labelEndWhile));
+  code.splice(code.end(), code2);
+  code.push_back(IrInstr::UJUMP(labelWhile));
+  code.push_back(IrInstr::LABEL(labelEndWhile));
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterProcCall(AslParser::ProcCallContext *ctx) {
+void CodeGenListener::enterProcCall(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitProcCall(AslParser::ProcCallContext *ctx) {
-  instructionList code;
+void CodeGenListener::exitProcCall(AslAst::NodeId n) {
+  IrList code;
   int i = 0;
-  for(auto p : ctx->expr()){
-    code = code || getCodeDecor(p);
-    std::vector<TypesMgr::TypeId> vecTy = Types.getFuncParamsTypes(getTypeDecor(ctx->ident()));
+  for(std::size_t k = 1; k < Ast.node(n).numChildren; ++k){
+    AslAst::NodeId p = Ast.child(n, k);
+    code.splice(code.end(), getCodeDecor(p));
+    std::vector<TypesMgr::TypeId> vecTy = Types.getFuncParamsTypes(getTypeDecor(Ast.child(n, 0)));
     if(Types.isIntegerTy(getTypeDecor(p)) and Types.isFloatTy(vecTy[i])){
-      std::string tempF = "%"+codeCounters.newTEMP();
-      std::string addrE = getAddrDecor(p);
-      code = code || instruction::FLOAT(tempF,addrE);
+      IrOperand tempF = Fn.newTemp();
+      IrOperand addrE = getAddrDecor(p);
+      code.push_back(IrInstr::FLOAT(tempF,addrE));
       putAddrDecor(p, tempF);
     }
     else if(Types.isArrayTy(getTypeDecor(p))){
-      std::string tempA = "%"+codeCounters.newTEMP();
-      std::string addrE = getAddrDecor(p);
-      code = code || instruction::ALOAD(tempA, addrE);
+      IrOperand tempA = Fn.newTemp();
+      IrOperand addrE = getAddrDecor(p);
+      code.push_back(IrInstr::ALOAD(tempA, addrE));
       putAddrDecor(p, tempA);
     }
     i++;
   }
-  code = code || instruction::PUSH();
-  for(auto p : ctx->expr()){
-    code = code || instruction::PUSH(getAddrDecor(p));
-  }
-  // std::string name = ctx->ident()->ID()->getSymbol()->getText();
-  std::string name = ctx->ident()->getText();
-  code = code || instruction::CALL(name);
-  //for(auto p : ctx->expr()){
-  //  code = code || instruction::POP();
-  //}
-  for(uint i=0; i<ctx->expr().size(); i++){
-    code = code || instruction::POP();
-  }
-  code = code || instruction::POP();    //pop del parametre de retorn
-  putCodeDecor(ctx, code);
+  code.push_back(IrInstr::PUSH());
+  for(std::size_t k = 1; k < Ast.node(n).numChildren; ++k){
+    AslAst::NodeId p = Ast.child(n, k);
+    code.push_back(IrInstr::PUSH(getAddrDecor(p)));
+  }
+  code.push_back(IrInstr::CALL(Fn.constant(Ast.name(Ast.child(n, 0)))));
+  for(uint i=0; i<Ast.node(n).numChildren - 1; i++){
+    code.push_back(IrInstr::POP());
+  }
+  code.push_back(IrInstr::POP());    //pop del parametre de retorn
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
 
-void CodeGenListener::enterReturn_func(AslParser::Return_funcContext *ctx){
+void CodeGenListener::enterReturn_func(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitReturn_func(AslParser::Return_funcContext *ctx){
-  instructionList code;
+void CodeGenListener::exitReturn_func(AslAst::NodeId n){
+  IrList code;
   int i = 0;
-  for(auto p : ctx->expr()){
-    code = code || getCodeDecor(p);
-    std::vector<TypesMgr::TypeId> vecTy = Types.getFuncParamsTypes(getTypeDecor(ctx->ident()));
+  for(std::size_t k = 1; k < Ast.node(n).numChildren; ++k){
+    AslAst::NodeId p = Ast.child(n, k);
+    code.splice(code.end(), getCodeDecor(p));
+    std::vector<TypesMgr::TypeId> vecTy = Types.getFuncParamsTypes(getTypeDecor(Ast.child(n, 0)));
     if(Types.isIntegerTy(getTypeDecor(p)) and Types.isFloatTy(vecTy[i])){
-      std::string tempF = "%"+codeCounters.newTEMP();
-      std::string addrE = getAddrDecor(p);
-      code = code || instruction::FLOAT(tempF,addrE);
+      IrOperand tempF = Fn.newTemp();
+      IrOperand addrE = getAddrDecor(p);
+      code.push_back(IrInstr::FLOAT(tempF,addrE));
       putAddrDecor(p, tempF);
     }
      else if(Types.isArrayTy(getTypeDecor(p))){
-      std::string tempA = "%"+codeCounters.newTEMP();
-      std::string addrE = getAddrDecor(p);
-      code = code || instruction::ALOAD(tempA, addrE);
+      IrOperand tempA = Fn.newTemp();
+      IrOperand addrE = getAddrDecor(p);
+      code.push_back(IrInstr::ALOAD(tempA, addrE));
       putAddrDecor(p, tempA);
     }
     i++;
   }
-  code = code || instruction::PUSH();
-  for(auto p : ctx->expr()){
-    code = code || instruction::PUSH(getAddrDecor(p));
-  }
-  // std::string name = ctx->ident()->ID()->getSymbol()->getText();
-  std::string name = ctx->ident()->getText();
-  code = code || instruction::CALL(name);
-  //for(auto p : ctx->expr()){
-  //  code = code || instruction::POP();
-  //}
-  for(uint i=0; i < ctx->expr().size(); i++){
-      code = code || instruction::POP();
-  }
-  std::string temp = "%"+codeCounters.newTEMP();
-  code = code || instruction::POP(temp);        //pop que omple la variable que retorna
-  putCodeDecor(ctx, code);
-  putAddrDecor(ctx,temp);
+  code.push_back(IrInstr::PUSH());
+  for(std::size_t k = 1; k < Ast.node(n).numChildren; ++k){
+    AslAst::NodeId p = Ast.child(n, k);
+    code.push_back(IrInstr::PUSH(getAddrDecor(p)));
+  }
+  code.push_back(IrInstr::CALL(Fn.constant(Ast.name(Ast.child(n, 0)))));
+  for(uint i=0; i < Ast.node(n).numChildren - 1; i++){
+      code.push_back(IrInstr::POP());
+  }
+  IrOperand temp = Fn.newTemp();
+  code.push_back(IrInstr::POP(temp));        //pop que omple la variable que retorna
+  putCodeDecor(n, std::move(code));
+  putAddrDecor(n,temp);
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterReturn(AslParser::ReturnContext *ctx){
+void CodeGenListener::enterReturn(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitReturn(AslParser::ReturnContext * ctx){
-  instructionList code;
-  std::string       addr1 = getAddrDecor(ctx->expr());
-  std::string temp;
-  if(ctx->expr()){
-    code = getCodeDecor(ctx->expr());
-    subroutine       & subrRef = Code.get_last_subroutine();
-    temp = (subrRef.params.begin()) -> name;
-    code = code || instruction::LOAD(temp, addr1) || instruction::RETURN();
-  }
-  putCodeDecor(ctx,code);
-  putOffsetDecor(ctx,"");
-  putAddrDecor(ctx,temp);
+void CodeGenListener::exitReturn(AslAst::NodeId n){
+  IrList code;
+  IrOperand temp;
+  if(Ast.node(n).numChildren > 0){
+    IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+    code = getCodeDecor(Ast.child(n, 0));
+    temp = ResultVar;
+    code.push_back(IrInstr::LOAD(temp, addr1));
+    code.push_back(IrInstr::RETURN());
+  }
+  putCodeDecor(n, std::move(code));
+  putOffsetDecor(n, IrOperand());
+  putAddrDecor(n,temp);
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterReadStmt(AslParser::ReadStmtContext *ctx) {
+void CodeGenListener::enterReadStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitReadStmt(AslParser::ReadStmtContext *ctx) {
-  instructionList  code;
-  std::string     addrA = getAddrDecor(ctx->left_expr());
-  if(ctx->left_expr()->expr()){     //Is Array
-    std::string     offsA = getOffsetDecor(ctx->left_expr());
-    instructionList code1 = getCodeDecor(ctx->left_expr());
-
-    std::string     addrE = getAddrDecor(ctx->left_expr()->expr());
-    instructionList code2 = getCodeDecor(ctx->left_expr()->expr());
-
-    code = code1 || code2;
-    std::string temp = "%"+codeCounters.newTEMP();
-    TypesMgr::TypeId tid1 = getTypeDecor(ctx->left_expr());
+void CodeGenListener::exitReadStmt(AslAst::NodeId n) {
+  IrList  code;
+  IrOperand     addrA = getAddrDecor(Ast.child(n, 0));
+  if(Ast.node(Ast.child(n, 0)).numChildren > 1){     //Is Array
+    IrOperand     offsA = getOffsetDecor(Ast.child(n, 0));
+    // the code of the left_expr already includes the evaluation of the index
+    code = getCodeDecor(Ast.child(n, 0));
+    IrOperand temp = Fn.newTemp();
+    TypesMgr::TypeId tid1 = getTypeDecor(Ast.child(n, 0));
     if(Types.isFloatTy(tid1)){
-      code = code || instruction::READF(temp);
+      code.push_back(IrInstr::READF(temp));
     }
     else if(Types.isCharacterTy(tid1)){
-      code = code || instruction::READC(temp);
+      code.push_back(IrInstr::READC(temp));
     }
     else {
-      code = code || instruction::READI(temp);
+      code.push_back(IrInstr::READI(temp));
     }
 
-    code = code || instruction::XLOAD(addrA, offsA, temp);
+    code.push_back(IrInstr::XLOAD(addrA, offsA, temp));
 
   }
   else{
-    TypesMgr::TypeId tid1 = getTypeDecor(ctx->left_expr());
+    TypesMgr::TypeId tid1 = getTypeDecor(Ast.child(n, 0));
     if(Types.isFloatTy(tid1)){
-      code = code || instruction::READF(addrA);
+      code.push_back(IrInstr::READF(addrA));
     }
     else if(Types.isCharacterTy(tid1)){
-      code = code || instruction::READC(addrA);
+      code.push_back(IrInstr::READC(addrA));
     }
     else {
-      code = code || instruction::READI(addrA);
+      code.push_back(IrInstr::READI(addrA));
     }
   }
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterWriteExpr(AslParser::WriteExprContext *ctx) {
+void CodeGenListener::enterWriteExpr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitWriteExpr(AslParser::WriteExprContext *ctx) {
-  instructionList code = getCodeDecor(ctx->expr());
-  std::string     addr1 = getAddrDecor(ctx->expr());
-  TypesMgr::TypeId tid1 = getTypeDecor(ctx->expr());
+void CodeGenListener::exitWriteExpr(AslAst::NodeId n) {
+  IrList code = getCodeDecor(Ast.child(n, 0));
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  TypesMgr::TypeId tid1 = getTypeDecor(Ast.child(n, 0));
 
   if(Types.isFloatTy(tid1))
-    code = code || instruction::WRITEF(addr1);
+    code.push_back(IrInstr::WRITEF(addr1));
   else if(Types.isCharacterTy(tid1)){
-    code = code || instruction::WRITEC(addr1);
+    code.push_back(IrInstr::WRITEC(addr1));
 
     /*
     std::string s = ctx->expr()->getText();
-    std::string temp = "%"+codeCounters.newTEMP();
+    IrOperand temp = Fn.newTemp();
     if (Symbols.findInCurrentScope(s)) {      //ident
-	    code = code || instruction::LOAD(temp, addr1) || instruction::WRITEC(temp);
+	    code.push_back(IrInstr::LOAD(temp, addr1));
+	    code.push_back(IrInstr::WRITEC(temp));
 	  }
     else {
-      code = code || instruction::WRITEC(addr1);
+      code.push_back(IrInstr::WRITEC(addr1));
     }
     */
   }
   else {  //INT or BOOL
-    code = code || instruction::WRITEI(addr1);
+    code.push_back(IrInstr::WRITEI(addr1));
   }
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterWriteString(AslParser::WriteStringContext *ctx) {
+void CodeGenListener::enterWriteString(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitWriteString(AslParser::WriteStringContext *ctx) {
-  instructionList code;
-  std::string s = ctx->STRING()->getText();
-  std::string temp = "%"+codeCounters.newTEMP();
+void CodeGenListener::exitWriteString(AslAst::NodeId n) {
+  IrList code;
+  const std::string & s = Ast.name(n);
+  IrOperand temp = Fn.newTemp();
   int i = 1;
   while (i < int(s.size())-1) {
     if (s[i] != '\\') {
-      code = code ||
-	     instruction::CHLOAD(temp, s.substr(i,1)) ||
-	     instruction::WRITEC(temp);
+      code.push_back(IrInstr::CHLOAD(temp, Fn.constant(s.substr(i,1))));
+      code.push_back(IrInstr::WRITEC(temp));
       i += 1;
     }
     else {
       assert(i < int(s.size())-2);
       if (s[i+1] == 'n') {
-        code = code || instruction::WRITELN();
+        code.push_back(IrInstr::WRITELN());
         i += 2;
       }
       else if (s[i+1] == 't' or s[i+1] == '"' or s[i+1] == '\\') {
-        code = code ||
-               instruction::CHLOAD(temp, s.substr(i,2)) ||
-	       instruction::WRITEC(temp);
+        code.push_back(IrInstr::CHLOAD(temp, Fn.constant(s.substr(i,2))));
+        code.push_back(IrInstr::WRITEC(temp));
         i += 2;
       }
       else {
-        code = code ||
-               instruction::CHLOAD(temp, s.substr(i,1)) ||
-	       instruction::WRITEC(temp);
+        code.push_back(IrInstr::CHLOAD(temp, Fn.constant(s.substr(i,1))));
+        code.push_back(IrInstr::WRITEC(temp));
         i += 1;
       }
     }
   }
-  putCodeDecor(ctx, code);
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
+void CodeGenListener::enterLeft_expr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
-  if(ctx->expr()) { //Is Array
-    if(Symbols.isLocalVarClass(ctx->ident()->getText())){
-      instructionList code;
-      code = code || getCodeDecor(ctx->expr());
-      std::string  addrExp = getAddrDecor(ctx->expr());
-      std::string temp = "%"+codeCounters.newTEMP();
-
-      code = code || instruction::LOAD(temp, "1");
-
-      code = code || instruction::MUL(temp, addrExp, temp);
-      putOffsetDecor(ctx, temp);
-      putCodeDecor(ctx, code);
-      putAddrDecor(ctx, getAddrDecor(ctx->ident()));        //IDENT ARRAY
+void CodeGenListener::exitLeft_expr(AslAst::NodeId n) {
+  if(Ast.node(n).numChildren > 1) { //Is Array
+    if(getSymbolDecor(Ast.child(n, 0)).isLocalVar()){
+      IrList code;
+      code.splice(code.end(), getCodeDecor(Ast.child(n, 1)));
+      IrOperand  addrExp = getAddrDecor(Ast.child(n, 1));
+      IrOperand temp = Fn.newTemp();
+
+      code.push_back(IrInstr::LOAD(temp, IrOperand::imm(1)));
+
+      code.push_back(IrInstr::MUL(temp, addrExp, temp));
+      putOffsetDecor(n, temp);
+      putCodeDecor(n, std::move(code));
+      putAddrDecor(n, getAddrDecor(Ast.child(n, 0)));        //IDENT ARRAY
     }
     else {
-      instructionList code;
-      std::string tempRef = "%"+codeCounters.newTEMP();
-      code = code || instruction::LOAD(tempRef,getAddrDecor(ctx->ident()));
-      code = code || getCodeDecor(ctx->expr());
-      std::string  addrExp = getAddrDecor(ctx->expr());
-      std::string temp = "%"+codeCounters.newTEMP();
-
-      code = code || instruction::LOAD(temp, "1");
-
-      code = code || instruction::MUL(temp, addrExp, temp);
-      putOffsetDecor(ctx, temp);
-      putCodeDecor(ctx, code);
-      putAddrDecor(ctx, tempRef);                           //INDICA EL NOM DE LA VARIABLE QUE FA REFERENCIA AL ARRAY
+      IrList code;
+      IrOperand tempRef = Fn.newTemp();
+      code.push_back(IrInstr::LOAD(tempRef,getAddrDecor(Ast.child(n, 0))));
+      code.splice(code.end(), getCodeDecor(Ast.child(n, 1)));
+      IrOperand  addrExp = getAddrDecor(Ast.child(n, 1));
+      IrOperand temp = Fn.newTemp();
+
+      code.push_back(IrInstr::LOAD(temp, IrOperand::imm(1)));
+
+      code.push_back(IrInstr::MUL(temp, addrExp, temp));
+      putOffsetDecor(n, temp);
+      putCodeDecor(n, std::move(code));
+      putAddrDecor(n, tempRef);                           //INDICA EL NOM DE LA VARIABLE QUE FA REFERENCIA AL ARRAY
     }
 
   }
   else{
-    putAddrDecor(ctx, getAddrDecor(ctx->ident()));
-    putOffsetDecor(ctx, getOffsetDecor(ctx->ident()));
-    putCodeDecor(ctx, getCodeDecor(ctx->ident()));
+    putAddrDecor(n, getAddrDecor(Ast.child(n, 0)));
+    putOffsetDecor(n, getOffsetDecor(Ast.child(n, 0)));
+    putCodeDecor(n, getCodeDecor(Ast.child(n, 0)));
   }
 
   DEBUG_ENTER();
 }
 
-void CodeGenListener::enterPar(AslParser::ParContext *ctx){
+void CodeGenListener::enterPar(AslAst::NodeId n){
   DEBUG_ENTER();
 }
 
-void CodeGenListener::exitPar(AslParser::ParContext *ctx){
-  putAddrDecor(ctx, getAddrDecor(ctx->expr()));
-  putOffsetDecor(ctx, "");//getOffsetDecor(ctx->expr()));
-  putCodeDecor(ctx, getCodeDecor(ctx->expr()));
+void CodeGenListener::exitPar(AslAst::NodeId n){
+  putAddrDecor(n, getAddrDecor(Ast.child(n, 0)));
+  putOffsetDecor(n, IrOperand());//getOffsetDecor(Ast.child(n, 0)));
+  putCodeDecor(n, getCodeDecor(Ast.child(n, 0)));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterArithmetic(AslParser::ArithmeticContext *ctx) {
+void CodeGenListener::enterArithmetic(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitArithmetic(AslParser::ArithmeticContext *ctx) {
-  std::string     addr1 = getAddrDecor(ctx->expr(0));
-  instructionList code1 = getCodeDecor(ctx->expr(0));
-  std::string     addr2 = getAddrDecor(ctx->expr(1));
-  instructionList code2 = getCodeDecor(ctx->expr(1));
-  instructionList code  = code1 || code2;
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  TypesMgr::TypeId t  = getTypeDecor(ctx);
-  std::string temp;
-  if (ctx->MUL()){
+void CodeGenListener::exitArithmetic(AslAst::NodeId n) {
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList code1 = getCodeDecor(Ast.child(n, 0));
+  IrOperand     addr2 = getAddrDecor(Ast.child(n, 1));
+  IrList code2 = getCodeDecor(Ast.child(n, 1));
+  IrList code;
+  code.splice(code.end(), code1);
+  code.splice(code.end(), code2);
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  TypesMgr::TypeId t  = getTypeDecor(n);
+  IrOperand temp;
+  if (Ast.node(n).op == AslParser::MUL){
     if(Types.isFloatTy(t)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FMUL(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FMUL(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::MUL(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::MUL(temp, addr1, addr2));
     }
   }
-  else if(ctx->DIV()){
+  else if(Ast.node(n).op == AslParser::DIV){
     if(Types.isFloatTy(t)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
 
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FDIV(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FDIV(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::DIV(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::DIV(temp, addr1, addr2));
     }
   }
-  else if(ctx->MOD()){
-    std::string tempAux = "%"+codeCounters.newTEMP();
-    code = code || instruction::DIV(tempAux, addr1, addr2) || instruction::MUL(tempAux, tempAux, addr2) || instruction::SUB(tempAux, addr1, tempAux);
+  else if(Ast.node(n).op == AslParser::MOD){
+    IrOperand tempAux = Fn.newTemp();
+    code.push_back(IrInstr::DIV(tempAux, addr1, addr2));
+    code.push_back(IrInstr::MUL(tempAux, tempAux, addr2));
+    code.push_back(IrInstr::SUB(tempAux, addr1, tempAux));
     temp = tempAux;
-    //code = code || instruction::
+    //code = code || IrInstr::
   }
-  else if(ctx->PLUS()){
+  else if(Ast.node(n).op == AslParser::PLUS){
     if(Types.isFloatTy(t)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
      if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FADD(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FADD(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::ADD(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::ADD(temp, addr1, addr2));
     }
   }
-  else if(ctx->MINUS()){
+  else if(Ast.node(n).op == AslParser::MINUS){
     if(Types.isFloatTy(t)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FSUB(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FSUB(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::SUB(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::SUB(temp, addr1, addr2));
     }
   }
-  putAddrDecor(ctx, temp);
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, code);
+  putAddrDecor(n, temp);
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterLogic(AslParser::LogicContext *ctx){
+void CodeGenListener::enterLogic(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitLogic(AslParser::LogicContext *ctx){
-  std::string     addr1 = getAddrDecor(ctx->expr(0));
-  instructionList code1 = getCodeDecor(ctx->expr(0));
-  std::string     addr2 = getAddrDecor(ctx->expr(1));
-  instructionList code2 = getCodeDecor(ctx->expr(1));
-  instructionList code  = code1 || code2;
-
-  // TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  // TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  // TypesMgr::TypeId t  = getTypeDecor(ctx);
-  std::string temp = "%"+codeCounters.newTEMP();
-  if (ctx->AND()){
-    code = code || instruction::AND(temp, addr1, addr2);
-  }
-  else if(ctx->OR()){
-    code = code || instruction::OR(temp, addr1, addr2);
-  }
-  putAddrDecor(ctx, temp);
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, code);
+void CodeGenListener::exitLogic(AslAst::NodeId n){
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList code1 = getCodeDecor(Ast.child(n, 0));
+  IrOperand     addr2 = getAddrDecor(Ast.child(n, 1));
+  IrList code2 = getCodeDecor(Ast.child(n, 1));
+  IrList code;
+  code.splice(code.end(), code1);
+
+  // The right operand is skipped when the left one decides the
+  // result: if it has code to skip, and it is pure or the language
+  // mode allows to skip calls too
+  bool lazy = false;
+  if (Logic != LogicEval::Strict and not code2.empty()) {
+    lazy = true;
+    if (Logic == LogicEval::ShortPure)
+      for (const IrInstr & instr : code2)
+        if (not DeadCodeEliminator::isPure(instr)) {
+          lazy = false;
+          break;
+        }
+  }
+  if (lazy) {
+    // temp = addr1; if temp decides the result goto end; temp = addr2
+    // (FJUMP only jumps on false, so for 'or' the test is on not temp)
+    IrOperand temp = addr1.isTemp() ? addr1 : Fn.newTemp();
+    IrOperand labelEnd = Fn.newLabel(Ast.node(n).op == AslParser::AND ? "endand" : "endor");
+    if (temp != addr1)
+      code.push_back(IrInstr::LOAD(temp, addr1));
+    if (Ast.node(n).op == AslParser::AND)
+      code.push_back(IrInstr::FJUMP(temp, labelEnd));
+    else {
+      IrOperand temp1 = Fn.newTemp();
+      code.push_back(IrInstr::NOT(temp1, temp));
+      code.push_back(IrInstr::FJUMP(temp1, labelEnd));
+    }
+    code.splice(code.end(), code2);
+    code.push_back(IrInstr::LOAD(temp, addr2));
+    code.push_back(IrInstr::LABEL(labelEnd));
+    putAddrDecor(n, temp);
+    putOffsetDecor(n, IrOperand());
+    putCodeDecor(n, std::move(code));
+    DEBUG_EXIT();
+    return;
+  }
+  code.splice(code.end(), code2);
+
+  // TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  // TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  // TypesMgr::TypeId t  = getTypeDecor(n);
+  IrOperand temp = Fn.newTemp();
+  if (Ast.node(n).op == AslParser::AND){
+    code.push_back(IrInstr::AND(temp, addr1, addr2));
+  }
+  else if(Ast.node(n).op == AslParser::OR){
+    code.push_back(IrInstr::OR(temp, addr1, addr2));
+  }
+  putAddrDecor(n, temp);
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterNotplusminus(AslParser::NotplusminusContext *ctx){
+void CodeGenListener::enterNotplusminus(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void CodeGenListener::exitNotplusminus(AslParser::NotplusminusContext *ctx){
-  std::string     addr1 = getAddrDecor(ctx->expr());
-  instructionList code1 = getCodeDecor(ctx->expr());
-  instructionList code  = code1;
-  std::string temp = "%"+codeCounters.newTEMP();
-  if(ctx->NOT()){
-    code = code || instruction::NOT(temp, addr1);
+void CodeGenListener::exitNotplusminus(AslAst::NodeId n){
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList code1 = getCodeDecor(Ast.child(n, 0));
+  IrList code;
+  code.splice(code.end(), code1);
+  IrOperand temp = Fn.newTemp();
+  if(Ast.node(n).op == AslParser::NOT){
+    code.push_back(IrInstr::NOT(temp, addr1));
   }
-  else if(ctx->PLUS()){
+  else if(Ast.node(n).op == AslParser::PLUS){
     code = code;
   }
-  else if(ctx->MINUS()){
-    TypesMgr::TypeId t = getTypeDecor(ctx->expr());
+  else if(Ast.node(n).op == AslParser::MINUS){
+    TypesMgr::TypeId t = getTypeDecor(Ast.child(n, 0));
     if(Types.isFloatTy(t)){
-      code = code || instruction::FNEG(temp, addr1);
+      code.push_back(IrInstr::FNEG(temp, addr1));
     }
-    else code = code || instruction::NEG(temp, addr1);
+    else code.push_back(IrInstr::NEG(temp, addr1));
   }
-  putAddrDecor(ctx, temp);
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, code);
+  putAddrDecor(n, temp);
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
 
-void CodeGenListener::enterRelational(AslParser::RelationalContext *ctx) {
+void CodeGenListener::enterRelational(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitRelational(AslParser::RelationalContext *ctx) {
-  std::string     addr1 = getAddrDecor(ctx->expr(0));
-  instructionList code1 = getCodeDecor(ctx->expr(0));
-  std::string     addr2 = getAddrDecor(ctx->expr(1));
-  instructionList code2 = getCodeDecor(ctx->expr(1));
-  instructionList code  = code1 || code2;
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  //TypesMgr:: TypeId t  = getTypeDecor(ctx);
-  std::string temp;
-
-  if(ctx->EQUAL()){
+void CodeGenListener::exitRelational(AslAst::NodeId n) {
+  IrOperand     addr1 = getAddrDecor(Ast.child(n, 0));
+  IrList code1 = getCodeDecor(Ast.child(n, 0));
+  IrOperand     addr2 = getAddrDecor(Ast.child(n, 1));
+  IrList code2 = getCodeDecor(Ast.child(n, 1));
+  IrList code;
+  code.splice(code.end(), code1);
+  code.splice(code.end(), code2);
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  //TypesMgr:: TypeId t  = getTypeDecor(n);
+  IrOperand temp;
+
+  if(Ast.node(n).op == AslParser::EQUAL){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FEQ(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FEQ(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::EQ(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::EQ(temp, addr1, addr2));
     }
   }
-  else if(ctx->NE()){
+  else if(Ast.node(n).op == AslParser::NE){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FEQ(temp, ftemp1, ftemp2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FEQ(temp, ftemp1, ftemp2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::EQ(temp, addr1, addr2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::EQ(temp, addr1, addr2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
 
   }
-  else if(ctx->GT()){
+  else if(Ast.node(n).op == AslParser::GT){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FLE(temp, ftemp1, ftemp2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FLE(temp, ftemp1, ftemp2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::LE(temp, addr1, addr2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::LE(temp, addr1, addr2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
 
   }
-  else if(ctx->GE()){
+  else if(Ast.node(n).op == AslParser::GE){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FLT(temp, ftemp1, ftemp2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FLT(temp, ftemp1, ftemp2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::LT(temp, addr1, addr2);
-      code = code || instruction::NOT(temp,temp);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::LT(temp, addr1, addr2));
+      code.push_back(IrInstr::NOT(temp,temp));
     }
 
 
   }
-  else if(ctx->LE()){
+  else if(Ast.node(n).op == AslParser::LE){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
      if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FLE(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FLE(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::LE(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::LE(temp, addr1, addr2));
     }
 
   }
-  else if(ctx->LT()){
+  else if(Ast.node(n).op == AslParser::LT){
     if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-      std::string ftemp1 = addr1;
-      std::string ftemp2 = addr2;
+      IrOperand ftemp1 = addr1;
+      IrOperand ftemp2 = addr2;
       if(not Types.isFloatTy(t1)){
-        ftemp1 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp1, addr1);
+        ftemp1 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp1, addr1));
       }
       if(not Types.isFloatTy(t2)){
-        ftemp2 = "%"+codeCounters.newTEMP();
-        code = code || instruction::FLOAT(ftemp2, addr2);
+        ftemp2 = Fn.newTemp();
+        code.push_back(IrInstr::FLOAT(ftemp2, addr2));
       }
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::FLT(temp, ftemp1, ftemp2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::FLT(temp, ftemp1, ftemp2));
     }
     else {
-      temp = "%"+codeCounters.newTEMP();
-      code = code || instruction::LT(temp, addr1, addr2);
+      temp = Fn.newTemp();
+      code.push_back(IrInstr::LT(temp, addr1, addr2));
     }
   }
 
-  putAddrDecor(ctx, temp);
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, code);
+  putAddrDecor(n, temp);
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterValue(AslParser::ValueContext *ctx) {
+void CodeGenListener::enterValue(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitValue(AslParser::ValueContext *ctx) {
-  instructionList code;
-  std::string temp = "%"+codeCounters.newTEMP();
-  TypesMgr::TypeId t1 = getTypeDecor(ctx);
+void CodeGenListener::exitValue(AslAst::NodeId n) {
+  IrList code;
+  IrOperand temp = Fn.newTemp();
+  TypesMgr::TypeId t1 = getTypeDecor(n);
   if(Types.isIntegerTy(t1)){
-    code = instruction::ILOAD(temp, ctx->getText());
+    code.push_back(IrInstr::ILOAD(temp, Fn.constant(Ast.name(n))));
   }
   else if(Types.isFloatTy(t1)){
-    code = instruction::FLOAD(temp, ctx->getText());
+    code.push_back(IrInstr::FLOAD(temp, Fn.constant(Ast.name(n))));
   }
   else if(Types.isCharacterTy(t1)){
-    std::string sAux = ctx->getText();
-    sAux = sAux.substr(1, sAux.size()-2);
-    code = instruction::CHLOAD(temp,sAux);
+    const std::string & sAux = Ast.name(n);
+    code.push_back(IrInstr::CHLOAD(temp, Fn.constant(sAux.substr(1, sAux.size()-2))));
   }
   else if(Types.isBooleanTy(t1)){
-    std::string boolVal = ctx->getText();
-    if(boolVal == "true") boolVal = "1";
-    else boolVal = "0";
-
-    code = instruction::LOAD(temp,boolVal);
+    code.push_back(IrInstr::LOAD(temp, IrOperand::imm(Ast.name(n) == "true" ? 1 : 0)));
   }
-  putAddrDecor(ctx, temp);
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, code);
+  putAddrDecor(n, temp);
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, std::move(code));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterExprIdent(AslParser::ExprIdentContext *ctx) {
+void CodeGenListener::enterExprIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitExprIdent(AslParser::ExprIdentContext *ctx) {
-  putAddrDecor(ctx, getAddrDecor(ctx->ident()));
-  putOffsetDecor(ctx, getOffsetDecor(ctx->ident()));
-  putCodeDecor(ctx, getCodeDecor(ctx->ident()));
+void CodeGenListener::exitExprIdent(AslAst::NodeId n) {
+  putAddrDecor(n, getAddrDecor(Ast.child(n, 0)));
+  putOffsetDecor(n, getOffsetDecor(Ast.child(n, 0)));
+  putCodeDecor(n, getCodeDecor(Ast.child(n, 0)));
   DEBUG_EXIT();
 }
 
-void CodeGenListener::enterIdent(AslParser::IdentContext *ctx) {
+void CodeGenListener::enterIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void CodeGenListener::exitIdent(AslParser::IdentContext *ctx) {
-  putAddrDecor(ctx, ctx->ID()->getText());
-  putOffsetDecor(ctx, "");
-  putCodeDecor(ctx, instructionList());
+void CodeGenListener::exitIdent(AslAst::NodeId n) {
+  // the variable of the identifier (none for the name of a function)
+  SymbolHandle sym = getSymbolDecor(n);
+  if (sym.isFunction())
+    putAddrDecor(n, IrOperand());
+  else
+    putAddrDecor(n, IrOperand(IrOperand::VAR, FirstVarSlot + sym.slot));
+  putOffsetDecor(n, IrOperand());
+  putCodeDecor(n, IrList());
   DEBUG_EXIT();
 }
 
-// void CodeGenListener::enterEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_ENTER();
-// }
-// void CodeGenListener::exitEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_EXIT();
-// }
-// void CodeGenListener::visitTerminal(antlr4::tree::TerminalNode *node) {
-//   DEBUG(">>> visit " << node->getSymbol()->getLine() << ":" << node->getSymbol()->getCharPositionInLine() << " CodeGen TerminalNode");
-// }
-// void CodeGenListener::visitErrorNode(antlr4::tree::ErrorNode *node) {
-// }
-
-
 // Getters for the necessary tree node atributes:
-//   Scope, Type, Addr, Offset and Code
-SymTable::ScopeId CodeGenListener::getScopeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getScope(ctx);
+//   Type, Symbol, Addr, Offset and Code
+TypesMgr::TypeId CodeGenListener::getTypeDecor(AslAst::NodeId n) {
+  return Decorations.getType(n);
+}
+SymbolHandle CodeGenListener::getSymbolDecor(AslAst::NodeId n) {
+  return Decorations.getSymbol(n);
 }
-TypesMgr::TypeId CodeGenListener::getTypeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getType(ctx);
+IrOperand CodeGenListener::getAddrDecor(AslAst::NodeId n) {
+  return Decorations.getAddr(n);
+}
+IrOperand CodeGenListener::getOffsetDecor(AslAst::NodeId n) {
+  return Decorations.getOffset(n);
+}
+IrOperand CodeGenListener::branchCondition(IrList & code, IrOperand cond, bool & negated) {
+  while (not code.empty() and code.back().op == IrOp::NOT and
+         code.back().arg[0] == cond) {
+    cond = code.back().arg[1];
+    code.pop_back();
+    negated = not negated;
+  }
+  return cond;
 }
-std::string CodeGenListener::getAddrDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getAddr(ctx);
+
+bool CodeGenListener::negateComparison(IrList & code, IrOperand cond) {
+  if (code.empty() or code.back().arg[0] != cond)
+    return false;
+  IrInstr & cmp = code.back();
+  // not (a < b) is b <= a, and not (a <= b) is b < a
+  if (cmp.op == IrOp::LT)
+    cmp = IrInstr::LE(cmp.arg[0], cmp.arg[2], cmp.arg[1]);
+  else if (cmp.op == IrOp::LE)
+    cmp = IrInstr::LT(cmp.arg[0], cmp.arg[2], cmp.arg[1]);
+  else
+    return false;
+  return true;
 }
-std::string  CodeGenListener::getOffsetDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getOffset(ctx);
+
+IrList CodeGenListener::copyArray(IrOperand dst, IrOperand src, std::size_t size) {
+  IrList code;
+  // a parameter holds the address of the array
+  IrOperand addrA = dst, addrB = src;
+  if (Fn.isParam(dst)) {
+    addrA = Fn.newTemp();
+    code.push_back(IrInstr::LOAD(addrA, dst));
+  }
+  if (Fn.isParam(src)) {
+    addrB = Fn.newTemp();
+    code.push_back(IrInstr::LOAD(addrB, src));
+  }
+  // the elements that do not fill an iteration of the loop go first
+  std::size_t unrolled = size <= CopyUnrollMax ? size : size % CopyLoopStep;
+  for (std::size_t k = 0; k < unrolled; ++k) {
+    IrOperand index = Fn.newTemp();
+    IrOperand elem = Fn.newTemp();
+    code.push_back(IrInstr::LOAD(index, IrOperand::imm(static_cast<int32_t>(k))));
+    code.push_back(IrInstr::LOADX(elem, addrB, index));
+    code.push_back(IrInstr::XLOAD(addrA, index, elem));
+  }
+  if (unrolled == size)
+    return code;
+
+  // the loop runs at least once, so it is tested at its end
+  IrOperand labelCopy = Fn.newLabel("copy");
+  IrOperand index = Fn.newTemp();
+  IrOperand one = Fn.newTemp();
+  IrOperand last = Fn.newTemp();
+  IrOperand elem = Fn.newTemp();
+  IrOperand done = Fn.newTemp();
+  code.push_back(IrInstr::LOAD(index, IrOperand::imm(static_cast<int32_t>(unrolled))));
+  code.push_back(IrInstr::LOAD(one, IrOperand::imm(1)));
+  code.push_back(IrInstr::LOAD(last, IrOperand::imm(static_cast<int32_t>(size - 1))));
+  code.push_back(IrInstr::LABEL(labelCopy));
+  for (std::size_t k = 0; k < CopyLoopStep; ++k) {
+    if (k > 0)
+      code.push_back(IrInstr::ADD(index, index, one));
+    code.push_back(IrInstr::LOADX(elem, addrB, index));
+    code.push_back(IrInstr::XLOAD(addrA, index, elem));
+  }
+  code.push_back(IrInstr::LE(done, last, index));
+  code.push_back(IrInstr::ADD(index, index, one));
+  code.push_back(IrInstr::FJUMP(done, labelCopy));
+  return code;
 }
-instructionList CodeGenListener::getCodeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getCode(ctx);
+
+IrList CodeGenListener::getCodeDecor(AslAst::NodeId n) {
+  // The code of a node is consumed exactly once by its parent, so it is
+  // moved out instead of copied
+  return Decorations.takeCode(n);
 }
 
 // Setters for the necessary tree node attributes:
 //   Addr, Offset and Code
-void CodeGenListener::putAddrDecor(antlr4::ParserRuleContext *ctx, const std::string & a) {
-  Decorations.putAddr(ctx, a);
+void CodeGenListener::putAddrDecor(AslAst::NodeId n, IrOperand a) {
+  Decorations.putAddr(n, a);
 }
-void CodeGenListener::putOffsetDecor(antlr4::ParserRuleContext *ctx, const std::string & o) {
-  Decorations.putOffset(ctx, o);
+void CodeGenListener::putOffsetDecor(AslAst::NodeId n, IrOperand o) {
+  Decorations.putOffset(n, o);
 }
-void CodeGenListener::putCodeDecor(antlr4::ParserRuleContext *ctx, const instructionList & c) {
-  Decorations.putCode(ctx, c);
+void CodeGenListener::putCodeDecor(AslAst::NodeId n, IrList && c) {
+  Decorations.putCode(n, std::move(c));
 }
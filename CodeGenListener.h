@@ -1,6 +1,6 @@
 //////////////////////////////////////////////////////////////////////
 //
-//    CodeGenListener - Walk the parser tree to do
+//    CodeGenListener - Walk the AST to do
 //                      the generation of code
 //
 //    Copyright (C) 2018  Universitat Politecnica de Catalunya
@@ -29,13 +29,14 @@
 
 #pragma once
 
-#include "antlr4-runtime.h"
-#include "AslBaseListener.h"
+#include "AslAstListener.h"
+#include "AslAst.h"
 
 #include "../common/TypesMgr.h"
-#include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/code.h"
+#include "NodeDecorations.h"
+#include "IrCode.h"
+#include "CodeEmitter.h"
+#include "IrOptimizer.h"
 
 #include <string>
 
@@ -43,129 +44,154 @@
 
 
 //////////////////////////////////////////////////////////////////////
-// Class CodeGenListener: derived from AslBaseListener.
-// The tree walker go through the parser tree and call the methods of
+// Class CodeGenListener: derived from AslAstListener.
+// The tree walker go through the AST and call the methods of
 // this listener to generate the code of the program. This is done
 // once the SymbolsListener and TypeCheckListener have finish with no
 // semantic error. So all the symbols of the program has been added to
 // their respective scope and the type of each expresion has also be
-// computed and decorate the parse tree. If an enter/exit method does
+// computed and decorate the AST. If an enter/exit method does
 // not have an associated task, it does not have to be redefined.
+// The code of a function only depends on its subtree, its decorations
+// and the types, which are only read: so a listener can also be run
+// on the subtree of a single function, and several of them at once.
 
-class  CodeGenListener : public AslBaseListener {
+class  CodeGenListener : public AslAstListener {
 
 public:
 
-  // Constructor
-  CodeGenListener(TypesMgr       & Types,
-		  SymTable       & Symbols,
-		  TreeDecoration & TreeNodeProps,
-		  code           & Code);
+  // How the operators 'and' and 'or' evaluate their right operand:
+  // always (Strict), only when the left one does not decide the
+  // result if the right one has no side effects (ShortPure), or only
+  // when the left one does not decide the result (ShortCircuit)
+  enum class LogicEval { Strict, ShortPure, ShortCircuit };
 
-  void enterProgram(AslParser::ProgramContext *ctx);
-  void exitProgram(AslParser::ProgramContext *ctx);
+  // Constructor
+  CodeGenListener(TypesMgr        & Types,
+		  NodeDecorations & TreeNodeProps,
+		  CodeEmitter     & Emitter,
+		  const IrOptimizer & Optimizer,
+		  LogicEval         Logic,
+		  const AslAst    & Ast);
 
-  void enterFunction(AslParser::FunctionContext *ctx);
-  void exitFunction(AslParser::FunctionContext *ctx);
+  void enterProgram(AslAst::NodeId n);
+  void exitProgram(AslAst::NodeId n);
 
-  void enterDeclarations(AslParser::DeclarationsContext *ctx);
-  void exitDeclarations(AslParser::DeclarationsContext *ctx);
+  void enterFunction(AslAst::NodeId n);
+  void exitFunction(AslAst::NodeId n);
 
-  void enterParameter_decl(AslParser::Parameter_declContext *ctx);
-  void exitParameter_decl(AslParser::Parameter_declContext *ctx);
+  void enterDeclarations(AslAst::NodeId n);
+  void exitDeclarations(AslAst::NodeId n);
 
-  void enterVariable_decl(AslParser::Variable_declContext *ctx);
-  void exitVariable_decl(AslParser::Variable_declContext *ctx);
+  void enterParameter_decl(AslAst::NodeId n);
+  void exitParameter_decl(AslAst::NodeId n);
 
-  void enterType(AslParser::TypeContext *ctx);
-  void exitType(AslParser::TypeContext *ctx);
+  void enterVariable_decl(AslAst::NodeId n);
+  void exitVariable_decl(AslAst::NodeId n);
 
-  void enterPar(AslParser::ParContext *ctx);
-  void exitPar(AslParser::ParContext *ctx);
+  void enterType(AslAst::NodeId n);
+  void exitType(AslAst::NodeId n);
 
-  void enterLogic(AslParser::LogicContext *ctx);
-  void exitLogic(AslParser::LogicContext *ctx);
+  void enterPar(AslAst::NodeId n);
+  void exitPar(AslAst::NodeId n);
 
-  void enterNotplusminus(AslParser::NotplusminusContext *ctx);
-  void exitNotplusminus(AslParser::NotplusminusContext *ctx);
+  void enterLogic(AslAst::NodeId n);
+  void exitLogic(AslAst::NodeId n);
 
-  void enterStatements(AslParser::StatementsContext *ctx);
-  void exitStatements(AslParser::StatementsContext *ctx);
+  void enterNotplusminus(AslAst::NodeId n);
+  void exitNotplusminus(AslAst::NodeId n);
 
-  void enterAssignStmt(AslParser::AssignStmtContext *ctx);
-  void exitAssignStmt(AslParser::AssignStmtContext *ctx);
+  void enterStatements(AslAst::NodeId n);
+  void exitStatements(AslAst::NodeId n);
 
-  void enterIfStmt(AslParser::IfStmtContext *ctx);
-  void exitIfStmt(AslParser::IfStmtContext *ctx);
+  void enterAssignStmt(AslAst::NodeId n);
+  void exitAssignStmt(AslAst::NodeId n);
 
-  void enterWhileStmt(AslParser::WhileStmtContext *ctx);
-  void exitWhileStmt(AslParser::WhileStmtContext *ctx);
+  void enterIfStmt(AslAst::NodeId n);
+  void exitIfStmt(AslAst::NodeId n);
 
-  void enterProcCall(AslParser::ProcCallContext *ctx);
-  void exitProcCall(AslParser::ProcCallContext *ctx);
+  void enterWhileStmt(AslAst::NodeId n);
+  void exitWhileStmt(AslAst::NodeId n);
 
-  void enterReturn(AslParser::ReturnContext *ctx);
-  void exitReturn(AslParser::ReturnContext * ctx);
+  void enterProcCall(AslAst::NodeId n);
+  void exitProcCall(AslAst::NodeId n);
 
-  void enterReturn_func(AslParser::Return_funcContext *ctx);
-  void exitReturn_func(AslParser::Return_funcContext *ctx);
+  void enterReturn(AslAst::NodeId n);
+  void exitReturn(AslAst::NodeId n);
 
-  void enterReadStmt(AslParser::ReadStmtContext *ctx);
-  void exitReadStmt(AslParser::ReadStmtContext *ctx);
+  void enterReturn_func(AslAst::NodeId n);
+  void exitReturn_func(AslAst::NodeId n);
 
-  void enterWriteExpr(AslParser::WriteExprContext *ctx);
-  void exitWriteExpr(AslParser::WriteExprContext *ctx);
+  void enterReadStmt(AslAst::NodeId n);
+  void exitReadStmt(AslAst::NodeId n);
 
-  void enterWriteString(AslParser::WriteStringContext *ctx);
-  void exitWriteString(AslParser::WriteStringContext *ctx);
+  void enterWriteExpr(AslAst::NodeId n);
+  void exitWriteExpr(AslAst::NodeId n);
 
-  void enterLeft_expr(AslParser::Left_exprContext *ctx);
-  void exitLeft_expr(AslParser::Left_exprContext *ctx);
+  void enterWriteString(AslAst::NodeId n);
+  void exitWriteString(AslAst::NodeId n);
 
-  void enterArray_read(AslParser::Array_readContext *ctx);
-  void exitArray_read(AslParser::Array_readContext * ctx);
+  void enterLeft_expr(AslAst::NodeId n);
+  void exitLeft_expr(AslAst::NodeId n);
 
-  void enterArithmetic(AslParser::ArithmeticContext *ctx);
-  void exitArithmetic(AslParser::ArithmeticContext *ctx);
+  void enterArray_read(AslAst::NodeId n);
+  void exitArray_read(AslAst::NodeId n);
 
-  void enterRelational(AslParser::RelationalContext *ctx);
-  void exitRelational(AslParser::RelationalContext *ctx);
+  void enterArithmetic(AslAst::NodeId n);
+  void exitArithmetic(AslAst::NodeId n);
 
-  void enterValue(AslParser::ValueContext *ctx);
-  void exitValue(AslParser::ValueContext *ctx);
+  void enterRelational(AslAst::NodeId n);
+  void exitRelational(AslAst::NodeId n);
 
-  void enterExprIdent(AslParser::ExprIdentContext *ctx);
-  void exitExprIdent(AslParser::ExprIdentContext *ctx);
+  void enterValue(AslAst::NodeId n);
+  void exitValue(AslAst::NodeId n);
 
-  void enterIdent(AslParser::IdentContext *ctx);
-  void exitIdent(AslParser::IdentContext *ctx);
+  void enterExprIdent(AslAst::NodeId n);
+  void exitExprIdent(AslAst::NodeId n);
 
-  // void enterEveryRule(antlr4::ParserRuleContext *ctx);
-  // void exitEveryRule(antlr4::ParserRuleContext *ctx);
-  // void visitTerminal(antlr4::tree::TerminalNode *node);
-  // void visitErrorNode(antlr4::tree::ErrorNode *node);
+  void enterIdent(AslAst::NodeId n);
+  void exitIdent(AslAst::NodeId n);
 
 private:
 
   // Attributes
   TypesMgr        & Types;
-  SymTable        & Symbols;
-  TreeDecoration  & Decorations;
-  code            & Code;
-  counters          codeCounters;
+  NodeDecorations & Decorations;
+  CodeEmitter     & Emitter;
+  const IrOptimizer & Optimizer;
+  LogicEval         Logic;
+  const AslAst    & Ast;
+
+  // Code of the function being generated, and its result parameter
+  IrFunction        Fn;
+  IrOperand         ResultVar;
+  // Slot of the first symbol (parameter or local) of the function
+  uint32_t          FirstVarSlot;
+
+  // Conditions of if and while statements (jumping code): the NOTs
+  // that end the code of a condition are dropped, each one reversing
+  // the sense of the branch ('negated'), and the value to test is
+  // returned. A trailing integer LT or LE that computes 'cond' can
+  // also be turned into its negation (swapping its operands)
+  IrOperand branchCondition(IrList & code, IrOperand cond, bool & negated);
+  bool      negateComparison(IrList & code, IrOperand cond);
+
+  // Code of the assignment of the array 'src' to 'dst' (a local or a
+  // parameter, that holds its address), of 'size' elements
+  IrList    copyArray(IrOperand dst, IrOperand src, std::size_t size);
 
   // Getters for the necessary tree node atributes:
-  //   Scope, Type, Addr, Offset and Code
-  SymTable::ScopeId getScopeDecor  (antlr4::ParserRuleContext *ctx);
-  TypesMgr::TypeId  getTypeDecor   (antlr4::ParserRuleContext *ctx);
-  std::string       getAddrDecor   (antlr4::ParserRuleContext *ctx);
-  std::string       getOffsetDecor (antlr4::ParserRuleContext *ctx);
-  instructionList   getCodeDecor   (antlr4::ParserRuleContext *ctx);
+  //   Type, Symbol, Addr, Offset and Code
+  TypesMgr::TypeId  getTypeDecor   (AslAst::NodeId n);
+  SymbolHandle      getSymbolDecor (AslAst::NodeId n);
+  IrOperand         getAddrDecor   (AslAst::NodeId n);
+  IrOperand         getOffsetDecor (AslAst::NodeId n);
+  IrList            getCodeDecor   (AslAst::NodeId n);
 
   // Setters for the necessary tree node attributes:
   //   Addr, Offset and Code
-  void putAddrDecor   (antlr4::ParserRuleContext *ctx, const std::string & a);
-  void putOffsetDecor (antlr4::ParserRuleContext *ctx, const std::string & o);
-  void putCodeDecor   (antlr4::ParserRuleContext *ctx, const instructionList & c);
+  void putAddrDecor   (AslAst::NodeId n, IrOperand a);
+  void putOffsetDecor (AslAst::NodeId n, IrOperand o);
+  void putCodeDecor   (AslAst::NodeId n, IrList && c);
 
 };
@@ -0,0 +1,325 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileServer - Compile server and client over a
+//                  Unix domain socket
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "CompileServer.h"
+
+#include "Compiler.h"
+#include "MappedCharStream.h"
+
+#include <sstream>    // ostringstream
+#include <vector>
+#include <thread>
+#include <utility>    // std::move
+#include <algorithm>  // std::max
+#include <cstdint>    // uint32_t
+#include <cstring>    // strncpy, strerror
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+#include <unistd.h>   // read, write, close, unlink, pipe
+#include <fcntl.h>    // fcntl
+#include <poll.h>
+#include <pthread.h>  // pthread_sigmask
+#include <arpa/inet.h>  // htonl, ntohl
+#include <sys/socket.h>
+#include <sys/time.h>   // timeval
+#include <sys/un.h>
+
+
+// Largest source accepted in a request, and the time that a client
+// can keep a worker waiting for the next bytes of its source
+static const std::size_t MaxRequestSize = 64 << 20;
+static const int RequestTimeoutSecs = 10;
+
+// Set by the handler of SIGINT and SIGTERM to stop the server. The
+// handler also writes a byte on the pipe, which wakes up the poll() of
+// the accepting thread whenever the signal arrives
+static volatile std::sig_atomic_t StopRequested = 0;
+static int StopPipe[2] = { -1, -1 };
+
+static void requestStop(int) {
+  StopRequested = 1;
+  int saved = errno;
+  char byte = 0;
+  if (::write(StopPipe[1], &byte, 1) < 0) {
+    // the pipe is full: a wake up is already pending
+  }
+  errno = saved;
+}
+
+// Read from 'fd' until the end of file or until more than 'limit'
+// bytes have been read. Returns false on errors and on timeouts
+static bool readAll(int fd, std::string & data, std::size_t limit) {
+  char chunk[1 << 16];
+  while (data.size() <= limit) {
+    ssize_t n = ::read(fd, chunk, sizeof(chunk));
+    if (n == 0)
+      return true;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data.append(chunk, n);
+  }
+  return true;
+}
+
+// Read exactly 'size' bytes from 'fd'. Returns false on errors or EOF
+static bool readExact(int fd, char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t n = ::read(fd, data, size);
+    if (n == 0)
+      return false;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Write the 'size' bytes of 'data' on 'fd' (a socket: a peer that has
+// gone away gives an error, not SIGPIPE). Returns false on errors
+static bool writeAll(int fd, const char *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Write a string preceded by its length (4 bytes, network order)
+static bool writeString(int fd, const std::string & s) {
+  uint32_t len = htonl(static_cast<uint32_t>(s.size()));
+  return writeAll(fd, reinterpret_cast<const char *>(&len), sizeof(len)) and
+         writeAll(fd, s.data(), s.size());
+}
+
+// Read a string preceded by its length (4 bytes, network order)
+static bool readString(int fd, std::string & s) {
+  uint32_t len;
+  if (not readExact(fd, reinterpret_cast<char *>(&len), sizeof(len)))
+    return false;
+  s.resize(ntohl(len));
+  return s.empty() or readExact(fd, &s[0], s.size());
+}
+
+// Fill the address of the Unix domain socket 'path'
+static bool socketAddress(const std::string & path, struct sockaddr_un & addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  return true;
+}
+
+
+// Constructor
+CompileServer::CompileServer(const Compiler::Options & Opts, unsigned int workers) :
+  Opts{Opts},
+  NumWorkers{workers},
+  Stopping{false} {
+  if (NumWorkers == 0)
+    NumWorkers = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool CompileServer::run(const std::string & socketPath, std::ostream & errs) {
+  struct sockaddr_un addr;
+  if (not socketAddress(socketPath, addr)) {
+    errs << "Socket path too long: " << socketPath << std::endl;
+    return false;
+  }
+  int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    errs << "socket: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  ::unlink(socketPath.c_str());   // left behind by a previous server
+  if (::pipe(StopPipe) != 0) {
+    errs << "pipe: " << std::strerror(errno) << std::endl;
+    ::close(listenFd);
+    return false;
+  }
+  ::fcntl(StopPipe[1], F_SETFL, O_NONBLOCK);
+  if (::bind(listenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 or
+      ::listen(listenFd, SOMAXCONN) != 0) {
+    errs << "Can not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+    ::close(listenFd);
+    ::close(StopPipe[0]);
+    ::close(StopPipe[1]);
+    return false;
+  }
+
+  // The workers block SIGINT and SIGTERM (they inherit the mask), so
+  // the signals are handled by this thread. The accepting thread waits
+  // on both the socket and the stop pipe: a signal that arrives just
+  // before the wait still leaves its byte in the pipe.
+  sigset_t stopSignals, oldMask;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stopSignals, &oldMask);
+  std::vector<std::thread> pool;
+  for (unsigned int i = 0; i < NumWorkers; ++i)
+    pool.emplace_back(&CompileServer::worker, this);
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = requestStop;
+  sigemptyset(&action.sa_mask);
+  ::sigaction(SIGINT, &action, nullptr);
+  ::sigaction(SIGTERM, &action, nullptr);
+  pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+
+  errs << "asl: serving on " << socketPath << " with " << NumWorkers << " workers" << std::endl;
+  while (not StopRequested) {
+    struct pollfd fds[2];
+    fds[0].fd = listenFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = StopPipe[0];
+    fds[1].events = POLLIN;
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno != EINTR)
+        errs << "poll: " << std::strerror(errno) << std::endl;
+      continue;
+    }
+    if (fds[1].revents != 0 or not (fds[0].revents & POLLIN))
+      continue;
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno != EINTR)
+        errs << "accept: " << std::strerror(errno) << std::endl;
+      continue;
+    }
+    // a client that stops sending (or reading) does not hold a worker
+    struct timeval timeout;
+    timeout.tv_sec = RequestTimeoutSecs;
+    timeout.tv_usec = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    std::lock_guard<std::mutex> lock(PendingMutex);
+    Pending.push_back(fd);
+    PendingCond.notify_one();
+  }
+
+  // let the workers finish the pending requests and stop
+  {
+    std::lock_guard<std::mutex> lock(PendingMutex);
+    Stopping = true;
+    PendingCond.notify_all();
+  }
+  for (auto & t : pool)
+    t.join();
+  ::close(listenFd);
+  ::close(StopPipe[0]);
+  ::close(StopPipe[1]);
+  ::unlink(socketPath.c_str());
+  return true;
+}
+
+void CompileServer::worker() {
+  // each worker compiles with its own Compiler, the lexer and parser
+  // caches are shared by all of them
+  Compiler compiler(Opts);
+  for (;;) {
+    int fd;
+    {
+      std::unique_lock<std::mutex> lock(PendingMutex);
+      PendingCond.wait(lock, [this]() { return Stopping or not Pending.empty(); });
+      if (Pending.empty())
+        return;   // Stopping, and nothing left to do
+      fd = Pending.front();
+      Pending.pop_front();
+    }
+    serve(fd, compiler);
+    ::close(fd);
+  }
+}
+
+void CompileServer::serve(int fd, Compiler & compiler) {
+  std::string source;
+  if (not readAll(fd, source, MaxRequestSize))
+    return;
+  if (source.size() > MaxRequestSize) {
+    char status = '1';
+    if (writeAll(fd, &status, 1) and writeString(fd, ""))
+      writeString(fd, "Source too large for the server\n");
+    return;
+  }
+  MappedCharStream input;
+  input.setSource(std::move(source), "<client>");
+  std::ostringstream out, errs;
+  bool ok = compiler.compile(input, out, errs);
+  char status = ok ? '0' : '1';
+  if (writeAll(fd, &status, 1) and writeString(fd, out.str()))
+    writeString(fd, errs.str());
+}
+
+int CompileServer::request(const std::string & socketPath, const std::string & source,
+                           std::ostream & out, std::ostream & errs) {
+  struct sockaddr_un addr;
+  if (not socketAddress(socketPath, addr)) {
+    errs << "Socket path too long: " << socketPath << std::endl;
+    return EXIT_FAILURE;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 or
+      ::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    errs << "Can not connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+    if (fd >= 0)
+      ::close(fd);
+    return EXIT_FAILURE;
+  }
+  char status;
+  std::string outPart, errsPart;
+  bool ok = writeAll(fd, source.data(), source.size()) and
+            ::shutdown(fd, SHUT_WR) == 0 and
+            readExact(fd, &status, 1) and
+            readString(fd, outPart) and
+            readString(fd, errsPart);
+  ::close(fd);
+  if (not ok) {
+    errs << "Communication with the server failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  out << outPart;
+  errs << errsPart;
+  return status == '0' ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileServer - Compile server and client over a
+//                  Unix domain socket
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Compiler.h"
+
+#include <string>
+#include <ostream>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+
+//////////////////////////////////////////////////////////////////////
+// Class CompileServer: a long running compiler that serves requests
+// on a Unix domain socket, so that the process startup and the warm-up
+// of the lexer and parser DFA caches are paid only once.
+//
+// Protocol, one request per connection:
+//   client -> server: the Asl source, then the client shuts down its
+//                     writing side of the socket (end of the source)
+//   server -> client: one status byte ('0' code generated, '1' not),
+//                     then the 'out' part and the 'errs' part of the
+//                     answer (see Compiler::compile), each one sent as
+//                     a 4 byte length (network order) and its bytes.
+// The requests are compiled concurrently by a pool of worker threads.
+// A source too large is answered with an error, and a client that
+// stalls for some seconds loses its connection.
+
+class CompileServer {
+
+public:
+
+  // Constructor: 'workers' threads (0 = one per core)
+  CompileServer(const Compiler::Options & Opts, unsigned int workers);
+
+  // Listen on the socket 'socketPath' and serve requests until the
+  // process gets SIGINT or SIGTERM. Returns false if it can not listen.
+  bool run(const std::string & socketPath, std::ostream & errs);
+
+  // Client side: send 'source' to the server listening on 'socketPath'
+  // and write its answer on 'out' and 'errs'. Returns the exit status
+  // of the compilation (EXIT_SUCCESS or EXIT_FAILURE).
+  static int request(const std::string & socketPath, const std::string & source,
+                     std::ostream & out, std::ostream & errs);
+
+private:
+
+  // Body of the worker threads: take a connection and serve it
+  void worker();
+  // Read the source from the connection, compile it and answer
+  void serve(int fd, Compiler & compiler);
+
+  // Attributes
+  Compiler::Options       Opts;
+  unsigned int            NumWorkers;
+
+  // Queue of accepted connections waiting for a worker
+  std::deque<int>         Pending;
+  bool                    Stopping;
+  std::mutex              PendingMutex;
+  std::condition_variable PendingCond;
+
+};  // class CompileServer
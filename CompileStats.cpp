@@ -0,0 +1,240 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileStats - Time, allocations and sizes of the phases
+//               of a compilation
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "CompileStats.h"
+
+#include <atomic>
+#include <algorithm>  // std::min
+#include <new>        // std::bad_alloc, std::get_new_handler
+#include <cstdlib>    // std::malloc, std::free
+#include <iomanip>    // std::setw, std::setprecision
+
+
+//////////////////////////////////////////////////////////////////////
+// Counters of the allocations, updated by the global operator new
+// only while they are enabled
+
+static std::atomic<bool>     CountingAllocations(false);
+static std::atomic<uint64_t> AllocatedBytes(0);
+static std::atomic<uint64_t> NumAllocations(0);
+
+void *operator new(std::size_t size) {
+  if (CountingAllocations.load(std::memory_order_relaxed)) {
+    AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    NumAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (size == 0)
+    size = 1;
+  for (;;) {
+    if (void *p = std::malloc(size))
+      return p;
+    std::new_handler handler = std::get_new_handler();
+    if (not handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+
+// Constructor
+CompileStats::CompileStats() :
+  Running{false},
+  StartBytes{0},
+  StartAllocations{0} {
+}
+
+void CompileStats::startPass(const std::string & name) {
+  endPass();
+  Passes.push_back(Pass{name, 0.0, 0, 0});
+  Running = true;
+  StartBytes = allocatedBytes();
+  StartAllocations = numAllocations();
+  StartTime = Clock::now();
+}
+
+void CompileStats::endPass() {
+  if (not Running)
+    return;
+  Pass & pass = Passes.back();
+  pass.seconds = std::chrono::duration<double>(Clock::now() - StartTime).count();
+  pass.bytes = allocatedBytes() - StartBytes;
+  pass.allocations = numAllocations() - StartAllocations;
+  Running = false;
+}
+
+void CompileStats::splitPass(const std::string & name, double seconds,
+                             uint64_t bytes, uint64_t allocations) {
+  endPass();
+  if (not Passes.empty()) {
+    Pass & last = Passes.back();
+    last.seconds     -= std::min(seconds, last.seconds);
+    last.bytes       -= std::min(bytes, last.bytes);
+    last.allocations -= std::min(allocations, last.allocations);
+  }
+  Passes.push_back(Pass{name, seconds, bytes, allocations});
+}
+
+void CompileStats::count(const std::string & name, std::size_t value) {
+  Counts.push_back(Count{name, value});
+}
+
+void CompileStats::addSubroutine(const std::string & name, std::size_t instructions,
+                                 std::size_t temps, std::size_t tempsCreated) {
+  Subroutines.push_back(Subroutine{name, instructions, temps, tempsCreated});
+}
+
+void CompileStats::addSubroutines(const CompileStats & other) {
+  Subroutines.insert(Subroutines.end(),
+                     other.Subroutines.begin(), other.Subroutines.end());
+}
+
+void CompileStats::addLoop(const std::string & function, const std::string & header,
+                           std::size_t hoisted) {
+  Loops.push_back(Loop{function, header, hoisted});
+}
+
+void CompileStats::print(std::ostream & out, bool times, bool sizes, bool json) const {
+  if (json)
+    printJson(out, times, sizes);
+  else
+    printText(out, times, sizes);
+}
+
+void CompileStats::printText(std::ostream & out, bool times, bool sizes) const {
+  std::ios::fmtflags flags = out.flags();
+  if (times) {
+    double   seconds = 0.0;
+    uint64_t bytes = 0, allocations = 0;
+    out << std::left << std::setw(12) << "pass"
+        << std::right << std::setw(12) << "wall (ms)"
+        << std::setw(14) << "alloc (KB)"
+        << std::setw(10) << "allocs" << std::endl;
+    out << std::fixed << std::setprecision(3);
+    for (const Pass & p : Passes) {
+      out << std::left << std::setw(12) << p.name
+          << std::right << std::setw(12) << p.seconds * 1000.0
+          << std::setw(14) << p.bytes / 1024.0
+          << std::setw(10) << p.allocations << std::endl;
+      seconds += p.seconds;
+      bytes += p.bytes;
+      allocations += p.allocations;
+    }
+    out << std::left << std::setw(12) << "total"
+        << std::right << std::setw(12) << seconds * 1000.0
+        << std::setw(14) << bytes / 1024.0
+        << std::setw(10) << allocations << std::endl;
+    out.flags(flags);
+  }
+  if (sizes) {
+    for (const Count & c : Counts)
+      out << std::left << std::setw(16) << c.name << c.value << std::endl;
+    if (not Subroutines.empty()) {
+      out << std::left << std::setw(16) << "subroutine"
+          << std::right << std::setw(14) << "instructions"
+          << std::setw(8) << "temps"
+          << std::setw(10) << "created" << std::endl;
+      for (const Subroutine & s : Subroutines)
+        out << std::left << std::setw(16) << s.name
+            << std::right << std::setw(14) << s.instructions
+            << std::setw(8) << s.temps
+            << std::setw(10) << s.tempsCreated << std::endl;
+    }
+    if (not Loops.empty()) {
+      out << std::left << std::setw(16) << "loop"
+          << std::setw(16) << "header"
+          << std::right << std::setw(8) << "hoisted" << std::endl;
+      for (const Loop & l : Loops)
+        out << std::left << std::setw(16) << l.function
+            << std::setw(16) << l.header
+            << std::right << std::setw(8) << l.hoisted << std::endl;
+    }
+    out.flags(flags);
+  }
+}
+
+// The names are identifiers or fixed words: nothing to escape
+void CompileStats::printJson(std::ostream & out, bool times, bool sizes) const {
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3) << "{";
+  const char *sep = "";
+  if (times) {
+    out << "\"passes\":[";
+    for (std::size_t i = 0; i < Passes.size(); ++i) {
+      const Pass & p = Passes[i];
+      out << (i ? "," : "") << "{\"name\":\"" << p.name << "\""
+          << ",\"wall_ms\":" << p.seconds * 1000.0
+          << ",\"alloc_bytes\":" << p.bytes
+          << ",\"allocs\":" << p.allocations << "}";
+    }
+    out << "]";
+    sep = ",";
+  }
+  if (sizes) {
+    out << sep << "\"counts\":{";
+    for (std::size_t i = 0; i < Counts.size(); ++i)
+      out << (i ? "," : "") << "\"" << Counts[i].name << "\":" << Counts[i].value;
+    out << "},\"subroutines\":[";
+    for (std::size_t i = 0; i < Subroutines.size(); ++i) {
+      const Subroutine & s = Subroutines[i];
+      out << (i ? "," : "") << "{\"name\":\"" << s.name << "\""
+          << ",\"instructions\":" << s.instructions
+          << ",\"temps\":" << s.temps
+          << ",\"temps_created\":" << s.tempsCreated << "}";
+    }
+    out << "],\"loops\":[";
+    for (std::size_t i = 0; i < Loops.size(); ++i) {
+      const Loop & l = Loops[i];
+      out << (i ? "," : "") << "{\"function\":\"" << l.function << "\""
+          << ",\"header\":\"" << l.header << "\""
+          << ",\"hoisted\":" << l.hoisted << "}";
+    }
+    out << "]";
+  }
+  out << "}" << std::endl;
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void CompileStats::countAllocations(bool enable) {
+  CountingAllocations.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t CompileStats::allocatedBytes() {
+  return AllocatedBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t CompileStats::numAllocations() {
+  return NumAllocations.load(std::memory_order_relaxed);
+}
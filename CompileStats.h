@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    CompileStats - Time, allocations and sizes of the phases
+//               of a compilation
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <chrono>
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint64_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class CompileStats: what the driver reports with --time-passes and
+// --stats. For each phase (pass) of a compilation, its wall time and
+// the volume of memory allocated while it ran; then the sizes of the
+// program (tokens, nodes, symbols...), for every subroutine generated
+// its number of instructions and temporaries, and for every loop the
+// instructions hoisted out of it. The report
+// is a table or, for the tools that track regressions, one line of
+// JSON. The allocations are counted by the global operator new of
+// this module, once countAllocations(true) has been called; they are
+// those of the whole process, so with several threads working at the
+// same time they can not be told apart.
+
+class CompileStats {
+
+public:
+
+  // Constructor
+  CompileStats();
+
+  // Start a pass, ending the one that was running
+  void startPass(const std::string & name);
+  // End the running pass
+  void endPass();
+  // Move a part of the last pass to a pass of its own, e.g. the time
+  // spent writing the code out of the time of the code generation
+  void splitPass(const std::string & name, double seconds,
+                 uint64_t bytes, uint64_t allocations);
+
+  // Record a size of the program
+  void count(const std::string & name, std::size_t value);
+  // Record a generated subroutine: its instructions and temporaries,
+  // and the temporaries created by the code generator (before they
+  // are reused)
+  void addSubroutine(const std::string & name, std::size_t instructions,
+                     std::size_t temps, std::size_t tempsCreated);
+  // Append the subroutines recorded by 'other'
+  void addSubroutines(const CompileStats & other);
+  // Record a loop of 'function', by the label of its header, and the
+  // instructions hoisted out of it
+  void addLoop(const std::string & function, const std::string & header,
+               std::size_t hoisted);
+
+  // Write the report enabled by the flags, as text or as JSON
+  void print(std::ostream & out, bool times, bool sizes, bool json) const;
+
+  // The global counters of allocations
+  static void     countAllocations(bool enable);
+  static uint64_t allocatedBytes();
+  static uint64_t numAllocations();
+
+private:
+
+  typedef std::chrono::steady_clock Clock;
+
+  struct Pass {
+    std::string name;
+    double      seconds;
+    uint64_t    bytes;
+    uint64_t    allocations;
+  };
+
+  struct Count {
+    std::string name;
+    std::size_t value;
+  };
+
+  struct Subroutine {
+    std::string name;
+    std::size_t instructions;
+    std::size_t temps;
+    std::size_t tempsCreated;
+  };
+
+  struct Loop {
+    std::string function;
+    std::string header;
+    std::size_t hoisted;
+  };
+
+  void printText(std::ostream & out, bool times, bool sizes) const;
+  void printJson(std::ostream & out, bool times, bool sizes) const;
+
+  // Attributes
+  std::vector<Pass>       Passes;
+  std::vector<Count>      Counts;
+  std::vector<Subroutine> Subroutines;
+  std::vector<Loop>       Loops;
+
+  // The running pass
+  bool                    Running;
+  Clock::time_point       StartTime;
+  uint64_t                StartBytes;
+  uint64_t                StartAllocations;
+
+};  // class CompileStats
@@ -0,0 +1,496 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Compiler - The phases of the translation of an Asl
+//             program, for one source or a batch of files
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "Compiler.h"
+
+#include "antlr4-runtime.h"
+#include "AslLexer.h"
+#include "AslParser.h"
+#include "AslTreeWalker.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "NodeDecorations.h"
+#include "../common/SemErrors.h"
+#include "SemErrorLog.h"
+#include "SymbolsListener.h"
+#include "TypeCheckListener.h"
+#include "../common/code.h"
+#include "CodeEmitter.h"
+#include "CodeGenListener.h"
+#include "IrOptimizer.h"
+#include "Peephole.h"
+#include "MappedCharStream.h"
+#include "AslAst.h"
+#include "SymbolIndex.h"
+#include "CompileStats.h"
+
+#include <iostream>
+#include <fstream>    // ofstream
+#include <sstream>    // ostringstream
+#include <memory>     // make_shared
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional> // std::function
+#include <algorithm>  // std::max, std::min
+#include <cstdio>     // std::rename, std::remove
+
+
+//////////////////////////////////////////////////////////////////////
+// Error listener that reports the lexical and syntactical errors on a
+// given stream, with the same format as antlr4::ConsoleErrorListener
+
+class StreamErrorListener : public antlr4::BaseErrorListener {
+
+public:
+
+  StreamErrorListener(std::ostream & Out) : Out(Out) {}
+
+  void syntaxError(antlr4::Recognizer *recognizer, antlr4::Token *offendingSymbol,
+                   std::size_t line, std::size_t charPositionInLine,
+                   const std::string & msg, std::exception_ptr e) override {
+    Out << "line " << line << ":" << charPositionInLine << " " << msg << std::endl;
+  }
+
+private:
+
+  std::ostream & Out;
+
+};  // class StreamErrorListener
+
+
+// SemErrors prints the errors on std::cout. To send them to another
+// stream std::cout is redirected only while they are printed, and
+// given back its buffer right after; the lock keeps the workers of a
+// batch from redirecting it at the same time.
+static std::mutex CoutMutex;
+
+static void printSemErrors(SemErrors & errors, std::ostream & out) {
+  if (&out == &std::cout) {
+    errors.print();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(CoutMutex);
+  std::streambuf *coutBuf = std::cout.rdbuf(out.rdbuf());
+  errors.print();
+  std::cout.flush();
+  std::cout.rdbuf(coutBuf);
+}
+
+// Run task(0) ... task(n-1) on 'jobs' threads (the calling one among
+// them): each thread takes the next index not yet taken by anyone
+static void parallelFor(std::size_t n, unsigned int jobs,
+                        const std::function<void(std::size_t)> & task) {
+  jobs = std::max<std::size_t>(1, std::min<std::size_t>(jobs, n));
+  std::atomic<std::size_t> next(0);
+  auto worker = [&]() {
+    for (std::size_t i = next++; i < n; i = next++)
+      task(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned int j = 1; j < jobs; ++j)
+    pool.emplace_back(worker);
+  worker();
+  for (auto & t : pool)
+    t.join();
+}
+
+// Record the times that each peephole pattern has fired, the loops
+// and instructions seen by the loop invariant code motion (in total
+// and loop by loop), and the work of the strength reduction
+static void countOptimizer(const IrOptimizer & optimizer, CompileStats & stats) {
+  for (std::size_t p = 0; p < Peephole::NumPatterns; ++p) {
+    Peephole::Pattern pattern = Peephole::Pattern(p);
+    stats.count(std::string("peephole_") + Peephole::patternName(pattern),
+                optimizer.fired(pattern));
+  }
+  if (optimizer.level() >= 2) {
+    stats.count("licm_loops", optimizer.loops());
+    stats.count("licm_loops_hoisted", optimizer.loopsHoisted());
+    stats.count("licm_hoisted", optimizer.hoisted());
+    for (const IrOptimizer::LoopHoisted & l : optimizer.hoistedByLoop())
+      stats.addLoop(l.function, l.header, l.hoisted);
+    stats.count("iv_reduced", optimizer.reduced());
+    stats.count("iv_removed", optimizer.inductionsRemoved());
+  }
+}
+
+// Name of a file without its directories and without the .asl extension
+static std::string baseName(const std::string & fileName) {
+  std::string name = fileName.substr(fileName.find_last_of('/') + 1);
+  std::size_t dot = name.rfind(".asl");
+  if (dot != std::string::npos and dot + 4 == name.size() and dot > 0)
+    name.erase(dot);
+  return name;
+}
+
+// Parse 'input' and lower the parse tree to 'ast'. The lexer, the
+// tokens, the parser and the parse tree are all freed when it returns:
+// the passes run on the AST alone. Returns false if there are lexical
+// or syntactical errors. 'parsedWithSLL' tells how the input has been
+// parsed, and 'stats' (if any) gets the times of the phases
+static bool parseAst(antlr4::CharStream & input,
+                     antlr4::ANTLRErrorListener & errorListener,
+                     AslAst & ast, bool & parsedWithSLL, CompileStats *stats) {
+  // create a lexer that consumes the character stream and produce a token stream
+  AslLexer lexer(&input);
+  lexer.removeErrorListeners();
+  lexer.addErrorListener(&errorListener);
+  antlr4::CommonTokenStream tokens(&lexer);
+  // the tokens are read on demand by the parser; to time the lexer
+  // apart they are all read first
+  if (stats) {
+    stats->startPass("lexer");
+    tokens.fill();
+  }
+
+  // create a parser that consumes the token stream, and parses it.
+  AslParser parser(&tokens);
+
+  // call the parser and get the parse tree. The input is first parsed
+  // with the faster SLL prediction, bailing out at the first error.
+  // Only if it fails (a real syntax error or a construct that needs
+  // full context) the input is parsed again with full LL prediction
+  // and the default error reporting and recovery.
+  antlr4::atn::ParserATNSimulator *interpreter =
+    parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+  interpreter->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+  parser.removeErrorListeners();
+  parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+  AslParser::ProgramContext *tree = nullptr;
+  parsedWithSLL = true;
+  if (stats)
+    stats->startPass("parser");
+  try {
+    tree = parser.program();
+  }
+  catch (antlr4::ParseCancellationException &) {
+    parsedWithSLL = false;
+    parser.addErrorListener(&errorListener);
+    parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+    parser.reset();   // also rewinds the token stream
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::LL);
+    tree = parser.program();
+  }
+  if (stats) {
+    stats->endPass();
+    stats->count("tokens", tokens.size());
+    stats->count("ll_reparse", parsedWithSLL ? 0 : 1);
+  }
+
+  // check for lexical or syntactical errors
+  if (lexer.getNumberOfSyntaxErrors() > 0 or
+      parser.getNumberOfSyntaxErrors() > 0)
+    return false;
+
+  // print the parse tree (for debugging purposes)
+  // std::cout << tree->toStringTree(&parser) << std::endl;
+
+  // lower the parse tree to the compact AST: the identifiers and
+  // literals are interned
+  if (stats)
+    stats->startPass("ast");
+  ast.lower(tree);
+  if (stats) {
+    stats->endPass();
+    stats->count("nodes", ast.size());
+    stats->count("names", ast.numNames());
+  }
+  return true;
+}
+
+// Print on 'out' the semantic errors of 'log'. The messages are built
+// by SemErrors from the contexts and the tokens, which have been freed
+// after lowering: so the input is parsed again (with the prediction
+// that parsed it the first time, to get the same tree) and the errors
+// are replayed on it. Only a program with errors pays for it. A tree
+// with another number of nodes than 'ast' is not the same one, and the
+// errors can not be replayed: that is an internal error
+static void printSemErrors(const SemErrorLog & log, const AslAst & ast,
+                           antlr4::CharStream & input, bool parsedWithSLL,
+                           std::ostream & out) {
+  input.seek(0);
+  AslLexer lexer(&input);
+  lexer.removeErrorListeners();
+  antlr4::CommonTokenStream tokens(&lexer);
+  AslParser parser(&tokens);
+  parser.removeErrorListeners();
+  if (parsedWithSLL) {
+    parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->
+      setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+  }
+  std::vector<antlr4::ParserRuleContext *> contexts =
+    AslAst::contexts(parser.program());
+  if (contexts.size() != ast.size()) {
+    out << "internal error: the source parsed again has " << contexts.size()
+        << " nodes, not " << ast.size() << ": the semantic errors can not"
+        << " be printed" << std::endl;
+    return;
+  }
+  SemErrors errors;
+  log.replay(errors, contexts);
+  printSemErrors(errors, out);
+}
+
+// Type check the functions of 'program' on a pool of 'jobs' threads.
+// The errors are added to 'errors' as in a serial check
+static void checkFunctions(unsigned int jobs, AslAst::NodeId program,
+                           TypeCheckListener & typecheck,
+                           TypesMgr & types, SymTable & symbols,
+                           NodeDecorations & decorations,
+                           SemErrorLog & errors, const AslAst & ast,
+                           const SymbolIndex & symbolIndex) {
+  // The program itself (the check of main) is done by 'typecheck';
+  // every function is checked by its own listener, that logs its own
+  // errors. The types of the declarations are all created by the
+  // SymbolsListener, and the basic types by the constructors of the
+  // listeners, which are all built here before the threads start:
+  // meanwhile the TypesMgr is only read
+  typecheck.enterProgram(program);
+  std::size_t numFunctions = ast.node(program).numChildren;
+  std::vector<SemErrorLog> functionErrors(numFunctions);
+  std::vector<std::unique_ptr<TypeCheckListener>> functionChecks;
+  for (std::size_t i = 0; i < numFunctions; ++i)
+    functionChecks.emplace_back(new TypeCheckListener(types, symbols, decorations,
+                                                      functionErrors[i], ast, symbolIndex));
+  parallelFor(numFunctions, jobs, [&](std::size_t i) {
+    AslTreeWalker functionWalker;
+    functionWalker.walk(*functionChecks[i], ast, ast.child(program, i));
+  });
+  // the errors of the functions, in source order, go before the ones
+  // of the program
+  for (const SemErrorLog & e : functionErrors)
+    errors.append(e);
+  typecheck.exitProgram(program);
+}
+
+
+// Constructor
+Compiler::Compiler(const Options & Opts) :
+  Opts{Opts} {
+}
+
+bool Compiler::compile(antlr4::CharStream & input, std::ostream & out, std::ostream & errs) {
+  CompileStats stats;
+  bool ok = compile(input, out, errs, stats);
+  if (Opts.timePasses or Opts.stats)
+    stats.print(errs, Opts.timePasses, Opts.stats, Opts.statsJson);
+  return ok;
+}
+
+bool Compiler::compile(antlr4::CharStream & input, std::ostream & out,
+                       std::ostream & errs, CompileStats & stats) {
+  StreamErrorListener errorListener(errs);
+  bool measure = Opts.timePasses or Opts.stats;
+  if (measure)
+    CompileStats::countAllocations(true);
+
+  // parse the input and lower it to the AST: from here on the passes
+  // only use the AST, the parse tree and the tokens are already freed
+  AslAst ast;
+  bool   parsedWithSLL;
+  if (not parseAst(input, errorListener, ast, parsedWithSLL, measure ? &stats : nullptr)) {
+    out << "Lexical and/or syntactical errors have been found." << std::endl;
+    return false;
+  }
+  // the root of the AST
+  const AslAst::NodeId program = 0;
+
+  // create a walker that will traverse the AST and do several things,
+  // like checking variable types or generating code. It does not
+  // recurse, so the depth of the expressions does not use stack.
+  AslTreeWalker walker;
+
+  // Auxililary classes we are going to need to store information while
+  // traversing the tree. They are described below in this document
+  TypesMgr        types;
+  SymTable        symbols(types);
+  NodeDecorations decorations(ast.size());
+  SymbolIndex     symbolIndex(ast.numNames());
+  SemErrorLog     errors;
+
+  // Create a Listener that looks for variables and function declarations in the tree
+  // and stores required information
+  if (measure)
+    stats.startPass("symbols");
+  SymbolsListener symboldecl(types, symbols, decorations, errors, ast, symbolIndex);
+  // Traverse the tree using this listener, to collect information about declared identifiers
+  walker.walk(symboldecl, ast, program);
+
+  // Create another Listener that will perform type checkings wherever it is needed
+  // (on expressions, assignments, parameter passing, etc)
+  if (measure)
+    stats.startPass("typecheck");
+  TypeCheckListener typecheck(types, symbols, decorations, errors, ast, symbolIndex);
+  if (Opts.functionJobs > 1)
+    // The bodies of the functions are checked on a pool of threads
+    checkFunctions(Opts.functionJobs, program, typecheck, types, symbols,
+                   decorations, errors, ast, symbolIndex);
+  else
+    // Traverse the tree using this listener, so all types are checked
+    walker.walk(typecheck, ast, program);
+  std::size_t numSemErrors = errors.getNumberOfSemanticErrors();
+  if (measure) {
+    stats.endPass();
+    stats.count("symbols", symbolIndex.numSymbols());
+    stats.count("types", decorations.numTypes());
+    stats.count("decorations", decorations.numStored());
+    stats.count("sem_errors", numSemErrors);
+  }
+
+  if (numSemErrors > 0) {
+    printSemErrors(errors, ast, input, parsedWithSLL, out);
+    out << "There are semantic errors: no code generated." << std::endl;
+    return false;
+  }
+
+  // The passes that optimize the code of each function
+  IrOptimizer optimizer(Opts.optimize, Opts.verifyIr);
+  // How 'and'/'or' are evaluated: skipping a right operand with no side
+  // effects is an optimization, skipping any is a language mode
+  CodeGenListener::LogicEval logic =
+    Opts.shortCircuit ? CodeGenListener::LogicEval::ShortCircuit :
+    Opts.optimize > 0 ? CodeGenListener::LogicEval::ShortPure :
+                        CodeGenListener::LogicEval::Strict;
+
+  if (Opts.functionJobs > 1) {
+    // The functions are generated on a pool of threads, each one with
+    // its own listener. The code of every function is written out in
+    // source order, as soon as it and all the previous ones are done,
+    // so the output is the same as the serial one
+    std::size_t              numFunctions = ast.node(program).numChildren;
+    std::vector<std::string> texts(numFunctions);
+    std::vector<char>        done(numFunctions, false);
+    std::vector<CompileStats> functionsStats(numFunctions);
+    std::size_t              nextOut = 0;
+    std::mutex               outMutex;
+    // the conversion to text is done by the threads too, so it is
+    // timed as part of the code generation
+    if (measure)
+      stats.startPass("codegen");
+    parallelFor(numFunctions, Opts.functionJobs, [&](std::size_t i) {
+      std::ostringstream text;
+      {
+        CodeEmitter     emitter(text, 64 * 1024, measure ? &functionsStats[i] : nullptr);
+        CodeGenListener codegenerator(types, decorations, emitter, optimizer, logic, ast);
+        AslTreeWalker functionWalker;
+        functionWalker.walk(codegenerator, ast, ast.child(program, i));
+      }
+      std::lock_guard<std::mutex> lock(outMutex);
+      texts[i] = text.str();
+      done[i] = true;
+      while (nextOut < numFunctions and done[nextOut]) {
+        out << texts[nextOut];
+        stats.addSubroutines(functionsStats[nextOut]);
+        std::string().swap(texts[nextOut]);
+        ++nextOut;
+      }
+    });
+    out << std::endl;
+    if (measure) {
+      stats.endPass();
+      countOptimizer(optimizer, stats);
+    }
+    return true;
+  }
+
+  // Auxiliary class that writes the code of each function to 'out' as
+  // soon as it has been generated
+  if (measure)
+    stats.startPass("codegen");
+  CodeEmitter emitter(out, 64 * 1024, measure ? &stats : nullptr);
+  // Create a third listener that will generate code for each part of the tree
+  CodeGenListener codegenerator(types, decorations, emitter, optimizer, logic, ast);
+  // Traverse the tree using this listener, so code is generated and emitted
+  walker.walk(codegenerator, ast, program);
+
+  // write the rest of the generated code
+  emitter.flush();
+  out << std::endl;
+  if (measure) {
+    stats.splitPass("dump", emitter.dumpSeconds(),
+                    emitter.dumpBytes(), emitter.dumpAllocations());
+    countOptimizer(optimizer, stats);
+  }
+
+  return true;
+}
+
+bool Compiler::compileFiles(const std::vector<std::string> & files,
+                            const std::string & outDir,
+                            unsigned int jobs,
+                            std::ostream & errs) {
+  if (jobs == 0)
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+
+  // results of each file, reported in the order of the inputs
+  std::vector<std::string> diagnostics(files.size());
+  std::vector<char>        compiled(files.size(), false);
+
+  parallelFor(files.size(), jobs, [&](std::size_t i) {
+    std::ostringstream diag;
+    MappedCharStream   input;
+    if (not input.openFile(files[i])) {
+      diag << "No such file: " << files[i] << std::endl;
+      diagnostics[i] = diag.str();
+      return;
+    }
+    // the code is streamed to a partial file, renamed once it is
+    // known whether it is the code or the errors
+    std::string   base = outDir + "/" + baseName(files[i]);
+    std::string   partName = base + ".part";
+    std::ofstream outFile(partName);
+    compiled[i] = compile(input, outFile, diag);
+    outFile.close();
+    std::string   outName = base + (compiled[i] ? ".t" : ".err");
+    if (not outFile or std::rename(partName.c_str(), outName.c_str()) != 0) {
+      diag << "Can not write " << outName << std::endl;
+      std::remove(partName.c_str());
+      compiled[i] = false;
+    }
+    diagnostics[i] = diag.str();
+  });
+
+  std::size_t nFailed = 0;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::istringstream diag(diagnostics[i]);
+    std::string line;
+    while (std::getline(diag, line))
+      errs << files[i] << ": " << line << std::endl;
+    if (not compiled[i]) {
+      errs << files[i] << ": no code generated" << std::endl;
+      ++nFailed;
+    }
+  }
+  if (nFailed > 0)
+    errs << nFailed << " of " << files.size() << " files have errors" << std::endl;
+  return nFailed == 0;
+}
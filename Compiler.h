@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Compiler - The phases of the translation of an Asl
+//             program, for one source or a batch of files
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "CompileStats.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+
+//////////////////////////////////////////////////////////////////////
+// Class Compiler: runs the phases of the translation of an Asl program
+// (lexer, parser, SymbolsListener, TypeCheckListener and
+// CodeGenListener) on a source and writes the generated t-code.
+// The ATN and the DFA caches of AslLexer and AslParser are static, so
+// every compilation done in the same process (and in any thread)
+// shares them and starts with warm caches.
+
+class Compiler {
+
+public:
+
+  // Options of the compilation
+  struct Options {
+    bool         stats;          // report the sizes of the program
+    bool         timePasses;     // report the time of every phase
+    bool         statsJson;      // ... as one line of JSON
+    unsigned int functionJobs;   // threads that check and generate the
+                                 // functions of a file (1 = serially)
+    unsigned int optimize;       // optimization level (0 = none, 2 =
+                                 // also the passes over the SSA form)
+    bool         verifyIr;       // check the SSA form after each pass
+    bool         shortCircuit;   // 'and'/'or' skip their right operand
+                                 // even if it calls functions
+    Options() : stats(false), timePasses(false), statsJson(false),
+                functionJobs(1), optimize(1), verifyIr(false),
+                shortCircuit(false) {}
+  };
+
+  // Constructor
+  Compiler(const Options & Opts);
+
+  // Compile the source read from 'input'. What the compiler used to
+  // write on std::cout (the t-code, or the semantic errors and the
+  // final message) goes to 'out'; what it used to write on std::cerr
+  // (lexical and syntactical errors, statistics) goes to 'errs'.
+  // Returns true if code has been generated.
+  // The semantic errors can only be printed on std::cout: if 'out' is
+  // another stream, the buffer of std::cout is set to the one of 'out'
+  // while they are printed, so what other threads write on std::cout
+  // meanwhile also goes to 'out'.
+  bool compile(antlr4::CharStream & input, std::ostream & out, std::ostream & errs);
+
+  // Compile each file of 'files' with a pool of 'jobs' worker threads
+  // (0 = one per core). For every input <dir>/<name>.asl it writes
+  // <outDir>/<name>.t if it compiles, or <outDir>/<name>.err with the
+  // errors otherwise. The diagnostics of each file are reported on
+  // 'errs', in the order of the inputs. Returns true if all compile.
+  bool compileFiles(const std::vector<std::string> & files,
+                    const std::string & outDir,
+                    unsigned int jobs,
+                    std::ostream & errs);
+
+private:
+
+  // Compile, recording in 'stats' the phases done
+  bool compile(antlr4::CharStream & input, std::ostream & out,
+               std::ostream & errs, CompileStats & stats);
+
+  // Attributes
+  Options Opts;
+
+};  // class Compiler
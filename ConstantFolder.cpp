@@ -0,0 +1,429 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ConstantFolder - Folds and propagates the constants of the
+//               code of a function
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "ConstantFolder.h"
+
+#include "IrCode.h"
+
+#include <string>
+#include <iterator>   // std::next
+#include <limits>
+#include <cstdio>     // std::snprintf
+#include <cstdlib>    // std::strtol, std::strtod
+#include <cerrno>
+#include <cmath>      // std::signbit
+
+
+// A literal in the t-code: the shortest text that is read back as
+// 'value', in single or in double precision
+static bool floatText(double value, std::string & text) {
+  char buf[32];
+  for (int precision = 1; precision <= 17; ++precision) {
+    std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+    if (std::strtod(buf, nullptr) == value)
+      break;
+  }
+  text = buf;
+  if (text.find_first_of("einEIN") != std::string::npos)
+    return false;
+  if (text.find('.') == std::string::npos)
+    text += ".0";
+  return true;
+}
+
+// A float 'value' that is the same in single precision
+static bool isSingle(double value) {
+  return static_cast<double>(static_cast<float>(value)) == value;
+}
+
+
+// Constructor
+ConstantFolder::ConstantFolder(IrFunction & Fn) :
+  Fn(Fn),
+  Code(Fn.instructions()),
+  Block{0} {
+}
+
+bool ConstantFolder::run() {
+  const Value unknown = {Value::UNKNOWN, 0, 0.0, IrOperand(), 0};
+  TempValues.assign(Fn.numTemps() + 1, unknown);
+  VarValues.assign(Fn.numVars(), unknown);
+  Block = 1;
+  bool changed = false;
+  for (IrList::iterator it = Code.begin(); it != Code.end(); ) {
+    IrInstr & i = *it;
+    IrOperand d = i.arg[0];
+    switch (i.op) {
+    case IrOp::LABEL:
+    case IrOp::UJUMP:
+      // a new basic block starts at a label, or after a jump
+      ++Block;
+      break;
+    case IrOp::FJUMP: {
+      Value c = valueOf(i.arg[0]);
+      if (c.kind == Value::INT) {
+        changed = true;
+        if (c.i != 0) {
+          it = Code.erase(it);
+          continue;
+        }
+        i = IrInstr::UJUMP(i.arg[1]);
+        ++Block;
+      }
+      break;
+    }
+    case IrOp::LOAD: {
+      if (i.arg[1].isImm()) {
+        Value v = unknown;
+        v.kind = Value::INT;
+        v.i = i.arg[1].immValue();
+        setValue(d, v);
+        break;
+      }
+      if (d == i.arg[1]) {
+        it = Code.erase(it);
+        changed = true;
+        continue;
+      }
+      Value v = valueOf(i.arg[1]);
+      if (v.kind != Value::UNKNOWN and loadValue(it, d, v))
+        changed = true;
+      else
+        forget(d);
+      break;
+    }
+    case IrOp::ILOAD: {
+      Value v = unknown;
+      if (i.arg[1].isImm()) {
+        v.kind = Value::INT;
+        v.i = i.arg[1].immValue();
+      }
+      else {
+        std::string text = Fn.operandText(i.arg[1]);
+        char *end;
+        errno = 0;
+        long value = std::strtol(text.c_str(), &end, 10);
+        if (*end == '\0' and errno == 0 and
+            value >= std::numeric_limits<int32_t>::min() and
+            value <= std::numeric_limits<int32_t>::max()) {
+          v.kind = Value::INT;
+          v.i = static_cast<int32_t>(value);
+        }
+      }
+      setValue(d, v);
+      break;
+    }
+    case IrOp::FLOAD: {
+      Value v = unknown;
+      std::string text = Fn.operandText(i.arg[1]);
+      char *end;
+      double value = std::strtod(text.c_str(), &end);
+      if (*end == '\0') {
+        v.kind = Value::FLOAT;
+        v.f = value;
+      }
+      setValue(d, v);
+      break;
+    }
+    case IrOp::CHLOAD: {
+      Value v = unknown;
+      v.kind = Value::CHAR;
+      v.literal = i.arg[1];
+      setValue(d, v);
+      break;
+    }
+    case IrOp::ADD: case IrOp::SUB: case IrOp::MUL: case IrOp::DIV:
+    case IrOp::EQ:  case IrOp::LT:  case IrOp::LE:
+    case IrOp::AND: case IrOp::OR: {
+      Value x = valueOf(i.arg[1]);
+      Value y = valueOf(i.arg[2]);
+      int64_t result;
+      if (x.kind == Value::INT and y.kind == Value::INT and
+          foldInt(i.op, x.i, y.i, result) and loadInt(it, d, result)) {
+        changed = true;
+        break;
+      }
+      // two loads of the same char literal
+      if (x.kind == Value::CHAR and y.kind == Value::CHAR and
+          x.literal == y.literal and
+          (i.op == IrOp::EQ or i.op == IrOp::LT or i.op == IrOp::LE)) {
+        loadInt(it, d, i.op == IrOp::LT ? 0 : 1);
+        changed = true;
+        break;
+      }
+      if (simplify(it, x, y)) {
+        changed = true;
+        if (it->op == IrOp::LOAD and it->arg[0] == it->arg[1]) {
+          it = Code.erase(it);
+          continue;
+        }
+        break;
+      }
+      forget(d);
+      break;
+    }
+    case IrOp::NEG: case IrOp::NOT: {
+      Value x = valueOf(i.arg[1]);
+      // NEG d d is how a negative literal is loaded: left as it is
+      if (x.kind == Value::INT and not (i.op == IrOp::NEG and d == i.arg[1])) {
+        int64_t result;
+        foldInt(i.op, x.i, 0, result);
+        if (loadInt(it, d, result)) {
+          changed = true;
+          break;
+        }
+      }
+      forget(d);
+      break;
+    }
+    case IrOp::FADD: case IrOp::FSUB: case IrOp::FMUL: case IrOp::FDIV: {
+      Value x = valueOf(i.arg[1]);
+      Value y = valueOf(i.arg[2]);
+      double result;
+      if (x.kind == Value::FLOAT and y.kind == Value::FLOAT and
+          foldFloat(i.op, x.f, y.f, result) and loadFloat(it, d, result)) {
+        changed = true;
+        break;
+      }
+      forget(d);
+      break;
+    }
+    case IrOp::FEQ: case IrOp::FLT: case IrOp::FLE: {
+      Value x = valueOf(i.arg[1]);
+      Value y = valueOf(i.arg[2]);
+      double result;
+      if (x.kind == Value::FLOAT and y.kind == Value::FLOAT and
+          foldFloat(i.op, x.f, y.f, result) and
+          loadInt(it, d, static_cast<int64_t>(result))) {
+        changed = true;
+        break;
+      }
+      forget(d);
+      break;
+    }
+    case IrOp::FNEG: {
+      Value x = valueOf(i.arg[1]);
+      if (x.kind == Value::FLOAT and d != i.arg[1] and loadFloat(it, d, -x.f)) {
+        changed = true;
+        break;
+      }
+      forget(d);
+      break;
+    }
+    case IrOp::FLOAT: {
+      // the integers exactly represented in single precision
+      Value x = valueOf(i.arg[1]);
+      if (x.kind == Value::INT and x.i >= -(1 << 24) and x.i <= (1 << 24) and
+          loadFloat(it, d, static_cast<double>(x.i))) {
+        changed = true;
+        break;
+      }
+      forget(d);
+      break;
+    }
+    default:
+      if (i.definesFirst())
+        forget(d);
+      break;
+    }
+    ++it;
+  }
+  return changed;
+}
+
+ConstantFolder::Value ConstantFolder::valueOf(IrOperand o) const {
+  const Value *v = nullptr;
+  if (o.isTemp())
+    v = &TempValues[o.id];
+  else if (o.isVar())
+    v = &VarValues[o.id];
+  if (v and v->block == Block)
+    return *v;
+  Value unknown = {Value::UNKNOWN, 0, 0.0, IrOperand(), 0};
+  return unknown;
+}
+
+void ConstantFolder::setValue(IrOperand o, const Value & v) {
+  Value *slot = nullptr;
+  if (o.isTemp())
+    slot = &TempValues[o.id];
+  else if (o.isVar())
+    slot = &VarValues[o.id];
+  if (slot) {
+    *slot = v;
+    slot->block = v.kind == Value::UNKNOWN ? 0 : Block;
+  }
+}
+
+void ConstantFolder::forget(IrOperand o) {
+  if (o.isTemp())
+    TempValues[o.id].block = 0;
+  else if (o.isVar())
+    VarValues[o.id].block = 0;
+}
+
+bool ConstantFolder::loadValue(IrList::iterator & it, IrOperand dest, const Value & v) {
+  switch (v.kind) {
+  case Value::INT:
+    return loadInt(it, dest, v.i);
+  case Value::FLOAT:
+    return loadFloat(it, dest, v.f);
+  case Value::CHAR:
+    *it = IrInstr::CHLOAD(dest, v.literal);
+    setValue(dest, v);
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool ConstantFolder::loadInt(IrList::iterator & it, IrOperand dest, int64_t value) {
+  // -value must also be an int32
+  if (value > std::numeric_limits<int32_t>::max() or
+      value < -static_cast<int64_t>(std::numeric_limits<int32_t>::max()))
+    return false;
+  if (value >= 0)
+    *it = IrInstr::ILOAD(dest, IrOperand::imm(static_cast<int32_t>(value)));
+  else {
+    *it = IrInstr::ILOAD(dest, IrOperand::imm(static_cast<int32_t>(-value)));
+    it = Code.insert(std::next(it), IrInstr::NEG(dest, dest));
+  }
+  Value v = {Value::INT, static_cast<int32_t>(value), 0.0, IrOperand(), 0};
+  setValue(dest, v);
+  return true;
+}
+
+bool ConstantFolder::loadFloat(IrList::iterator & it, IrOperand dest, double value) {
+  std::string text;
+  if (value == 0.0 and std::signbit(value))
+    return false;
+  if (not floatText(value < 0.0 ? -value : value, text))
+    return false;
+  *it = IrInstr::FLOAD(dest, Fn.constant(text));
+  if (value < 0.0)
+    it = Code.insert(std::next(it), IrInstr::FNEG(dest, dest));
+  Value v = {Value::FLOAT, 0, value, IrOperand(), 0};
+  setValue(dest, v);
+  return true;
+}
+
+bool ConstantFolder::foldInt(IrOp op, int32_t x, int32_t y, int64_t & result) const {
+  int64_t a = x, b = y;
+  switch (op) {
+  case IrOp::ADD: result = a + b;                 return true;
+  case IrOp::SUB: result = a - b;                 return true;
+  case IrOp::MUL: result = a * b;                 return true;
+  case IrOp::DIV:
+    if (b == 0)
+      return false;
+    result = a / b;
+    return true;
+  case IrOp::NEG: result = -a;                    return true;
+  case IrOp::EQ:  result = a == b;                return true;
+  case IrOp::LT:  result = a < b;                 return true;
+  case IrOp::LE:  result = a <= b;                return true;
+  case IrOp::AND: result = a != 0 and b != 0;     return true;
+  case IrOp::OR:  result = a != 0 or b != 0;      return true;
+  case IrOp::NOT: result = a == 0;                return true;
+  default:
+    return false;
+  }
+}
+
+bool ConstantFolder::foldFloat(IrOp op, double x, double y, double & result) const {
+  float fx = static_cast<float>(x), fy = static_cast<float>(y);
+  double r;
+  float  fr;
+  switch (op) {
+  case IrOp::FADD: r = x + y; fr = fx + fy; break;
+  case IrOp::FSUB: r = x - y; fr = fx - fy; break;
+  case IrOp::FMUL: r = x * y; fr = fx * fy; break;
+  case IrOp::FDIV:
+    if (y == 0.0)
+      return false;
+    r = x / y;
+    fr = fx / fy;
+    break;
+  case IrOp::FEQ:  r = x == y; fr = fx == fy; break;
+  case IrOp::FLT:  r = x <  y; fr = fx <  fy; break;
+  case IrOp::FLE:  r = x <= y; fr = fx <= fy; break;
+  default:
+    return false;
+  }
+  if (r != static_cast<double>(fr) or not isSingle(r))
+    return false;
+  result = r;
+  return true;
+}
+
+bool ConstantFolder::simplify(IrList::iterator & it, const Value & x, const Value & y) {
+  IrOperand d = it->arg[0], a = it->arg[1], b = it->arg[2];
+  bool xKnown = x.kind == Value::INT, yKnown = y.kind == Value::INT;
+  if (not xKnown and not yKnown)
+    return false;
+  IrOperand copy;
+  switch (it->op) {
+  case IrOp::ADD:
+    if (yKnown and y.i == 0) copy = a;
+    else if (xKnown and x.i == 0) copy = b;
+    break;
+  case IrOp::SUB:
+    if (yKnown and y.i == 0) copy = a;
+    break;
+  case IrOp::MUL:
+    if ((xKnown and x.i == 0) or (yKnown and y.i == 0))
+      return loadInt(it, d, 0);
+    if (yKnown and y.i == 1) copy = a;
+    else if (xKnown and x.i == 1) copy = b;
+    break;
+  case IrOp::DIV:
+    if (yKnown and y.i == 1) copy = a;
+    break;
+  case IrOp::AND:
+    if ((xKnown and x.i == 0) or (yKnown and y.i == 0))
+      return loadInt(it, d, 0);
+    if (yKnown) copy = a;
+    else copy = b;
+    break;
+  case IrOp::OR:
+    if ((xKnown and x.i != 0) or (yKnown and y.i != 0))
+      return loadInt(it, d, 1);
+    if (yKnown) copy = a;
+    else copy = b;
+    break;
+  default:
+    break;
+  }
+  if (copy.isNone())
+    return false;
+  *it = IrInstr::LOAD(d, copy);
+  forget(d);
+  return true;
+}
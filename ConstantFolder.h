@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ConstantFolder - Folds and propagates the constants of the
+//               code of a function
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <cstdint>    // int32_t, uint32_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class ConstantFolder: an optimization pass over the code of a
+// function. Inside each basic block it keeps the constant value of
+// the temporaries and local variables loaded with a literal, and
+//  - replaces an operation whose operands are all known (arithmetic,
+//    relational, logic and FLOAT conversion) by the load of its
+//    result,
+//  - replaces a copy of a known value by the load of the literal,
+//  - simplifies x+0, x-0, x*1, x/1, x*0 and the logic ops with a
+//    known operand,
+//  - turns a FJUMP on a known condition into an UJUMP, or drops it.
+// The loads that become unused are removed by the DeadCodeEliminator.
+// A float operation is only folded if its result is the same in
+// single and double precision, so it does not depend on the precision
+// of the machine. Negative results are loaded as the negation of a
+// positive literal, the only literals the code generator emits.
+
+class ConstantFolder {
+
+public:
+
+  // Constructor
+  ConstantFolder(IrFunction & Fn);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+private:
+
+  // A known value of a temporary or a variable
+  struct Value {
+    enum Kind : uint8_t { UNKNOWN, INT, FLOAT, CHAR };
+    Kind      kind;
+    int32_t   i;        // INT
+    double    f;        // FLOAT
+    IrOperand literal;  // CHAR: the literal loaded
+    uint32_t  block;    // the basic block where it is known
+  };
+
+  Value  valueOf(IrOperand o) const;
+  void   setValue(IrOperand o, const Value & v);
+  void   forget(IrOperand o);
+
+  // The loads of a known value to 'dest'
+  bool   loadValue(IrList::iterator & it, IrOperand dest, const Value & v);
+  bool   loadInt(IrList::iterator & it, IrOperand dest, int64_t value);
+  bool   loadFloat(IrList::iterator & it, IrOperand dest, double value);
+
+  bool   foldInt(IrOp op, int32_t x, int32_t y, int64_t & result) const;
+  bool   foldFloat(IrOp op, double x, double y, double & result) const;
+  bool   simplify(IrList::iterator & it, const Value & x, const Value & y);
+
+  // Attributes
+  IrFunction &       Fn;
+  IrList &           Code;
+  std::vector<Value> TempValues;
+  std::vector<Value> VarValues;
+  uint32_t           Block;
+
+};  // class ConstantFolder
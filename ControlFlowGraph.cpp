@@ -0,0 +1,557 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ControlFlowGraph - The basic blocks of the code of a
+//               function, their edges and their dominators
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "ControlFlowGraph.h"
+
+#include "IrCode.h"
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <unordered_map>
+#include <iterator>   // std::next, std::prev
+#include <algorithm>  // std::find, std::sort
+#include <utility>    // std::pair
+#include <cstddef>    // std::size_t
+
+
+// Whether the instruction ends a block
+static bool isTerminator(const IrInstr & i) {
+  return i.op == IrOp::UJUMP or i.op == IrOp::FJUMP or i.op == IrOp::RETURN;
+}
+
+// The label operand of a jump
+static IrOperand & jumpLabel(IrInstr & i) {
+  return i.op == IrOp::FJUMP ? i.arg[1] : i.arg[0];
+}
+
+static std::string blockName(ControlFlowGraph::BlockId b) {
+  return "B" + std::to_string(b);
+}
+
+const ControlFlowGraph::BlockId ControlFlowGraph::NoBlock;
+
+// Constructor
+ControlFlowGraph::ControlFlowGraph(IrFunction & Fn) :
+  Fn(Fn),
+  Code(Fn.instructions()),
+  DomNumbered{false},
+  LastBlock{NoBlock} {
+  build();
+}
+
+void ControlFlowGraph::build() {
+  addEntry();
+  findBlocks();
+  if (removeUnreachable())
+    findBlocks();
+  computeOrder();
+  computeDominators();
+}
+
+std::size_t ControlFlowGraph::numBlocks() const {
+  return Blocks.size();
+}
+
+ControlFlowGraph::Block & ControlFlowGraph::block(BlockId b) {
+  return Blocks[b];
+}
+
+const ControlFlowGraph::Block & ControlFlowGraph::block(BlockId b) const {
+  return Blocks[b];
+}
+
+const std::vector<ControlFlowGraph::BlockId> & ControlFlowGraph::reversePostorder() const {
+  return Rpo;
+}
+
+ControlFlowGraph::BlockId ControlFlowGraph::blockOfLabel(IrOperand l) const {
+  if (l.id >= LabelBlock.size())
+    return NoBlock;
+  return LabelBlock[l.id];
+}
+
+bool ControlFlowGraph::dominates(BlockId a, BlockId b) const {
+  numberDominators();
+  return DomPre[a] <= DomPre[b] and DomPost[b] <= DomPost[a];
+}
+
+bool ControlFlowGraph::dominanceFrontiers(std::vector<std::vector<BlockId>> & frontiers,
+                                          std::size_t budget) const {
+  frontiers.assign(Blocks.size(), std::vector<BlockId>());
+  std::size_t steps = 0;
+  for (BlockId b = 0; b < Blocks.size(); ++b) {
+    if (Blocks[b].preds.size() < 2)
+      continue;
+    for (BlockId p : Blocks[b].preds)
+      for (BlockId r = p; r != Blocks[b].idom; r = Blocks[r].idom) {
+        if (not frontiers[r].empty() and frontiers[r].back() == b)
+          break;
+        if (++steps > budget) {
+          frontiers.clear();
+          return false;
+        }
+        frontiers[r].push_back(b);
+      }
+  }
+  return true;
+}
+
+IrList::iterator ControlFlowGraph::insertPoint(BlockId b) {
+  IrList::iterator last = std::prev(Blocks[b].end);
+  return isTerminator(*last) ? last : Blocks[b].end;
+}
+
+IrList::iterator ControlFlowGraph::insert(BlockId b, const IrInstr & instr) {
+  IrList::iterator at = insertPoint(b);
+  IrList::iterator it = Code.insert(at, instr);
+  attach(b, at, it);
+  return it;
+}
+
+bool ControlFlowGraph::move(BlockId from, IrList::iterator it, BlockId to) {
+  if (it == Blocks[from].begin) {
+    if (std::next(it) == Blocks[from].end)
+      return false;
+    // the block before it in the code ended there
+    Blocks[from].begin = std::next(it);
+    for (Block & block : Blocks)
+      if (block.end == it)
+        block.end = Blocks[from].begin;
+  }
+  IrList::iterator at = insertPoint(to);
+  Code.splice(at, Code, it);
+  attach(to, at, it);
+  return true;
+}
+
+void ControlFlowGraph::attach(BlockId b, IrList::iterator at, IrList::iterator it) {
+  if (at != Blocks[b].begin)
+    return;
+  // the block was only its jump: the block before it in the code
+  // ended there
+  for (Block & block : Blocks)
+    if (block.end == at)
+      block.end = it;
+  Blocks[b].begin = it;
+}
+
+ControlFlowGraph::BlockId ControlFlowGraph::splitEdge(BlockId p, BlockId s) {
+  BlockId n = Blocks.size();
+  IrOperand label = Fn.newLabel("edge");
+  Block nb;
+  IrList::iterator last = std::prev(Blocks[p].end);
+  if (last->op != IrOp::UJUMP and Blocks[p].end == Blocks[s].begin) {
+    // p falls through to s: the new block goes in between
+    nb.begin = Code.insert(Blocks[s].begin, IrInstr::LABEL(label));
+    nb.end = Blocks[s].begin;
+    Blocks[p].end = nb.begin;
+    if (last->op == IrOp::FJUMP and blockOfLabel(last->arg[1]) == s)
+      last->arg[1] = label;
+  }
+  else {
+    // p jumps to s: the new block goes at the end of the code, and
+    // jumps to s
+    IrOperand & target = jumpLabel(*last);
+    nb.begin = Code.insert(Code.end(), IrInstr::LABEL(label));
+    Code.push_back(IrInstr::UJUMP(target));
+    nb.end = Code.end();
+    target = label;
+    Blocks[LastBlock].end = nb.begin;
+    LastBlock = n;
+  }
+  if (label.id >= LabelBlock.size())
+    LabelBlock.resize(label.id + 1, NoBlock);
+  LabelBlock[label.id] = n;
+
+  // the edge p -> s becomes p -> n -> s, keeping the position of p
+  // among the predecessors of s
+  *std::find(Blocks[p].succs.begin(), Blocks[p].succs.end(), s) = n;
+  *std::find(Blocks[s].preds.begin(), Blocks[s].preds.end(), p) = n;
+  nb.preds.push_back(p);
+  nb.succs.push_back(s);
+  nb.idom = p;
+  Blocks.push_back(nb);
+  Blocks[p].children.push_back(n);
+  // n is now the only way into s if the rest of its predecessors come
+  // from s itself (the back edges of a loop)
+  bool entry = Blocks[s].idom == p;
+  for (BlockId q : Blocks[s].preds)
+    if (q != n and not dominates(s, q))
+      entry = false;
+  if (entry) {
+    std::vector<BlockId> & siblings = Blocks[p].children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), s));
+    Blocks[s].idom = n;
+    Blocks[n].children.push_back(s);
+  }
+  Rpo.insert(std::next(std::find(Rpo.begin(), Rpo.end(), p)), n);
+  DomNumbered = false;
+  return n;
+}
+
+ControlFlowGraph::BlockId ControlFlowGraph::preheader(const Loop & loop,
+                                                      std::vector<Loop> & others) {
+  BlockId entry = NoBlock;
+  for (BlockId p : Blocks[loop.header].preds)
+    if (std::find(loop.blocks.begin(), loop.blocks.end(), p) == loop.blocks.end()) {
+      if (entry != NoBlock)
+        return NoBlock;
+      entry = p;
+    }
+  if (entry == NoBlock or Blocks[entry].succs.size() == 1)
+    return entry;
+  BlockId n = splitEdge(entry, loop.header);
+  for (Loop & other : others)
+    if (&other != &loop and
+        std::find(other.blocks.begin(), other.blocks.end(), entry) != other.blocks.end() and
+        std::find(other.blocks.begin(), other.blocks.end(), loop.header) != other.blocks.end())
+      other.blocks.push_back(n);
+  return n;
+}
+
+std::vector<ControlFlowGraph::Loop> ControlFlowGraph::loops() const {
+  // the back edges, by header
+  std::vector<Loop> found;
+  std::vector<std::vector<BlockId>> latches(Blocks.size());
+  for (BlockId b = 0; b < Blocks.size(); ++b)
+    for (BlockId s : Blocks[b].succs)
+      if (dominates(s, b))
+        latches[s].push_back(b);
+  // the blocks of a loop reach a latch without going through the header
+  std::vector<BlockId> inLoop(Blocks.size(), NoBlock);
+  for (BlockId h = 0; h < Blocks.size(); ++h) {
+    if (latches[h].empty())
+      continue;
+    Loop loop;
+    loop.header = h;
+    loop.blocks.push_back(h);
+    inLoop[h] = h;
+    std::vector<BlockId> work;
+    for (BlockId l : latches[h])
+      if (inLoop[l] != h) {
+        inLoop[l] = h;
+        loop.blocks.push_back(l);
+        work.push_back(l);
+      }
+    while (not work.empty()) {
+      BlockId b = work.back();
+      work.pop_back();
+      for (BlockId p : Blocks[b].preds)
+        if (inLoop[p] != h) {
+          inLoop[p] = h;
+          loop.blocks.push_back(p);
+          work.push_back(p);
+        }
+    }
+    found.push_back(loop);
+  }
+  std::stable_sort(found.begin(), found.end(), [](const Loop & a, const Loop & b) {
+    return a.blocks.size() < b.blocks.size();
+  });
+  return found;
+}
+
+void ControlFlowGraph::addEntry() {
+  // the label of a previous build is not reached by any jump
+  if (not Code.empty() and Code.front().op == IrOp::LABEL and
+      Code.front().arg[0] != EntryLabel)
+    Code.push_front(IrInstr::LABEL(EntryLabel = Fn.newLabel("entry")));
+}
+
+void ControlFlowGraph::findBlocks() {
+  Blocks.clear();
+  LabelBlock.clear();
+  IrList::iterator it = Code.begin();
+  while (it != Code.end()) {
+    BlockId id = Blocks.size();
+    Block b;
+    b.begin = it;
+    b.idom = NoBlock;
+    if (it->op == IrOp::LABEL) {
+      if (it->arg[0].id >= LabelBlock.size())
+        LabelBlock.resize(it->arg[0].id + 1, NoBlock);
+      LabelBlock[it->arg[0].id] = id;
+      ++it;
+    }
+    while (it != Code.end() and it->op != IrOp::LABEL)
+      if (isTerminator(*it++))
+        break;
+    b.end = it;
+    Blocks.push_back(b);
+  }
+  LastBlock = Blocks.empty() ? NoBlock : Blocks.size() - 1;
+
+  for (BlockId id = 0; id < Blocks.size(); ++id) {
+    IrInstr & last = *std::prev(Blocks[id].end);
+    std::vector<BlockId> & succs = Blocks[id].succs;
+    if (last.op == IrOp::UJUMP or last.op == IrOp::FJUMP) {
+      BlockId target = blockOfLabel(jumpLabel(last));
+      if (target != NoBlock)
+        succs.push_back(target);
+    }
+    if (last.op != IrOp::UJUMP and last.op != IrOp::RETURN and
+        id + 1 < Blocks.size() and
+        (succs.empty() or succs[0] != id + 1))
+      succs.push_back(id + 1);
+    for (BlockId s : succs)
+      Blocks[s].preds.push_back(id);
+  }
+}
+
+bool ControlFlowGraph::removeUnreachable() {
+  if (Blocks.empty())
+    return false;
+  std::vector<char> reached(Blocks.size(), false);
+  std::vector<BlockId> work(1, 0);
+  reached[0] = true;
+  while (not work.empty()) {
+    BlockId b = work.back();
+    work.pop_back();
+    for (BlockId s : Blocks[b].succs)
+      if (not reached[s]) {
+        reached[s] = true;
+        work.push_back(s);
+      }
+  }
+  bool removed = false;
+  for (BlockId b = 0; b < Blocks.size(); ++b)
+    if (not reached[b]) {
+      Code.erase(Blocks[b].begin, Blocks[b].end);
+      removed = true;
+    }
+  return removed;
+}
+
+void ControlFlowGraph::computeOrder() {
+  // depth first search, with the successor to visit next of each
+  // block of the stack
+  Rpo.clear();
+  if (Blocks.empty())
+    return;
+  std::vector<char> visited(Blocks.size(), false);
+  std::vector<std::pair<BlockId, std::size_t>> stack;
+  stack.push_back(std::make_pair(0, 0));
+  visited[0] = true;
+  while (not stack.empty()) {
+    BlockId b = stack.back().first;
+    std::size_t & next = stack.back().second;
+    if (next < Blocks[b].succs.size()) {
+      BlockId s = Blocks[b].succs[next++];
+      if (not visited[s]) {
+        visited[s] = true;
+        stack.push_back(std::make_pair(s, 0));
+      }
+    }
+    else {
+      Rpo.push_back(b);
+      stack.pop_back();
+    }
+  }
+  std::reverse(Rpo.begin(), Rpo.end());
+}
+
+void ControlFlowGraph::computeDominators() {
+  if (Blocks.empty())
+    return;
+  std::vector<uint32_t> order(Blocks.size());
+  for (std::size_t i = 0; i < Rpo.size(); ++i)
+    order[Rpo[i]] = i;
+  Blocks[0].idom = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (std::size_t i = 1; i < Rpo.size(); ++i) {
+      BlockId b = Rpo[i];
+      BlockId idom = NoBlock;
+      for (BlockId p : Blocks[b].preds) {
+        if (Blocks[p].idom == NoBlock)
+          continue;
+        if (idom == NoBlock) {
+          idom = p;
+          continue;
+        }
+        // the nearest common dominator of p and idom
+        BlockId f = p;
+        while (f != idom) {
+          while (order[f] > order[idom])
+            f = Blocks[f].idom;
+          while (order[idom] > order[f])
+            idom = Blocks[idom].idom;
+        }
+      }
+      if (Blocks[b].idom != idom) {
+        Blocks[b].idom = idom;
+        changed = true;
+      }
+    }
+  }
+  for (Block & b : Blocks)
+    b.children.clear();
+  for (BlockId b = 1; b < Blocks.size(); ++b)
+    Blocks[Blocks[b].idom].children.push_back(b);
+  DomNumbered = false;
+}
+
+void ControlFlowGraph::numberDominators() const {
+  if (DomNumbered)
+    return;
+  DomPre.assign(Blocks.size(), 0);
+  DomPost.assign(Blocks.size(), 0);
+  uint32_t pre = 0, post = 0;
+  std::vector<std::pair<BlockId, std::size_t>> stack;
+  if (not Blocks.empty()) {
+    stack.push_back(std::make_pair(0, 0));
+    DomPre[0] = pre++;
+  }
+  while (not stack.empty()) {
+    BlockId b = stack.back().first;
+    std::size_t & next = stack.back().second;
+    if (next < Blocks[b].children.size()) {
+      BlockId c = Blocks[b].children[next++];
+      DomPre[c] = pre++;
+      stack.push_back(std::make_pair(c, 0));
+    }
+    else {
+      DomPost[b] = post++;
+      stack.pop_back();
+    }
+  }
+  DomNumbered = true;
+}
+
+bool ControlFlowGraph::verify(std::string & error) const {
+  // the blocks cover the code, each instruction once
+  std::unordered_map<const IrInstr *, BlockId> start;
+  std::size_t covered = 0;
+  for (BlockId b = 0; b < Blocks.size(); ++b) {
+    const Block & block = Blocks[b];
+    start[&*block.begin] = b;
+    if (block.begin == block.end) {
+      error = blockName(b) + " is empty";
+      return false;
+    }
+    bool body = false;
+    for (IrList::const_iterator it = block.begin; it != block.end; ++it) {
+      if (it == Code.end()) {
+        error = blockName(b) + " does not end";
+        return false;
+      }
+      if (it->op == IrOp::LABEL and body) {
+        error = blockName(b) + " has a label inside";
+        return false;
+      }
+      body = true;
+      if (isTerminator(*it) and std::next(it) != block.end) {
+        error = blockName(b) + " has a jump inside";
+        return false;
+      }
+      ++covered;
+    }
+  }
+  if (covered != Code.size()) {
+    error = "the blocks do not cover the code";
+    return false;
+  }
+
+  // the edges are those of the code
+  for (BlockId b = 0; b < Blocks.size(); ++b) {
+    const Block & block = Blocks[b];
+    IrInstr last = *std::prev(block.end);
+    std::vector<BlockId> succs;
+    if (last.op == IrOp::UJUMP or last.op == IrOp::FJUMP) {
+      BlockId target = blockOfLabel(jumpLabel(last));
+      if (target == NoBlock or target >= Blocks.size() or
+          Blocks[target].begin->op != IrOp::LABEL) {
+        error = blockName(b) + " jumps to a missing label";
+        return false;
+      }
+      succs.push_back(target);
+    }
+    if (last.op != IrOp::UJUMP and last.op != IrOp::RETURN and
+        block.end != Code.end())
+      succs.push_back(start.at(&*block.end));
+    std::sort(succs.begin(), succs.end());
+    succs.erase(std::unique(succs.begin(), succs.end()), succs.end());
+    std::vector<BlockId> graph = block.succs;
+    std::sort(graph.begin(), graph.end());
+    if (graph != succs) {
+      error = "the successors of " + blockName(b) + " are not those of its code";
+      return false;
+    }
+    for (BlockId s : block.succs)
+      if (std::count(Blocks[s].preds.begin(), Blocks[s].preds.end(), b) != 1) {
+        error = blockName(b) + " is not a predecessor of " + blockName(s);
+        return false;
+      }
+    for (BlockId p : block.preds)
+      if (std::count(Blocks[p].succs.begin(), Blocks[p].succs.end(), b) != 1) {
+        error = blockName(p) + " is not a successor of " + blockName(b);
+        return false;
+      }
+  }
+
+  // every block is reached, and its immediate dominator dominates
+  // each of its predecessors
+  if (Rpo.size() != Blocks.size()) {
+    error = "there are blocks that can not be reached";
+    return false;
+  }
+  for (BlockId b = 1; b < Blocks.size(); ++b) {
+    BlockId idom = Blocks[b].idom;
+    if (idom == NoBlock or idom == b or not dominates(idom, b)) {
+      error = "wrong immediate dominator of " + blockName(b);
+      return false;
+    }
+    for (BlockId p : Blocks[b].preds)
+      if (not dominates(idom, p)) {
+        error = blockName(Blocks[b].idom) + " does not dominate " + blockName(b);
+        return false;
+      }
+  }
+  return true;
+}
+
+void ControlFlowGraph::dump(std::ostream & out) const {
+  out << "function " << Fn.name() << std::endl;
+  for (BlockId b = 0; b < Blocks.size(); ++b) {
+    const Block & block = Blocks[b];
+    out << blockName(b) << ":  preds";
+    for (BlockId p : block.preds)
+      out << " " << blockName(p);
+    out << "  succs";
+    for (BlockId s : block.succs)
+      out << " " << blockName(s);
+    out << "  idom " << (block.idom == NoBlock ? "-" : blockName(block.idom))
+        << std::endl;
+    for (IrList::const_iterator it = block.begin; it != block.end; ++it)
+      out << "    " << Fn.instrText(*it) << std::endl;
+  }
+}
@@ -0,0 +1,166 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ControlFlowGraph - The basic blocks of the code of a
+//               function, their edges and their dominators
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>    // uint32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class ControlFlowGraph: the basic blocks of the code of a function
+// and the jumps between them, for the passes that look beyond a
+// block. A block is a range of the instruction list: it starts with
+// its label, if any (a second label starts another block, so that the
+// end of an if and the start of a loop are apart), and only its last
+// instruction can be a jump or a RETURN. The blocks are numbered in
+// the order of the code, and those that can not be reached from the
+// entry are removed from the code when the graph is built.
+//  - Entry: the block 0, which no jump reaches. If the code starts
+//    with a label, a new label is put before it, so that the entry is
+//    an empty block that falls through to the old one.
+//  - Dominators: computed by the iterative algorithm of Cooper,
+//    Harvey and Kennedy over the reverse postorder, which takes a few
+//    passes (one more than the nesting of the loops, for the usual
+//    structured code). The dominator tree is numbered in preorder and
+//    postorder, so dominates() takes constant time.
+//  - Loops: the natural loops, one by header, found from the back
+//    edges (those to a block that dominates their origin).
+//  - The graph follows the code while blocks are added on its edges
+//    (splitEdge) and instructions are added or moved (insert, move);
+//    any other change of the jumps needs a new build().
+
+class ControlFlowGraph {
+
+public:
+
+  typedef uint32_t BlockId;
+  static const BlockId NoBlock = UINT32_MAX;
+
+  struct Block {
+    IrList::iterator     begin;      // first instruction
+    IrList::iterator     end;        // one past the last one
+    std::vector<BlockId> preds;
+    std::vector<BlockId> succs;
+    BlockId              idom;       // immediate dominator (entry: itself)
+    std::vector<BlockId> children;   // in the dominator tree
+  };
+
+  struct Loop {
+    BlockId              header;
+    std::vector<BlockId> blocks;     // the header first
+  };
+
+  // Constructor: builds the graph of the code of 'Fn'
+  ControlFlowGraph(IrFunction & Fn);
+
+  // Build the graph again, after the code has changed
+  void build();
+
+  std::size_t   numBlocks() const;
+  Block &       block(BlockId b);
+  const Block & block(BlockId b) const;
+  // The blocks in reverse postorder (a block before its successors,
+  // but for the back edges of the loops)
+  const std::vector<BlockId> & reversePostorder() const;
+  // The block that starts with label 'l'
+  BlockId blockOfLabel(IrOperand l) const;
+
+  // Whether every path from the entry to 'b' goes through 'a'
+  bool dominates(BlockId a, BlockId b) const;
+  // The dominance frontier of every block: the blocks where its
+  // dominance ends (where the definitions made in it meet others).
+  // Gives up, and returns false, after 'budget' steps
+  bool dominanceFrontiers(std::vector<std::vector<BlockId>> & frontiers,
+                          std::size_t budget) const;
+  // The natural loops, the inner ones before those that contain them
+  std::vector<Loop> loops() const;
+
+  // Where code is added at the end of 'b': before its jump, if any
+  IrList::iterator insertPoint(BlockId b);
+  // Add an instruction at the end of 'b' (at its insert point)
+  IrList::iterator insert(BlockId b, const IrInstr & instr);
+  // Move the instruction 'it' of 'from' to the end of 'to'. It is not
+  // moved, and false is returned, if it is the only one of 'from'
+  bool move(BlockId from, IrList::iterator it, BlockId to);
+  // Add an empty block on the edge from 'p' to its successor 's', so
+  // that the code added to it only runs when going through that edge.
+  // Returns the new block: its only instruction is its label, or the
+  // UJUMP to 's' when it is placed at the end of the code.
+  BlockId splitEdge(BlockId p, BlockId s);
+  // The block where the code hoisted out of 'loop' goes: the only
+  // block out of the loop that leads to its header, if it has no other
+  // successor, or else a new block on that edge. NoBlock if there are
+  // several entries to the loop. The new block is added to the loops
+  // of 'others' that contain it.
+  BlockId preheader(const Loop & loop, std::vector<Loop> & others);
+
+  // Check that the graph describes the code: on failure 'error' tells
+  // what is wrong
+  bool verify(std::string & error) const;
+  // Write the blocks, their edges and dominators, and their code
+  void dump(std::ostream & out) const;
+
+private:
+
+  // Put the entry label before the code, if it starts with a label
+  void addEntry();
+  // Split the code in blocks and find their edges
+  void findBlocks();
+  // Erase the code of the blocks that can not be reached; returns
+  // true if there was any
+  bool removeUnreachable();
+  void computeOrder();
+  void computeDominators();
+  // Number the dominator tree (if it has changed)
+  void numberDominators() const;
+  // Link the instruction 'it', just put before 'at' in the code, to
+  // the block 'b' that 'at' ends or starts
+  void attach(BlockId b, IrList::iterator at, IrList::iterator it);
+
+  // Attributes
+  IrFunction &          Fn;
+  IrList &              Code;
+  std::vector<Block>    Blocks;
+  std::vector<BlockId>  Rpo;
+  std::vector<BlockId>  LabelBlock;    // by the id of the label
+  // numbering of the dominator tree, done when it is first needed
+  mutable std::vector<uint32_t> DomPre;
+  mutable std::vector<uint32_t> DomPost;
+  mutable bool          DomNumbered;
+  BlockId               LastBlock;     // the last one in the code
+  IrOperand             EntryLabel;    // the one added by addEntry()
+
+};  // class ControlFlowGraph
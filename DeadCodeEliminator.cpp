@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    DeadCodeEliminator - Removes the instructions of a function
+//               whose result is never used
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "DeadCodeEliminator.h"
+
+#include "IrCode.h"
+
+#include <vector>
+#include <cstddef>    // std::size_t
+
+
+// Constructor
+DeadCodeEliminator::DeadCodeEliminator(IrFunction & Fn) :
+  Fn(Fn),
+  Code(Fn.instructions()) {
+}
+
+bool DeadCodeEliminator::run() {
+  bool changed = removeUnreachable();
+  if (removeUnusedTemps())
+    changed = true;
+  return changed;
+}
+
+bool DeadCodeEliminator::isPure(const IrInstr & i) {
+  switch (i.op) {
+  case IrOp::LOAD:  case IrOp::ILOAD: case IrOp::FLOAD: case IrOp::CHLOAD:
+  case IrOp::ALOAD: case IrOp::LOADX:
+  case IrOp::ADD:   case IrOp::SUB:   case IrOp::MUL:   case IrOp::DIV:
+  case IrOp::NEG:   case IrOp::EQ:    case IrOp::LT:    case IrOp::LE:
+  case IrOp::AND:   case IrOp::OR:    case IrOp::NOT:
+  case IrOp::FADD:  case IrOp::FSUB:  case IrOp::FMUL:  case IrOp::FDIV:
+  case IrOp::FNEG:  case IrOp::FEQ:   case IrOp::FLT:   case IrOp::FLE:
+  case IrOp::FLOAT:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool DeadCodeEliminator::removeUnreachable() {
+  bool changed = false;
+  bool reachable = true;
+  for (IrList::iterator it = Code.begin(); it != Code.end(); ) {
+    if (it->op == IrOp::LABEL)
+      reachable = true;
+    else if (not reachable) {
+      it = Code.erase(it);
+      changed = true;
+      continue;
+    }
+    if (it->op == IrOp::UJUMP or it->op == IrOp::RETURN)
+      reachable = false;
+    ++it;
+  }
+  return changed;
+}
+
+bool DeadCodeEliminator::removeUnusedTemps() {
+  // number of reads of each temporary, and its pure definitions
+  std::vector<uint32_t> numUses(Fn.numTemps() + 1, 0);
+  std::vector<std::vector<IrList::iterator>> pureDefs(Fn.numTemps() + 1);
+  IrOperand used[3];
+  for (IrList::iterator it = Code.begin(); it != Code.end(); ++it) {
+    std::size_t n = it->uses(used);
+    for (std::size_t k = 0; k < n; ++k)
+      if (used[k].isTemp())
+        ++numUses[used[k].id];
+    if (isPure(*it) and it->arg[0].isTemp())
+      pureDefs[it->arg[0].id].push_back(it);
+  }
+
+  std::vector<uint32_t> work;
+  for (uint32_t t = 1; t < numUses.size(); ++t)
+    if (numUses[t] == 0 and not pureDefs[t].empty())
+      work.push_back(t);
+  bool changed = false;
+  while (not work.empty()) {
+    uint32_t t = work.back();
+    work.pop_back();
+    if (numUses[t] != 0)
+      continue;
+    std::vector<IrList::iterator> defs;
+    defs.swap(pureDefs[t]);
+    for (IrList::iterator it : defs) {
+      std::size_t n = it->uses(used);
+      for (std::size_t k = 0; k < n; ++k)
+        if (used[k].isTemp() and --numUses[used[k].id] == 0 and
+            not pureDefs[used[k].id].empty())
+          work.push_back(used[k].id);
+      Code.erase(it);
+      changed = true;
+    }
+  }
+  return changed;
+}
@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    DeadCodeEliminator - Removes the instructions of a function
+//               whose result is never used
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <cstdint>    // uint32_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class DeadCodeEliminator: an optimization pass over the code of a
+// function. It removes
+//  - the instructions that can not be reached: those after an UJUMP
+//    or a RETURN and before the next label,
+//  - the instructions without side effects that define a temporary
+//    never read (e.g. the loads left by the ConstantFolder), and then
+//    those that only fed them, and so on.
+
+class DeadCodeEliminator {
+
+public:
+
+  // Constructor
+  DeadCodeEliminator(IrFunction & Fn);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+  // Whether the only effect of the instruction is to define its first
+  // operand
+  static bool isPure(const IrInstr & i);
+
+private:
+
+  bool removeUnreachable();
+  bool removeUnusedTemps();
+
+  // Attributes
+  IrFunction & Fn;
+  IrList &     Code;
+
+};  // class DeadCodeEliminator
@@ -0,0 +1,340 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IrCode - Intermediate form of the generated code,
+//           with integer operands
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "IrCode.h"
+
+#include "../common/code.h"
+
+#include <string>
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// IrOperand
+
+IrOperand IrOperand::none() {
+  return IrOperand();
+}
+
+IrOperand IrOperand::imm(int32_t value) {
+  return IrOperand(IMM, static_cast<uint32_t>(value));
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// IrInstr
+
+IrInstr::IrInstr(IrOp op, IrOperand a1, IrOperand a2, IrOperand a3) :
+  op{op} {
+  arg[0] = a1;
+  arg[1] = a2;
+  arg[2] = a3;
+}
+
+IrInstr IrInstr::LABEL(IrOperand l)                              { return IrInstr(IrOp::LABEL, l); }
+IrInstr IrInstr::UJUMP(IrOperand l)                              { return IrInstr(IrOp::UJUMP, l); }
+IrInstr IrInstr::FJUMP(IrOperand x, IrOperand l)                 { return IrInstr(IrOp::FJUMP, x, l); }
+IrInstr IrInstr::LOAD(IrOperand d, IrOperand s)                  { return IrInstr(IrOp::LOAD, d, s); }
+IrInstr IrInstr::ILOAD(IrOperand d, IrOperand v)                 { return IrInstr(IrOp::ILOAD, d, v); }
+IrInstr IrInstr::FLOAD(IrOperand d, IrOperand v)                 { return IrInstr(IrOp::FLOAD, d, v); }
+IrInstr IrInstr::CHLOAD(IrOperand d, IrOperand v)                { return IrInstr(IrOp::CHLOAD, d, v); }
+IrInstr IrInstr::ALOAD(IrOperand d, IrOperand a)                 { return IrInstr(IrOp::ALOAD, d, a); }
+IrInstr IrInstr::LOADX(IrOperand d, IrOperand a, IrOperand o)    { return IrInstr(IrOp::LOADX, d, a, o); }
+IrInstr IrInstr::XLOAD(IrOperand a, IrOperand o, IrOperand s)    { return IrInstr(IrOp::XLOAD, a, o, s); }
+IrInstr IrInstr::READI(IrOperand d)                              { return IrInstr(IrOp::READI, d); }
+IrInstr IrInstr::READF(IrOperand d)                              { return IrInstr(IrOp::READF, d); }
+IrInstr IrInstr::READC(IrOperand d)                              { return IrInstr(IrOp::READC, d); }
+IrInstr IrInstr::WRITEI(IrOperand x)                             { return IrInstr(IrOp::WRITEI, x); }
+IrInstr IrInstr::WRITEF(IrOperand x)                             { return IrInstr(IrOp::WRITEF, x); }
+IrInstr IrInstr::WRITEC(IrOperand x)                             { return IrInstr(IrOp::WRITEC, x); }
+IrInstr IrInstr::WRITELN()                                       { return IrInstr(IrOp::WRITELN); }
+IrInstr IrInstr::ADD(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::ADD, d, x, y); }
+IrInstr IrInstr::SUB(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::SUB, d, x, y); }
+IrInstr IrInstr::MUL(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::MUL, d, x, y); }
+IrInstr IrInstr::DIV(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::DIV, d, x, y); }
+IrInstr IrInstr::NEG(IrOperand d, IrOperand x)                   { return IrInstr(IrOp::NEG, d, x); }
+IrInstr IrInstr::EQ(IrOperand d, IrOperand x, IrOperand y)       { return IrInstr(IrOp::EQ, d, x, y); }
+IrInstr IrInstr::LT(IrOperand d, IrOperand x, IrOperand y)       { return IrInstr(IrOp::LT, d, x, y); }
+IrInstr IrInstr::LE(IrOperand d, IrOperand x, IrOperand y)       { return IrInstr(IrOp::LE, d, x, y); }
+IrInstr IrInstr::AND(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::AND, d, x, y); }
+IrInstr IrInstr::OR(IrOperand d, IrOperand x, IrOperand y)       { return IrInstr(IrOp::OR, d, x, y); }
+IrInstr IrInstr::NOT(IrOperand d, IrOperand x)                   { return IrInstr(IrOp::NOT, d, x); }
+IrInstr IrInstr::FADD(IrOperand d, IrOperand x, IrOperand y)     { return IrInstr(IrOp::FADD, d, x, y); }
+IrInstr IrInstr::FSUB(IrOperand d, IrOperand x, IrOperand y)     { return IrInstr(IrOp::FSUB, d, x, y); }
+IrInstr IrInstr::FMUL(IrOperand d, IrOperand x, IrOperand y)     { return IrInstr(IrOp::FMUL, d, x, y); }
+IrInstr IrInstr::FDIV(IrOperand d, IrOperand x, IrOperand y)     { return IrInstr(IrOp::FDIV, d, x, y); }
+IrInstr IrInstr::FNEG(IrOperand d, IrOperand x)                  { return IrInstr(IrOp::FNEG, d, x); }
+IrInstr IrInstr::FEQ(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::FEQ, d, x, y); }
+IrInstr IrInstr::FLT(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::FLT, d, x, y); }
+IrInstr IrInstr::FLE(IrOperand d, IrOperand x, IrOperand y)      { return IrInstr(IrOp::FLE, d, x, y); }
+IrInstr IrInstr::FLOAT(IrOperand d, IrOperand x)                 { return IrInstr(IrOp::FLOAT, d, x); }
+IrInstr IrInstr::PUSH(IrOperand x)                               { return IrInstr(IrOp::PUSH, x); }
+IrInstr IrInstr::POP(IrOperand d)                                { return IrInstr(IrOp::POP, d); }
+IrInstr IrInstr::CALL(IrOperand f)                               { return IrInstr(IrOp::CALL, f); }
+IrInstr IrInstr::RETURN()                                        { return IrInstr(IrOp::RETURN); }
+
+bool IrInstr::definesFirst() const {
+  switch (op) {
+  case IrOp::LABEL:  case IrOp::UJUMP:  case IrOp::FJUMP:
+  case IrOp::XLOAD:
+  case IrOp::WRITEI: case IrOp::WRITEF: case IrOp::WRITEC: case IrOp::WRITELN:
+  case IrOp::PUSH:   case IrOp::CALL:   case IrOp::RETURN:
+    return false;
+  case IrOp::POP:
+    return not arg[0].isNone();
+  default:
+    return true;
+  }
+}
+
+std::size_t IrInstr::uses(IrOperand out[3]) const {
+  std::size_t pos[3];
+  std::size_t n = usePositions(pos);
+  // only values kept in the function are uses (not labels, literals)
+  std::size_t k = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    if (arg[pos[i]].isTemp() or arg[pos[i]].isVar())
+      out[k++] = arg[pos[i]];
+  return k;
+}
+
+std::size_t IrInstr::usePositions(std::size_t out[3]) const {
+  std::size_t n = 0;
+  switch (op) {
+  case IrOp::LABEL: case IrOp::UJUMP: case IrOp::CALL:
+  case IrOp::WRITELN: case IrOp::RETURN: case IrOp::POP:
+  case IrOp::READI: case IrOp::READF: case IrOp::READC:
+    break;
+  case IrOp::FJUMP: case IrOp::WRITEI: case IrOp::WRITEF: case IrOp::WRITEC:
+  case IrOp::PUSH:
+    if (not arg[0].isNone())
+      out[n++] = 0;
+    break;
+  case IrOp::XLOAD:
+    out[n++] = 0;
+    out[n++] = 1;
+    out[n++] = 2;
+    break;
+  default:    // the destination first, then the sources
+    out[n++] = 1;
+    if (not arg[2].isNone())
+      out[n++] = 2;
+    break;
+  }
+  return n;
+}
+
+const char * IrInstr::opName(IrOp op) {
+  static const char * const names[] = {
+    "LABEL", "UJUMP", "FJUMP",
+    "LOAD", "ILOAD", "FLOAD", "CHLOAD", "ALOAD", "LOADX", "XLOAD",
+    "READI", "READF", "READC", "WRITEI", "WRITEF", "WRITEC", "WRITELN",
+    "ADD", "SUB", "MUL", "DIV", "NEG", "EQ", "LT", "LE", "AND", "OR", "NOT",
+    "FADD", "FSUB", "FMUL", "FDIV", "FNEG", "FEQ", "FLT", "FLE", "FLOAT",
+    "PUSH", "POP", "CALL", "RETURN"
+  };
+  return names[static_cast<std::size_t>(op)];
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// IrFunction
+
+// Constructor
+IrFunction::IrFunction(const std::string & name) :
+  Name{name},
+  NumTemps{0},
+  NumTempsCreated{0} {
+}
+
+void IrFunction::reset(const std::string & name) {
+  Name = name;
+  Vars.clear();
+  Consts.clear();
+  ConstIndex.clear();
+  LabelPrefix.clear();
+  NumTemps = 0;
+  NumTempsCreated = 0;
+  Code.clear();
+}
+
+const std::string & IrFunction::name() const {
+  return Name;
+}
+
+IrOperand IrFunction::addParam(const std::string & name) {
+  Vars.push_back(Var{name, 1, true});
+  return IrOperand(IrOperand::VAR, Vars.size() - 1);
+}
+
+IrOperand IrFunction::addVar(const std::string & name, std::size_t size) {
+  Vars.push_back(Var{name, size, false});
+  return IrOperand(IrOperand::VAR, Vars.size() - 1);
+}
+
+bool IrFunction::isParam(IrOperand v) const {
+  return v.isVar() and Vars[v.id].isParam;
+}
+
+std::size_t IrFunction::numVars() const {
+  return Vars.size();
+}
+
+std::size_t IrFunction::varSize(IrOperand v) const {
+  return Vars[v.id].size;
+}
+
+IrOperand IrFunction::newTemp() {
+  ++NumTempsCreated;
+  return IrOperand(IrOperand::TEMP, ++NumTemps);
+}
+
+IrOperand IrFunction::newLabel(const char * prefix) {
+  LabelPrefix.push_back(prefix);
+  return IrOperand(IrOperand::LABEL, LabelPrefix.size() - 1);
+}
+
+IrOperand IrFunction::constant(const std::string & text) {
+  auto it = ConstIndex.find(text);
+  if (it != ConstIndex.end())
+    return IrOperand(IrOperand::CONST, it->second);
+  uint32_t id = Consts.size();
+  Consts.push_back(text);
+  ConstIndex.emplace(text, id);
+  return IrOperand(IrOperand::CONST, id);
+}
+
+std::size_t IrFunction::numTemps() const {
+  return NumTemps;
+}
+
+void IrFunction::renameTemps(const std::vector<uint32_t> & newId, uint32_t count) {
+  for (IrInstr & i : Code)
+    for (IrOperand & o : i.arg)
+      if (o.isTemp())
+        o.id = newId[o.id];
+  NumTemps = count;
+}
+
+std::size_t IrFunction::numTempsCreated() const {
+  return NumTempsCreated;
+}
+
+IrList & IrFunction::instructions() {
+  return Code;
+}
+
+const IrList & IrFunction::instructions() const {
+  return Code;
+}
+
+std::string IrFunction::operandText(IrOperand o) const {
+  switch (o.kind) {
+  case IrOperand::NONE:  return "";
+  case IrOperand::TEMP:  return "%t" + std::to_string(o.id);
+  case IrOperand::VAR:   return Vars[o.id].name;
+  case IrOperand::IMM:   return std::to_string(o.immValue());
+  case IrOperand::CONST: return Consts[o.id];
+  case IrOperand::LABEL: return LabelPrefix[o.id] + std::to_string(o.id);
+  }
+  return "";
+}
+
+std::string IrFunction::instrText(const IrInstr & i) const {
+  std::string text = IrInstr::opName(i.op);
+  for (const IrOperand & o : i.arg)
+    if (not o.isNone())
+      text += " " + operandText(o);
+  return text;
+}
+
+subroutine IrFunction::toSubroutine() const {
+  subroutine subr(Name);
+  for (const Var & v : Vars) {
+    if (v.isParam)
+      subr.add_param(v.name);
+    else
+      subr.add_var(v.name, v.size);
+  }
+  instructionList code;
+  for (const IrInstr & i : Code) {
+    std::string a1 = operandText(i.arg[0]);
+    std::string a2 = operandText(i.arg[1]);
+    std::string a3 = operandText(i.arg[2]);
+    switch (i.op) {
+    case IrOp::LABEL:   code.push_back(instruction::LABEL(a1));          break;
+    case IrOp::UJUMP:   code.push_back(instruction::UJUMP(a1));          break;
+    case IrOp::FJUMP:   code.push_back(instruction::FJUMP(a1, a2));      break;
+    case IrOp::LOAD:    code.push_back(instruction::LOAD(a1, a2));       break;
+    case IrOp::ILOAD:   code.push_back(instruction::ILOAD(a1, a2));      break;
+    case IrOp::FLOAD:   code.push_back(instruction::FLOAD(a1, a2));      break;
+    case IrOp::CHLOAD:  code.push_back(instruction::CHLOAD(a1, a2));     break;
+    case IrOp::ALOAD:   code.push_back(instruction::ALOAD(a1, a2));      break;
+    case IrOp::LOADX:   code.push_back(instruction::LOADX(a1, a2, a3));  break;
+    case IrOp::XLOAD:   code.push_back(instruction::XLOAD(a1, a2, a3));  break;
+    case IrOp::READI:   code.push_back(instruction::READI(a1));          break;
+    case IrOp::READF:   code.push_back(instruction::READF(a1));          break;
+    case IrOp::READC:   code.push_back(instruction::READC(a1));          break;
+    case IrOp::WRITEI:  code.push_back(instruction::WRITEI(a1));         break;
+    case IrOp::WRITEF:  code.push_back(instruction::WRITEF(a1));         break;
+    case IrOp::WRITEC:  code.push_back(instruction::WRITEC(a1));         break;
+    case IrOp::WRITELN: code.push_back(instruction::WRITELN());          break;
+    case IrOp::ADD:     code.push_back(instruction::ADD(a1, a2, a3));    break;
+    case IrOp::SUB:     code.push_back(instruction::SUB(a1, a2, a3));    break;
+    case IrOp::MUL:     code.push_back(instruction::MUL(a1, a2, a3));    break;
+    case IrOp::DIV:     code.push_back(instruction::DIV(a1, a2, a3));    break;
+    case IrOp::NEG:     code.push_back(instruction::NEG(a1, a2));        break;
+    case IrOp::EQ:      code.push_back(instruction::EQ(a1, a2, a3));     break;
+    case IrOp::LT:      code.push_back(instruction::LT(a1, a2, a3));     break;
+    case IrOp::LE:      code.push_back(instruction::LE(a1, a2, a3));     break;
+    case IrOp::AND:     code.push_back(instruction::AND(a1, a2, a3));    break;
+    case IrOp::OR:      code.push_back(instruction::OR(a1, a2, a3));     break;
+    case IrOp::NOT:     code.push_back(instruction::NOT(a1, a2));        break;
+    case IrOp::FADD:    code.push_back(instruction::FADD(a1, a2, a3));   break;
+    case IrOp::FSUB:    code.push_back(instruction::FSUB(a1, a2, a3));   break;
+    case IrOp::FMUL:    code.push_back(instruction::FMUL(a1, a2, a3));   break;
+    case IrOp::FDIV:    code.push_back(instruction::FDIV(a1, a2, a3));   break;
+    case IrOp::FNEG:    code.push_back(instruction::FNEG(a1, a2));       break;
+    case IrOp::FEQ:     code.push_back(instruction::FEQ(a1, a2, a3));    break;
+    case IrOp::FLT:     code.push_back(instruction::FLT(a1, a2, a3));    break;
+    case IrOp::FLE:     code.push_back(instruction::FLE(a1, a2, a3));    break;
+    case IrOp::FLOAT:   code.push_back(instruction::FLOAT(a1, a2));      break;
+    case IrOp::PUSH:
+      code.push_back(i.arg[0].isNone() ? instruction::PUSH() : instruction::PUSH(a1));
+      break;
+    case IrOp::POP:
+      code.push_back(i.arg[0].isNone() ? instruction::POP() : instruction::POP(a1));
+      break;
+    case IrOp::CALL:    code.push_back(instruction::CALL(a1));           break;
+    case IrOp::RETURN:  code.push_back(instruction::RETURN());           break;
+    }
+  }
+  subr.set_instructions(code);
+  return subr;
+}
@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IrCode - Intermediate form of the generated code,
+//           with integer operands
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../common/code.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>    // uint8_t, uint32_t, int32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IrOperand: an operand of an IrInstr. It is a kind and an
+// integer: the number of a temporary, the slot of a parameter or a
+// local variable of the function, an immediate integer, the index of
+// a literal in the constant pool of the function, or a label. It is
+// only converted to text when the function is written out.
+
+class IrOperand {
+
+public:
+
+  enum Kind : uint8_t {
+    NONE,     // no operand
+    TEMP,     // temporary %t<id>
+    VAR,      // parameter or local variable (slot of the IrFunction)
+    IMM,      // immediate integer value
+    CONST,    // literal or name in the constant pool of the IrFunction
+    LABEL     // label of the IrFunction
+  };
+
+  IrOperand() : kind(NONE), id(0) {}
+  IrOperand(Kind k, uint32_t i) : kind(k), id(i) {}
+
+  static IrOperand none();
+  static IrOperand imm(int32_t value);
+
+  bool    isNone()  const { return kind == NONE; }
+  bool    isTemp()  const { return kind == TEMP; }
+  bool    isVar()   const { return kind == VAR; }
+  bool    isImm()   const { return kind == IMM; }
+  int32_t immValue() const { return static_cast<int32_t>(id); }
+
+  bool operator==(const IrOperand & o) const { return kind == o.kind and id == o.id; }
+  bool operator!=(const IrOperand & o) const { return not (*this == o); }
+
+  Kind     kind;
+  uint32_t id;
+
+};  // class IrOperand
+
+
+//////////////////////////////////////////////////////////////////////
+// Operation codes of the instructions: the t-code instructions that
+// the code generator emits (see instruction in ../common/code.h)
+
+enum class IrOp : uint8_t {
+  LABEL, UJUMP, FJUMP,
+  LOAD, ILOAD, FLOAD, CHLOAD, ALOAD, LOADX, XLOAD,
+  READI, READF, READC, WRITEI, WRITEF, WRITEC, WRITELN,
+  ADD, SUB, MUL, DIV, NEG, EQ, LT, LE, AND, OR, NOT,
+  FADD, FSUB, FMUL, FDIV, FNEG, FEQ, FLT, FLE, FLOAT,
+  PUSH, POP, CALL, RETURN
+};
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IrInstr: an instruction with integer operands. The builders
+// have the names and the argument order of those of instruction.
+
+class IrInstr {
+
+public:
+
+  IrInstr(IrOp op, IrOperand a1 = IrOperand(), IrOperand a2 = IrOperand(),
+          IrOperand a3 = IrOperand());
+
+  static IrInstr LABEL   (IrOperand l);
+  static IrInstr UJUMP   (IrOperand l);
+  static IrInstr FJUMP   (IrOperand x, IrOperand l);
+  static IrInstr LOAD    (IrOperand d, IrOperand s);
+  static IrInstr ILOAD   (IrOperand d, IrOperand v);
+  static IrInstr FLOAD   (IrOperand d, IrOperand v);
+  static IrInstr CHLOAD  (IrOperand d, IrOperand v);
+  static IrInstr ALOAD   (IrOperand d, IrOperand a);
+  static IrInstr LOADX   (IrOperand d, IrOperand a, IrOperand o);
+  static IrInstr XLOAD   (IrOperand a, IrOperand o, IrOperand s);
+  static IrInstr READI   (IrOperand d);
+  static IrInstr READF   (IrOperand d);
+  static IrInstr READC   (IrOperand d);
+  static IrInstr WRITEI  (IrOperand x);
+  static IrInstr WRITEF  (IrOperand x);
+  static IrInstr WRITEC  (IrOperand x);
+  static IrInstr WRITELN ();
+  static IrInstr ADD     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr SUB     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr MUL     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr DIV     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr NEG     (IrOperand d, IrOperand x);
+  static IrInstr EQ      (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr LT      (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr LE      (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr AND     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr OR      (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr NOT     (IrOperand d, IrOperand x);
+  static IrInstr FADD    (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FSUB    (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FMUL    (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FDIV    (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FNEG    (IrOperand d, IrOperand x);
+  static IrInstr FEQ     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FLT     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FLE     (IrOperand d, IrOperand x, IrOperand y);
+  static IrInstr FLOAT   (IrOperand d, IrOperand x);
+  static IrInstr PUSH    (IrOperand x = IrOperand());
+  static IrInstr POP     (IrOperand d = IrOperand());
+  static IrInstr CALL    (IrOperand f);
+  static IrInstr RETURN  ();
+
+  // Whether the first operand is written by the instruction (e.g.
+  // the destination of ADD or LOADX, but not the array of XLOAD)
+  bool definesFirst() const;
+  // Operands read by the instruction (values and addresses)
+  std::size_t uses(IrOperand out[3]) const;
+  // Positions in arg of the operands read, of any kind (so that they
+  // can be replaced)
+  std::size_t usePositions(std::size_t out[3]) const;
+  // Name of the operation, as in the t-code
+  static const char * opName(IrOp op);
+
+  IrOp      op;
+  IrOperand arg[3];
+
+};  // class IrInstr
+
+// The instructions of a piece of code. It is a list, so that pieces
+// are joined by splicing them in constant time.
+typedef std::list<IrInstr> IrList;
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IrFunction: the code of a function being generated, with the
+// tables its operands refer to (variables, constants and labels) and
+// the counters of temporaries and labels. When it is complete it is
+// converted once to a textual subroutine of ../common/code.h.
+
+class IrFunction {
+
+public:
+
+  // Constructor
+  IrFunction(const std::string & name = "");
+
+  // Start a new function, dropping everything of the previous one
+  void reset(const std::string & name);
+  const std::string & name() const;
+
+  // Parameters (in order) and local variables; a VAR operand is
+  // returned for each
+  IrOperand addParam(const std::string & name);
+  IrOperand addVar(const std::string & name, std::size_t size);
+  bool      isParam(IrOperand v) const;
+  std::size_t numVars() const;
+  // Number of elements of a local variable (1 for a parameter)
+  std::size_t varSize(IrOperand v) const;
+
+  // A new temporary, a new label and a literal of the constant pool
+  // (equal texts share the same entry)
+  IrOperand newTemp();
+  IrOperand newLabel(const char * prefix);
+  IrOperand constant(const std::string & text);
+  std::size_t numTemps() const;
+  // Give the temporaries of the code the numbers newId[t] (1 to
+  // count): numTemps() becomes count. numTempsCreated() is still the
+  // number of temporaries created by newTemp
+  void renameTemps(const std::vector<uint32_t> & newId, uint32_t count);
+  std::size_t numTempsCreated() const;
+
+  // The instructions of the function
+  IrList &       instructions();
+  const IrList & instructions() const;
+
+  // Text of an operand, as written in the t-code
+  std::string operandText(IrOperand o) const;
+  // Text of an instruction, for the debug dumps
+  std::string instrText(const IrInstr & i) const;
+
+  // The function as a subroutine of the t-code
+  subroutine toSubroutine() const;
+
+private:
+
+  struct Var {
+    std::string name;
+    std::size_t size;     // number of elements (locals only)
+    bool        isParam;
+  };
+
+  // Attributes
+  std::string                             Name;
+  std::vector<Var>                        Vars;
+  std::vector<std::string>                Consts;
+  std::unordered_map<std::string, uint32_t> ConstIndex;
+  std::vector<const char *>               LabelPrefix;
+  uint32_t                                NumTemps;
+  uint32_t                                NumTempsCreated;
+  IrList                                  Code;
+
+};  // class IrFunction
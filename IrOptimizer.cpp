@@ -0,0 +1,199 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IrOptimizer - The optimization passes run on the code of
+//               each function before it is written out
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrOptimizer.h"
+
+#include "IrCode.h"
+#include "ConstantFolder.h"
+#include "DeadCodeEliminator.h"
+#include "Peephole.h"
+#include "TempAllocator.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "ValueNumbering.h"
+#include "LoopInvariantMotion.h"
+#include "StrengthReduction.h"
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <iostream>
+#include <algorithm>  // std::stable_sort
+#include <cstdlib>    // std::abort
+#include <cstddef>    // std::size_t
+
+
+// The work allowed to place the phis of the SSA form, by instruction
+// of the function (and at least)
+static const std::size_t SsaBudgetPerInstr = 16;
+static const std::size_t SsaBudgetMin      = 4096;
+
+// Check the SSA form, or the graph once the form is lowered, after
+// 'pass', if asked to
+static void internalError(const IrFunction & fn, const char * pass,
+                          const std::string & error) {
+  std::cerr << "internal error in " << fn.name() << " after " << pass
+            << ": " << error << std::endl;
+}
+
+static void check(bool verify, const SsaForm & ssa, const IrFunction & fn,
+                  const char * pass) {
+  std::string error;
+  if (not verify or ssa.verify(error))
+    return;
+  internalError(fn, pass, error);
+  ssa.dump(std::cerr);
+  std::abort();
+}
+
+static void check(bool verify, const ControlFlowGraph & cfg,
+                  const IrFunction & fn, const char * pass) {
+  std::string error;
+  if (not verify or cfg.verify(error))
+    return;
+  internalError(fn, pass, error);
+  cfg.dump(std::cerr);
+  std::abort();
+}
+
+// Constructor
+IrOptimizer::IrOptimizer(unsigned int Level, bool Verify) :
+  Level{Level},
+  Verify{Verify},
+  Loops{0},
+  LoopsHoisted{0},
+  Hoisted{0},
+  Reduced{0},
+  InductionsRemoved{0} {
+  for (std::size_t p = 0; p < Peephole::NumPatterns; ++p)
+    Fired[p] = 0;
+}
+
+void IrOptimizer::run(IrFunction & fn) const {
+  if (Level == 0)
+    return;
+  ConstantFolder(fn).run();
+  // after the folder, which turns branches on constants into UJUMPs,
+  // and before the removal of what becomes dead or unreachable
+  runPeephole(fn);
+  DeadCodeEliminator(fn).run();
+  if (Level >= 2)
+    runGlobal(fn);
+  // the last one: the temporaries are not renamed after it
+  TempAllocator(fn).run();
+}
+
+unsigned int IrOptimizer::level() const {
+  return Level;
+}
+
+uint64_t IrOptimizer::fired(Peephole::Pattern p) const {
+  return Fired[p];
+}
+
+uint64_t IrOptimizer::loops() const {
+  return Loops;
+}
+
+uint64_t IrOptimizer::loopsHoisted() const {
+  return LoopsHoisted;
+}
+
+uint64_t IrOptimizer::hoisted() const {
+  return Hoisted;
+}
+
+std::vector<IrOptimizer::LoopHoisted> IrOptimizer::hoistedByLoop() const {
+  std::vector<LoopHoisted> log;
+  {
+    std::lock_guard<std::mutex> lock(LoopsMutex);
+    log = LoopLog;
+  }
+  // the functions may have been optimized at once, in any order
+  std::stable_sort(log.begin(), log.end(), [](const LoopHoisted & a, const LoopHoisted & b) {
+    return a.function < b.function;
+  });
+  return log;
+}
+
+uint64_t IrOptimizer::reduced() const {
+  return Reduced;
+}
+
+uint64_t IrOptimizer::inductionsRemoved() const {
+  return InductionsRemoved;
+}
+
+void IrOptimizer::runPeephole(IrFunction & fn) const {
+  Peephole peephole(fn);
+  peephole.run();
+  for (std::size_t p = 0; p < Peephole::NumPatterns; ++p)
+    Fired[p] += peephole.fired(Peephole::Pattern(p));
+}
+
+void IrOptimizer::runGlobal(IrFunction & fn) const {
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  if (not ssa.build(SsaBudgetPerInstr * fn.instructions().size() + SsaBudgetMin)) {
+    // the graph may have put an entry label before the code
+    runPeephole(fn);
+    return;
+  }
+  check(Verify, ssa, fn, "building the SSA form");
+  ValueNumbering(fn, cfg, ssa).run();
+  check(Verify, ssa, fn, "value numbering");
+  LoopInvariantMotion licm(fn, cfg, ssa);
+  licm.run();
+  check(Verify, ssa, fn, "loop invariant code motion");
+  std::vector<LoopHoisted> log;
+  for (std::size_t i = 0; i < licm.hoisted().size(); ++i) {
+    std::size_t n = licm.hoisted()[i];
+    ++Loops;
+    if (n > 0) {
+      ++LoopsHoisted;
+      Hoisted += n;
+    }
+    log.push_back(LoopHoisted{fn.name(), fn.operandText(licm.headers()[i]), n});
+  }
+  if (not log.empty()) {
+    std::lock_guard<std::mutex> lock(LoopsMutex);
+    LoopLog.insert(LoopLog.end(), log.begin(), log.end());
+  }
+  StrengthReduction reduction(fn, cfg, ssa);
+  reduction.run();
+  check(Verify, ssa, fn, "strength reduction");
+  Reduced += reduction.numReduced();
+  InductionsRemoved += reduction.numRemoved();
+  ssa.lower();
+  check(Verify, cfg, fn, "lowering the SSA form");
+  // the copies of the phis are mostly folded into the definitions
+  runPeephole(fn);
+  DeadCodeEliminator(fn).run();
+}
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IrOptimizer - The optimization passes run on the code of
+//               each function before it is written out
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+#include "Peephole.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>    // uint64_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IrOptimizer: runs the optimization passes over the code of a
+// complete function, before it is converted to a subroutine. It only
+// keeps the options, the counters of the passes (atomic) and the log
+// of the loops (under a mutex), so one optimizer can be shared by the
+// code generators of several functions at once.
+//  - Level 1: the passes within the blocks and the peephole.
+//  - Level 2: also the passes over the SSA form of the function
+//    (ControlFlowGraph and SsaForm), if it can be built within the
+//    budget of work. With 'Verify' the graph and the form are checked
+//    after each of these passes; a failure is an internal error, which
+//    is reported with a dump of the function and aborts.
+
+class IrOptimizer {
+
+public:
+
+  // Constructor: level 0 disables every pass
+  IrOptimizer(unsigned int Level = 1, bool Verify = false);
+
+  // Optimize the code of 'fn'
+  void run(IrFunction & fn) const;
+
+  unsigned int level() const;
+
+  // Times that a peephole pattern has fired, in all the functions
+  uint64_t fired(Peephole::Pattern p) const;
+  // The loops seen by the loop invariant code motion, those out of
+  // which some instruction was hoisted, and the instructions hoisted
+  uint64_t loops() const;
+  uint64_t loopsHoisted() const;
+  uint64_t hoisted() const;
+  // The same, loop by loop: the function, the label of the loop header
+  // and the instructions hoisted. By function name, and in the order
+  // of the pass within a function
+  struct LoopHoisted {
+    std::string function;
+    std::string header;
+    uint64_t    hoisted;
+  };
+  std::vector<LoopHoisted> hoistedByLoop() const;
+  // The multiplications of induction variables reduced to additions,
+  // and the induction variables removed
+  uint64_t reduced() const;
+  uint64_t inductionsRemoved() const;
+
+private:
+
+  void runPeephole(IrFunction & fn) const;
+  void runGlobal(IrFunction & fn) const;
+
+  // Attributes
+  unsigned int Level;
+  bool         Verify;
+  mutable std::atomic<uint64_t> Fired[Peephole::NumPatterns];
+  mutable std::atomic<uint64_t> Loops;
+  mutable std::atomic<uint64_t> LoopsHoisted;
+  mutable std::atomic<uint64_t> Hoisted;
+  mutable std::atomic<uint64_t> Reduced;
+  mutable std::atomic<uint64_t> InductionsRemoved;
+  mutable std::mutex               LoopsMutex;
+  mutable std::vector<LoopHoisted> LoopLog;
+
+};  // class IrOptimizer
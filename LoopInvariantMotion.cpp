@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    LoopInvariantMotion - Hoists the computations that do
+//               not change in a loop out of it
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "LoopInvariantMotion.h"
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "DeadCodeEliminator.h"
+
+#include <vector>
+#include <iterator>   // std::next
+#include <cstddef>    // std::size_t
+
+
+// Constructor
+LoopInvariantMotion::LoopInvariantMotion(IrFunction & Fn, ControlFlowGraph & Cfg,
+                                         SsaForm & Ssa) :
+  Fn(Fn),
+  Cfg(Cfg),
+  Ssa(Ssa) {
+}
+
+bool LoopInvariantMotion::run() {
+  Hoisted.clear();
+  Headers.clear();
+  std::vector<ControlFlowGraph::Loop> loops = Cfg.loops();
+  bool changed = false;
+  for (const ControlFlowGraph::Loop & loop : loops) {
+    BlockId preheader = Cfg.preheader(loop, loops);
+    if (preheader == ControlFlowGraph::NoBlock)
+      continue;
+    // a header is reached by a jump, so it starts with its label
+    Headers.push_back(Cfg.block(loop.header).begin->arg[0]);
+    Hoisted.push_back(hoist(loop, preheader));
+    if (Hoisted.back() > 0)
+      changed = true;
+  }
+  return changed;
+}
+
+const std::vector<std::size_t> & LoopInvariantMotion::hoisted() const {
+  return Hoisted;
+}
+
+const std::vector<IrOperand> & LoopInvariantMotion::headers() const {
+  return Headers;
+}
+
+std::size_t LoopInvariantMotion::hoist(const ControlFlowGraph::Loop & loop,
+                                       BlockId preheader) {
+  std::vector<char> inLoop(Cfg.numBlocks(), false);
+  for (BlockId b : loop.blocks)
+    inLoop[b] = true;
+  // the variables written in the loop
+  std::vector<char> written(Fn.numVars(), false);
+  for (BlockId b : loop.blocks)
+    for (IrList::iterator it = Cfg.block(b).begin; it != Cfg.block(b).end; ++it)
+      if (it->definesFirst() and it->arg[0].isVar())
+        written[it->arg[0].id] = true;
+
+  // the blocks in reverse postorder, so that the definitions are seen
+  // before their uses (but for the phis)
+  std::vector<BlockId> blocks;
+  for (BlockId b : Cfg.reversePostorder())
+    if (b < inLoop.size() and inLoop[b])
+      blocks.push_back(b);
+
+  std::size_t numHoisted = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (BlockId b : blocks) {
+      IrList::iterator it = Cfg.block(b).begin;
+      while (it != Cfg.block(b).end) {
+        IrList::iterator next = std::next(it);
+        bool invariant = isSafe(*it) and it->arg[0].isTemp();
+        IrOperand used[3];
+        std::size_t n = invariant ? it->uses(used) : 0;
+        for (std::size_t k = 0; k < n; ++k) {
+          if (used[k].isVar())
+            invariant = invariant and not written[used[k].id];
+          else {
+            BlockId def = Ssa.defBlock(used[k]);
+            invariant = invariant and
+              (def == ControlFlowGraph::NoBlock or not inLoop[def]);
+          }
+        }
+        if (invariant and Cfg.move(b, it, preheader)) {
+          Ssa.setDefBlock(it->arg[0], preheader);
+          ++numHoisted;
+          changed = true;
+        }
+        it = next;
+      }
+    }
+  }
+  return numHoisted;
+}
+
+bool LoopInvariantMotion::isSafe(const IrInstr & i) {
+  switch (i.op) {
+  case IrOp::DIV: case IrOp::FDIV: case IrOp::LOADX:
+    return false;
+  default:
+    return DeadCodeEliminator::isPure(i);
+  }
+}
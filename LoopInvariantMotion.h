@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    LoopInvariantMotion - Hoists the computations that do
+//               not change in a loop out of it
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+
+#include <vector>
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class LoopInvariantMotion: an optimization pass over the SSA form of
+// a function. An instruction of a loop is invariant if it has no side
+// effects and its operands are constants, temporaries defined out of
+// the loop or by invariant instructions, or variables (parameters)
+// that the loop does not write: it is moved to the preheader of the
+// loop, so it runs once. The loops are taken from the inner ones out,
+// so an instruction can leave several loops.
+//  - The preheader is the only block out of the loop that leads to
+//    its header, or a new block on that edge. A loop with several
+//    entries is left as it is.
+//  - The loop may run no iteration, and the instruction may be under a
+//    condition in it, so it must not be able to fail: divisions and
+//    reads of arrays (whose index may be out of range) stay.
+
+class LoopInvariantMotion {
+
+public:
+
+  // Constructor
+  LoopInvariantMotion(IrFunction & Fn, ControlFlowGraph & Cfg, SsaForm & Ssa);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+  // The number of instructions hoisted out of each loop (with a
+  // preheader) of the function, and the label of the header of each
+  // one of those loops
+  const std::vector<std::size_t> & hoisted() const;
+  const std::vector<IrOperand> &   headers() const;
+
+private:
+
+  typedef ControlFlowGraph::BlockId BlockId;
+
+  std::size_t hoist(const ControlFlowGraph::Loop & loop, BlockId preheader);
+  // Whether the instruction can run where it did not, without failing
+  static bool isSafe(const IrInstr & i);
+
+  // Attributes
+  IrFunction &             Fn;
+  ControlFlowGraph &       Cfg;
+  SsaForm &                Ssa;
+  std::vector<std::size_t> Hoisted;
+  std::vector<IrOperand>   Headers;
+
+};  // class LoopInvariantMotion
@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    MappedCharStream - Character stream over the bytes of the
+//                       source, without decoding nor copying it
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "MappedCharStream.h"
+
+#include "antlr4-runtime.h"
+
+#include <algorithm>  // std::min
+
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+
+
+// Constructor
+MappedCharStream::MappedCharStream() :
+  Data{""},
+  Size{0},
+  Pos{0},
+  Mapping{nullptr} {
+}
+
+// Destructor
+MappedCharStream::~MappedCharStream() {
+  close();
+}
+
+bool MappedCharStream::openFile(const std::string & fileName) {
+  close();
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 or not S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  Name = fileName;
+  if (st.st_size > 0) {
+    void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    // the lexer goes through the source once, from the beginning to the end
+    ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+    Mapping = p;
+    Data = static_cast<const char *>(p);
+    Size = st.st_size;
+  }
+  // the mapping remains valid after closing the descriptor
+  ::close(fd);
+  return true;
+}
+
+bool MappedCharStream::readStream(std::istream & is, const std::string & name) {
+  close();
+  char chunk[1 << 16];
+  while (is.read(chunk, sizeof(chunk)) or is.gcount() > 0)
+    Buffer.append(chunk, is.gcount());
+  if (is.bad())
+    return false;
+  Name = name;
+  Data = Buffer.data();
+  Size = Buffer.size();
+  return true;
+}
+
+void MappedCharStream::setSource(std::string && source, const std::string & name) {
+  close();
+  Buffer.swap(source);
+  Name = name;
+  Data = Buffer.data();
+  Size = Buffer.size();
+}
+
+void MappedCharStream::close() {
+  if (Mapping)
+    ::munmap(Mapping, Size);
+  Mapping = nullptr;
+  Buffer.clear();
+  Data = "";
+  Size = 0;
+  Pos = 0;
+}
+
+void MappedCharStream::consume() {
+  if (Pos >= Size)
+    throw antlr4::IllegalStateException("cannot consume EOF");
+  ++Pos;
+}
+
+std::size_t MappedCharStream::LA(ssize_t i) {
+  if (i == 0)
+    return 0;   // undefined
+  ssize_t pos = static_cast<ssize_t>(Pos);
+  if (i < 0) {
+    ++i;        // e.g., translate LA(-1) to use offset i=0; then Data[Pos+0-1]
+    if (pos + i - 1 < 0)
+      return antlr4::IntStream::EOF;
+  }
+  if (pos + i - 1 >= static_cast<ssize_t>(Size))
+    return antlr4::IntStream::EOF;
+  return static_cast<unsigned char>(Data[pos + i - 1]);
+}
+
+// Nothing to do: the whole source is always available
+ssize_t MappedCharStream::mark() {
+  return -1;
+}
+void MappedCharStream::release(ssize_t marker) {
+}
+
+std::size_t MappedCharStream::index() {
+  return Pos;
+}
+
+void MappedCharStream::seek(std::size_t index) {
+  Pos = std::min(index, Size);
+}
+
+std::size_t MappedCharStream::size() {
+  return Size;
+}
+
+std::string MappedCharStream::getSourceName() const {
+  if (Name.empty())
+    return antlr4::IntStream::UNKNOWN_SOURCE_NAME;
+  return Name;
+}
+
+std::string MappedCharStream::getText(const antlr4::misc::Interval & interval) {
+  if (interval.a < 0 or interval.b < interval.a or
+      static_cast<std::size_t>(interval.a) >= Size)
+    return "";
+  std::size_t start = interval.a;
+  std::size_t stop  = std::min(static_cast<std::size_t>(interval.b), Size - 1);
+  return std::string(Data + start, stop - start + 1);
+}
+
+std::string MappedCharStream::toString() const {
+  return std::string(Data, Size);
+}
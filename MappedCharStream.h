@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    MappedCharStream - Character stream over the bytes of the
+//                       source, without decoding nor copying it
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "antlr4-runtime.h"
+
+#include <string>
+#include <istream>
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class MappedCharStream: derived from antlr4::CharStream.
+// A character stream that the lexer reads directly from the bytes of
+// the source. A file is mapped in memory (mmap) and the standard
+// input is read once into a single buffer. Unlike ANTLRInputStream
+// the source is neither copied nor decoded to UTF-32: each byte is a
+// symbol of the stream. The Asl lexical rules only use ASCII, so the
+// tokens are the same; the bytes of a non-ASCII character inside a
+// string or a comment are just passed through.
+
+class MappedCharStream final : public antlr4::CharStream {
+
+public:
+
+  // Constructor (empty stream) and destructor (unmaps the file)
+  MappedCharStream();
+  ~MappedCharStream();
+
+  MappedCharStream(const MappedCharStream &) = delete;
+  MappedCharStream & operator=(const MappedCharStream &) = delete;
+
+  // Map the file in memory. Returns false if it can not be opened
+  bool openFile(const std::string & fileName);
+  // Read the whole stream (e.g. std::cin) into the internal buffer
+  bool readStream(std::istream & is, const std::string & name = "<stdin>");
+  // Take the source from a string (moved, not copied) as the buffer
+  void setSource(std::string && source, const std::string & name);
+
+  // Methods of antlr4::IntStream
+  void        consume() override;
+  std::size_t LA(ssize_t i) override;
+  ssize_t     mark() override;
+  void        release(ssize_t marker) override;
+  std::size_t index() override;
+  void        seek(std::size_t index) override;
+  std::size_t size() override;
+  std::string getSourceName() const override;
+
+  // Methods of antlr4::CharStream
+  std::string getText(const antlr4::misc::Interval & interval) override;
+  std::string toString() const override;
+
+private:
+
+  // Unmap the file (if any) and leave the stream empty
+  void close();
+
+  const char  * Data;         // first byte of the source
+  std::size_t   Size;         // number of bytes of the source
+  std::size_t   Pos;          // index of the next byte to consume
+  void        * Mapping;      // mmap'ed region (nullptr if none)
+  std::string   Buffer;       // the source when read from a stream
+  std::string   Name;         // name of the source
+
+};  // class MappedCharStream
@@ -0,0 +1,145 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    NodeDecorations - Attributes of the nodes of the AST,
+//           stored densely by node number
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "NodeDecorations.h"
+#include "AslAst.h"
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "IrCode.h"
+#include "SymbolIndex.h"
+
+#include <cstddef>    // std::size_t
+#include <algorithm>  // std::sort, std::unique
+
+
+// Constructor
+NodeDecorations::NodeDecorations(std::size_t numNodes) {
+  resize(numNodes);
+}
+
+void NodeDecorations::resize(std::size_t numNodes) {
+  Stored.resize(numNodes, 0);
+  Scope.resize(numNodes);
+  Type.resize(numNodes);
+  IsLValue.resize(numNodes, false);
+  Symbol.resize(numNodes);
+  Addr.resize(numNodes);
+  Offset.resize(numNodes);
+  Code.resize(numNodes);
+}
+
+std::size_t NodeDecorations::size() const {
+  return Scope.size();
+}
+
+void NodeDecorations::release(std::size_t first, std::size_t last) {
+  for (std::size_t n = first; n < last; ++n) {
+    Stored[n]   = 0;
+    Scope[n]    = SymTable::ScopeId();
+    Type[n]     = TypesMgr::TypeId();
+    IsLValue[n] = false;
+    Symbol[n]   = SymbolHandle();
+    Addr[n]     = IrOperand();
+    Offset[n]   = IrOperand();
+    IrList().swap(Code[n]);
+  }
+}
+
+std::size_t NodeDecorations::numStored() const {
+  std::size_t count = 0;
+  for (uint8_t bits : Stored)
+    for (; bits != 0; bits &= bits - 1)
+      ++count;
+  return count;
+}
+
+std::size_t NodeDecorations::numTypes() const {
+  std::vector<TypesMgr::TypeId> types;
+  for (std::size_t n = 0; n < Type.size(); ++n)
+    if (Stored[n] & TYPE)
+      types.push_back(Type[n]);
+  std::sort(types.begin(), types.end());
+  return std::unique(types.begin(), types.end()) - types.begin();
+}
+
+// Getters
+SymTable::ScopeId NodeDecorations::getScope(AslAst::NodeId n) const {
+  return Scope[n];
+}
+TypesMgr::TypeId NodeDecorations::getType(AslAst::NodeId n) const {
+  return Type[n];
+}
+bool NodeDecorations::getIsLValue(AslAst::NodeId n) const {
+  return IsLValue[n];
+}
+SymbolHandle NodeDecorations::getSymbol(AslAst::NodeId n) const {
+  return Symbol[n];
+}
+IrOperand NodeDecorations::getAddr(AslAst::NodeId n) const {
+  return Addr[n];
+}
+IrOperand NodeDecorations::getOffset(AslAst::NodeId n) const {
+  return Offset[n];
+}
+IrList NodeDecorations::takeCode(AslAst::NodeId n) {
+  IrList c;
+  c.swap(Code[n]);
+  return c;
+}
+
+// Setters
+void NodeDecorations::putScope(AslAst::NodeId n, SymTable::ScopeId s) {
+  Stored[n] |= SCOPE;
+  Scope[n] = s;
+}
+void NodeDecorations::putType(AslAst::NodeId n, TypesMgr::TypeId t) {
+  Stored[n] |= TYPE;
+  Type[n] = t;
+}
+void NodeDecorations::putIsLValue(AslAst::NodeId n, bool b) {
+  Stored[n] |= LVALUE;
+  IsLValue[n] = b;
+}
+void NodeDecorations::putSymbol(AslAst::NodeId n, SymbolHandle s) {
+  Stored[n] |= SYMBOL;
+  Symbol[n] = s;
+}
+void NodeDecorations::putAddr(AslAst::NodeId n, IrOperand a) {
+  Stored[n] |= ADDR;
+  Addr[n] = a;
+}
+void NodeDecorations::putOffset(AslAst::NodeId n, IrOperand o) {
+  Stored[n] |= OFFSET;
+  Offset[n] = o;
+}
+void NodeDecorations::putCode(AslAst::NodeId n, IrList && c) {
+  Stored[n] |= CODE;
+  Code[n].swap(c);
+}
@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    NodeDecorations - Attributes of the nodes of the AST,
+//           stored densely by node number
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "../common/TypesMgr.h"
+#include "../common/SymTable.h"
+#include "IrCode.h"
+#include "SymbolIndex.h"
+#include "AslAst.h"
+
+#include <vector>
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint8_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class NodeDecorations: the attributes (scope, type, lvalue, symbol,
+// addr, offset and code) of the nodes of the AslAst. Each attribute is
+// a vector indexed by the number of the node (struct of arrays): a get
+// or a put is an array access instead of a search by pointer, and the
+// memory used is fixed by the number of nodes. The code of a node is
+// moved in and taken out, never copied.
+
+class NodeDecorations {
+
+public:
+
+  // Constructor, with room for the attributes of numNodes nodes
+  NodeDecorations(std::size_t numNodes = 0);
+
+  // Set the number of nodes, keeping the attributes already stored
+  void resize(std::size_t numNodes);
+  std::size_t size() const;
+  // Drop the attributes of the nodes [first, last), e.g. a subtree
+  // whose code has already been emitted, releasing their code
+  void release(std::size_t first, std::size_t last);
+  // Number of attributes stored (for the statistics), and number of
+  // different types among them
+  std::size_t numStored() const;
+  std::size_t numTypes() const;
+
+  // Getters
+  SymTable::ScopeId   getScope    (AslAst::NodeId n) const;
+  TypesMgr::TypeId    getType     (AslAst::NodeId n) const;
+  bool                getIsLValue (AslAst::NodeId n) const;
+  SymbolHandle        getSymbol   (AslAst::NodeId n) const;
+  IrOperand           getAddr     (AslAst::NodeId n) const;
+  IrOperand           getOffset   (AslAst::NodeId n) const;
+  // The code is taken out: the node is left with an empty list
+  IrList              takeCode    (AslAst::NodeId n);
+
+  // Setters
+  void putScope    (AslAst::NodeId n, SymTable::ScopeId s);
+  void putType     (AslAst::NodeId n, TypesMgr::TypeId t);
+  void putIsLValue (AslAst::NodeId n, bool b);
+  void putSymbol   (AslAst::NodeId n, SymbolHandle s);
+  void putAddr     (AslAst::NodeId n, IrOperand a);
+  void putOffset   (AslAst::NodeId n, IrOperand o);
+  void putCode     (AslAst::NodeId n, IrList && c);
+
+private:
+
+  // Bits of Stored: the attributes that have been put on a node
+  enum : uint8_t { SCOPE = 1, TYPE = 2, LVALUE = 4, SYMBOL = 8,
+                   ADDR = 16, OFFSET = 32, CODE = 64 };
+
+  // Attributes, one element per node
+  std::vector<uint8_t>           Stored;
+  std::vector<SymTable::ScopeId> Scope;
+  std::vector<TypesMgr::TypeId>  Type;
+  std::vector<char>              IsLValue;
+  std::vector<SymbolHandle>      Symbol;
+  std::vector<IrOperand>         Addr;
+  std::vector<IrOperand>         Offset;
+  std::vector<IrList>            Code;
+
+};  // class NodeDecorations
@@ -0,0 +1,264 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Peephole - Rewrites the short sequences of instructions
+//               of a function that have a better equivalent
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "Peephole.h"
+
+#include "IrCode.h"
+#include "DeadCodeEliminator.h"
+
+#include <vector>
+#include <iterator>   // std::next, std::prev
+#include <cstddef>    // std::size_t
+
+
+// The table of patterns. A pattern can have several rules (e.g. for
+// UJUMP and FJUMP); they are tried in this order at each position.
+const Peephole::Rule Peephole::Rules[] = {
+  { MulByOne,     2, { IrOp::LOAD,   IrOp::MUL    }, false, &Peephole::mulByOne     },
+  { MulByOne,     2, { IrOp::ILOAD,  IrOp::MUL    }, false, &Peephole::mulByOne     },
+  { CopyToDef,    2, { IrOp::LOAD,   IrOp::LOAD   }, true,  &Peephole::copyToDef    },
+  { SelfCopy,     1, { IrOp::LOAD,   IrOp::LOAD   }, false, &Peephole::selfCopy     },
+  { JumpToNext,   2, { IrOp::UJUMP,  IrOp::LABEL  }, false, &Peephole::jumpToNext   },
+  { JumpToNext,   2, { IrOp::FJUMP,  IrOp::LABEL  }, false, &Peephole::jumpToNext   },
+  { JumpToReturn, 1, { IrOp::UJUMP,  IrOp::UJUMP  }, false, &Peephole::jumpToReturn },
+  { JumpToJump,   1, { IrOp::UJUMP,  IrOp::UJUMP  }, false, &Peephole::jumpToJump   },
+  { JumpToJump,   1, { IrOp::FJUMP,  IrOp::FJUMP  }, false, &Peephole::jumpToJump   },
+  { ReturnReturn, 2, { IrOp::RETURN, IrOp::RETURN }, false, &Peephole::returnReturn },
+  { UnusedLabel,  1, { IrOp::LABEL,  IrOp::LABEL  }, false, &Peephole::unusedLabel  },
+};
+
+// The label operand of a jump
+static IrOperand & jumpLabel(IrInstr & i) {
+  return i.op == IrOp::FJUMP ? i.arg[1] : i.arg[0];
+}
+
+const char * Peephole::patternName(Pattern p) {
+  switch (p) {
+  case MulByOne:     return "mul_by_one";
+  case CopyToDef:    return "copy_to_def";
+  case SelfCopy:     return "self_copy";
+  case JumpToNext:   return "jump_to_next";
+  case JumpToJump:   return "jump_to_jump";
+  case JumpToReturn: return "jump_to_return";
+  case ReturnReturn: return "return_return";
+  case UnusedLabel:  return "unused_label";
+  default:           return "";
+  }
+}
+
+// Constructor
+Peephole::Peephole(IrFunction & Fn) :
+  Fn(Fn),
+  Code(Fn.instructions()) {
+  for (std::size_t p = 0; p < NumPatterns; ++p)
+    Fired[p] = 0;
+}
+
+bool Peephole::run() {
+  bool changed = false;
+  while (sweep())
+    changed = true;
+  return changed;
+}
+
+uint64_t Peephole::fired(Pattern p) const {
+  return Fired[p];
+}
+
+bool Peephole::sweep() {
+  // The counts are not updated by the rewrites: they only remove
+  // definitions and uses, so the counts can be too high, which makes
+  // a rule give up until the next sweep, but never too low
+  countOperands();
+  bool changed = false;
+  IrList::iterator it = Code.begin();
+  while (it != Code.end()) {
+    bool fired = false;
+    for (const Rule & rule : Rules) {
+      if (matches(rule, it) and (this->*rule.rewrite)(it)) {
+        ++Fired[rule.pattern];
+        fired = changed = true;
+        break;
+      }
+    }
+    if (not fired)
+      ++it;
+  }
+  return changed;
+}
+
+bool Peephole::matches(const Rule & rule, IrList::iterator it) const {
+  if (rule.anyFirst) {
+    if (not DeadCodeEliminator::isPure(*it))
+      return false;
+  }
+  else if (it->op != rule.ops[0])
+    return false;
+  if (rule.length == 1)
+    return true;
+  IrList::iterator next = std::next(it);
+  return next != Code.end() and next->op == rule.ops[1];
+}
+
+void Peephole::countOperands() {
+  uint32_t numTemps = 0, numLabels = 0;
+  for (const IrInstr & instr : Code)
+    for (const IrOperand & o : instr.arg) {
+      if (o.isTemp() and o.id >= numTemps)
+        numTemps = o.id + 1;
+      else if (o.kind == IrOperand::LABEL and o.id >= numLabels)
+        numLabels = o.id + 1;
+    }
+  TempDefs.assign(numTemps, 0);
+  TempUses.assign(numTemps, 0);
+  LabelUses.assign(numLabels, 0);
+  LabelPos.assign(numLabels, Code.end());
+  for (IrList::iterator it = Code.begin(); it != Code.end(); ++it) {
+    if (it->op == IrOp::LABEL) {
+      LabelPos[it->arg[0].id] = it;
+      continue;
+    }
+    if (it->op == IrOp::UJUMP or it->op == IrOp::FJUMP)
+      ++LabelUses[jumpLabel(*it).id];
+    if (it->definesFirst() and it->arg[0].isTemp())
+      ++TempDefs[it->arg[0].id];
+    IrOperand used[3];
+    std::size_t n = it->uses(used);
+    for (std::size_t k = 0; k < n; ++k)
+      if (used[k].isTemp())
+        ++TempUses[used[k].id];
+  }
+}
+
+IrList::iterator Peephole::jumpTarget(IrOperand l) {
+  IrList::iterator it = LabelPos[l.id];
+  while (it != Code.end() and it->op == IrOp::LABEL)
+    ++it;
+  return it;
+}
+
+IrList::iterator Peephole::eraseLabel(IrList::iterator it) {
+  LabelPos[it->arg[0].id] = Code.end();
+  return Code.erase(it);
+}
+
+// LOAD t 1 (or ILOAD t 1); MUL d x t  =>  LOAD t 1; LOAD d x
+bool Peephole::mulByOne(IrList::iterator & it) {
+  bool one = it->op == IrOp::LOAD ?
+    it->arg[1].isImm() and it->arg[1].immValue() == 1 :
+    Fn.operandText(it->arg[1]) == "1";
+  if (not one)
+    return false;
+  IrInstr & mul = *std::next(it);
+  IrOperand t = it->arg[0];
+  if (mul.arg[2] == t)
+    mul = IrInstr::LOAD(mul.arg[0], mul.arg[1]);
+  else if (mul.arg[1] == t)
+    mul = IrInstr::LOAD(mul.arg[0], mul.arg[2]);
+  else
+    return false;
+  return true;
+}
+
+// ADD t x y; LOAD d t  =>  ADD d x y, if t has no other definition
+// and no other use
+bool Peephole::copyToDef(IrList::iterator & it) {
+  IrList::iterator copy = std::next(it);
+  IrOperand t = it->arg[0];
+  if (not t.isTemp() or copy->arg[1] != t or copy->arg[0] == t or
+      TempDefs[t.id] != 1 or TempUses[t.id] != 1)
+    return false;
+  it->arg[0] = copy->arg[0];
+  Code.erase(copy);
+  return true;
+}
+
+// LOAD x x  =>  (nothing)
+bool Peephole::selfCopy(IrList::iterator & it) {
+  if (it->arg[0] != it->arg[1])
+    return false;
+  it = Code.erase(it);
+  return true;
+}
+
+// UJUMP L (or FJUMP x L); LABEL M; LABEL L  =>  LABEL M; LABEL L
+bool Peephole::jumpToNext(IrList::iterator & it) {
+  IrOperand l = jumpLabel(*it);
+  for (IrList::iterator next = std::next(it);
+       next != Code.end() and next->op == IrOp::LABEL; ++next)
+    if (next->arg[0] == l) {
+      it = Code.erase(it);
+      return true;
+    }
+  return false;
+}
+
+// UJUMP L (or FJUMP x L) ... L: UJUMP M  =>  UJUMP M (or FJUMP x M),
+// following the chain of jumps to its end. A cycle of jumps is left
+// as it is.
+bool Peephole::jumpToJump(IrList::iterator & it) {
+  IrOperand & l = jumpLabel(*it);
+  IrOperand   m = l;
+  for (std::size_t steps = 0; steps < LabelPos.size(); ++steps) {
+    IrList::iterator target = jumpTarget(m);
+    if (target == Code.end() or target->op != IrOp::UJUMP) {
+      if (m == l)
+        return false;
+      l = m;
+      ++LabelUses[m.id];
+      return true;
+    }
+    m = target->arg[0];
+  }
+  return false;
+}
+
+// UJUMP L ... L: RETURN  =>  RETURN
+bool Peephole::jumpToReturn(IrList::iterator & it) {
+  IrList::iterator target = jumpTarget(it->arg[0]);
+  if (target == Code.end() or target->op != IrOp::RETURN)
+    return false;
+  *it = IrInstr::RETURN();
+  return true;
+}
+
+// RETURN; RETURN  =>  RETURN
+bool Peephole::returnReturn(IrList::iterator & it) {
+  Code.erase(std::next(it));
+  return true;
+}
+
+// LABEL L  =>  (nothing), if no jump goes to L
+bool Peephole::unusedLabel(IrList::iterator & it) {
+  if (LabelUses[it->arg[0].id] != 0)
+    return false;
+  it = eraseLabel(it);
+  return true;
+}
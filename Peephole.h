@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    Peephole - Rewrites the short sequences of instructions
+//               of a function that have a better equivalent
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class Peephole: an optimization pass that looks at the code of a
+// function through a window of one or two instructions, and rewrites
+// the sequences matched by a table of patterns (see Rules in the
+// .cpp). The code is swept again until no pattern matches. Each
+// pattern is counted every time it fires, for the statistics.
+
+class Peephole {
+
+public:
+
+  // The patterns of the table
+  enum Pattern {
+    MulByOne,       // LOAD t 1; MUL d x t       =>  LOAD t 1; LOAD d x
+    CopyToDef,      // ADD t x y; LOAD d t       =>  ADD d x y
+                    //   (t is only defined and read there)
+    SelfCopy,       // LOAD x x                  =>
+    JumpToNext,     // UJUMP L; LABEL L          =>  LABEL L
+    JumpToJump,     // UJUMP L ... L: UJUMP M    =>  UJUMP M
+    JumpToReturn,   // UJUMP L ... L: RETURN     =>  RETURN
+    ReturnReturn,   // RETURN; RETURN            =>  RETURN
+    UnusedLabel,    // LABEL L (never jumped to) =>
+    NumPatterns
+  };
+
+  // Name of a pattern, for the statistics
+  static const char * patternName(Pattern p);
+
+  // Constructor
+  Peephole(IrFunction & Fn);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+  // Times that the pattern has fired
+  uint64_t fired(Pattern p) const;
+
+private:
+
+  // A rewrite checks the operands of the instructions matched, at
+  // 'it', and returns false if they do not fit. Otherwise it changes
+  // the code and leaves 'it' where the matching goes on.
+  typedef bool (Peephole::*Rewrite)(IrList::iterator & it);
+
+  struct Rule {
+    Pattern     pattern;
+    std::size_t length;       // instructions of the window
+    IrOp        ops[2];       // their operation codes
+    bool        anyFirst;     // the first one can be any pure instruction
+    Rewrite     rewrite;
+  };
+
+  static const Rule Rules[];
+
+  // One pass over the code
+  bool sweep();
+  bool matches(const Rule & rule, IrList::iterator it) const;
+  // Definitions and uses of the temporaries, uses and positions of
+  // the labels
+  void countOperands();
+  // The first instruction (not a label) at or after label 'l'
+  IrList::iterator jumpTarget(IrOperand l);
+  IrList::iterator eraseLabel(IrList::iterator it);
+
+  bool mulByOne(IrList::iterator & it);
+  bool copyToDef(IrList::iterator & it);
+  bool selfCopy(IrList::iterator & it);
+  bool jumpToNext(IrList::iterator & it);
+  bool jumpToJump(IrList::iterator & it);
+  bool jumpToReturn(IrList::iterator & it);
+  bool returnReturn(IrList::iterator & it);
+  bool unusedLabel(IrList::iterator & it);
+
+  // Attributes
+  IrFunction &                  Fn;
+  IrList &                      Code;
+  std::vector<uint32_t>         TempDefs;
+  std::vector<uint32_t>         TempUses;
+  std::vector<uint32_t>         LabelUses;
+  std::vector<IrList::iterator> LabelPos;
+  uint64_t                      Fired[NumPatterns];
+
+};  // class Peephole
@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SemErrorLog - The semantic errors found on the AslAst,
+//               reported later with SemErrors
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "SemErrorLog.h"
+
+#include "antlr4-runtime.h"
+#include "AslParser.h"
+#include "AslAst.h"
+
+#include "../common/SemErrors.h"
+
+
+void SemErrorLog::undeclaredIdent(AslAst::NodeId n) {
+  add(UndeclaredIdent, n);
+}
+void SemErrorLog::declaredIdent(AslAst::NodeId n, std::size_t i) {
+  add(DeclaredIdent, n, AslAst::NoNode, i);
+}
+void SemErrorLog::incompatibleAssignment(AslAst::NodeId n) {
+  add(IncompatibleAssignment, n);
+}
+void SemErrorLog::nonReferenceableLeftExpr(AslAst::NodeId n) {
+  add(NonReferenceableLeftExpr, n);
+}
+void SemErrorLog::incompatibleOperator(AslAst::NodeId n) {
+  add(IncompatibleOperator, n);
+}
+void SemErrorLog::booleanRequired(AslAst::NodeId n) {
+  add(BooleanRequired, n);
+}
+void SemErrorLog::isNotCallable(AslAst::NodeId n) {
+  add(IsNotCallable, n);
+}
+void SemErrorLog::isNotProcedure(AslAst::NodeId n) {
+  add(IsNotProcedure, n);
+}
+void SemErrorLog::isNotFunction(AslAst::NodeId n) {
+  add(IsNotFunction, n);
+}
+void SemErrorLog::numberOfParameters(AslAst::NodeId n) {
+  add(NumberOfParameters, n);
+}
+void SemErrorLog::incompatibleParameter(AslAst::NodeId n, unsigned int i,
+                                        AslAst::NodeId call) {
+  add(IncompatibleParameter, n, call, i);
+}
+void SemErrorLog::incompatibleReturn(AslAst::NodeId n) {
+  add(IncompatibleReturn, n);
+}
+void SemErrorLog::readWriteRequireBasic(AslAst::NodeId n) {
+  add(ReadWriteRequireBasic, n);
+}
+void SemErrorLog::nonReferenceableExpression(AslAst::NodeId n) {
+  add(NonReferenceableExpression, n);
+}
+void SemErrorLog::nonArrayInArrayAccess(AslAst::NodeId n) {
+  add(NonArrayInArrayAccess, n);
+}
+void SemErrorLog::nonIntegerIndexInArrayAccess(AslAst::NodeId n) {
+  add(NonIntegerIndexInArrayAccess, n);
+}
+void SemErrorLog::noMainProperlyDeclared(AslAst::NodeId n) {
+  add(NoMainProperlyDeclared, n);
+}
+
+std::size_t SemErrorLog::getNumberOfSemanticErrors() const {
+  return Entries.size();
+}
+
+void SemErrorLog::append(const SemErrorLog & other) {
+  Entries.insert(Entries.end(), other.Entries.begin(), other.Entries.end());
+}
+
+// The operator of an expression: its first terminal child, both in
+// the unary and in the binary ones
+static antlr4::Token *operatorToken(antlr4::ParserRuleContext *ctx) {
+  for (auto child : ctx->children)
+    if (antlrcpp::is<antlr4::tree::TerminalNode *>(child))
+      return static_cast<antlr4::tree::TerminalNode *>(child)->getSymbol();
+  return nullptr;
+}
+
+void SemErrorLog::replay(SemErrors & errors,
+                         const std::vector<antlr4::ParserRuleContext *> & contexts) const {
+  for (const Entry & e : Entries) {
+    antlr4::ParserRuleContext *ctx = contexts[e.node];
+    switch (e.kind) {
+    case UndeclaredIdent:
+      errors.undeclaredIdent(ctx->getToken(AslParser::ID, 0));
+      break;
+    case DeclaredIdent:
+      errors.declaredIdent(ctx->getTokens(AslParser::ID)[e.number]);
+      break;
+    case IncompatibleAssignment:
+      errors.incompatibleAssignment(ctx->getToken(AslParser::ASSIGN, 0));
+      break;
+    case NonReferenceableLeftExpr:
+      errors.nonReferenceableLeftExpr(ctx);
+      break;
+    case IncompatibleOperator:
+      errors.incompatibleOperator(operatorToken(ctx));
+      break;
+    case BooleanRequired:
+      errors.booleanRequired(ctx);
+      break;
+    case IsNotCallable:
+      errors.isNotCallable(ctx);
+      break;
+    case IsNotProcedure:
+      errors.isNotProcedure(ctx);
+      break;
+    case IsNotFunction:
+      errors.isNotFunction(ctx);
+      break;
+    case NumberOfParameters:
+      errors.numberOfParameters(ctx);
+      break;
+    case IncompatibleParameter:
+      errors.incompatibleParameter(ctx, e.number, contexts[e.other]);
+      break;
+    case IncompatibleReturn:
+      errors.incompatibleReturn(ctx->getToken(AslParser::RETURN, 0));
+      break;
+    case ReadWriteRequireBasic:
+      errors.readWriteRequireBasic(ctx);
+      break;
+    case NonReferenceableExpression:
+      errors.nonReferenceableExpression(ctx);
+      break;
+    case NonArrayInArrayAccess:
+      errors.nonArrayInArrayAccess(ctx);
+      break;
+    case NonIntegerIndexInArrayAccess:
+      errors.nonIntegerIndexInArrayAccess(ctx);
+      break;
+    case NoMainProperlyDeclared:
+      errors.noMainProperlyDeclared(ctx);
+      break;
+    }
+  }
+}
+
+void SemErrorLog::add(Kind kind, AslAst::NodeId n,
+                      AslAst::NodeId other, uint32_t number) {
+  Entry e;
+  e.kind   = kind;
+  e.node   = n;
+  e.other  = other;
+  e.number = number;
+  Entries.push_back(e);
+}
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SemErrorLog - The semantic errors found on the AslAst,
+//               reported later with SemErrors
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "antlr4-runtime.h"
+#include "AslAst.h"
+
+#include "../common/SemErrors.h"
+
+#include <vector>
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint8_t, uint32_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class SemErrorLog: the semantic errors found by the passes, with the
+// same methods as SemErrors but taking the nodes of the AslAst where
+// SemErrors takes the contexts and the tokens of the parse tree. The
+// parse tree is freed once the AST is built, so the errors are only
+// recorded here. If there are any, the source is parsed again and
+// replay() reports them on a SemErrors, that prints the messages.
+// The replay requires the second parse to give a tree identical, node
+// for node, to the one that was lowered: the same number of contexts,
+// in the same preorder. The caller checks it, at least by the number.
+
+class SemErrorLog {
+
+public:
+
+  // The errors, as in SemErrors. For a node with several identifiers
+  // (a variable_decl), 'i' tells which one
+  void undeclaredIdent              (AslAst::NodeId n);
+  void declaredIdent                (AslAst::NodeId n, std::size_t i = 0);
+  void incompatibleAssignment       (AslAst::NodeId n);
+  void nonReferenceableLeftExpr     (AslAst::NodeId n);
+  void incompatibleOperator         (AslAst::NodeId n);
+  void booleanRequired              (AslAst::NodeId n);
+  void isNotCallable                (AslAst::NodeId n);
+  void isNotProcedure               (AslAst::NodeId n);
+  void isNotFunction                (AslAst::NodeId n);
+  void numberOfParameters           (AslAst::NodeId n);
+  void incompatibleParameter        (AslAst::NodeId n, unsigned int i,
+                                     AslAst::NodeId call);
+  void incompatibleReturn           (AslAst::NodeId n);
+  void readWriteRequireBasic        (AslAst::NodeId n);
+  void nonReferenceableExpression   (AslAst::NodeId n);
+  void nonArrayInArrayAccess        (AslAst::NodeId n);
+  void nonIntegerIndexInArrayAccess (AslAst::NodeId n);
+  void noMainProperlyDeclared       (AslAst::NodeId n);
+
+  std::size_t getNumberOfSemanticErrors() const;
+
+  // Add the errors of 'other' after these
+  void append(const SemErrorLog & other);
+
+  // Report the errors, in the order they were found, on 'errors'.
+  // 'contexts' are the contexts of a parse tree of the same source,
+  // indexed by their node numbers (AslAst::contexts), one for each
+  // node of the AST where the errors were found
+  void replay(SemErrors & errors,
+              const std::vector<antlr4::ParserRuleContext *> & contexts) const;
+
+private:
+
+  enum Kind : uint8_t {
+    UndeclaredIdent, DeclaredIdent, IncompatibleAssignment,
+    NonReferenceableLeftExpr, IncompatibleOperator, BooleanRequired,
+    IsNotCallable, IsNotProcedure, IsNotFunction, NumberOfParameters,
+    IncompatibleParameter, IncompatibleReturn, ReadWriteRequireBasic,
+    NonReferenceableExpression, NonArrayInArrayAccess,
+    NonIntegerIndexInArrayAccess, NoMainProperlyDeclared
+  };
+
+  // An error: its kind, its node and, for the kinds that need them,
+  // the call of a parameter ('other') and the number of the parameter
+  // or of the identifier
+  struct Entry {
+    Kind           kind;
+    AslAst::NodeId node;
+    AslAst::NodeId other;
+    uint32_t       number;
+  };
+
+  void add(Kind kind, AslAst::NodeId n,
+           AslAst::NodeId other = AslAst::NoNode, uint32_t number = 0);
+
+  // Attributes
+  std::vector<Entry> Entries;
+
+};  // class SemErrorLog
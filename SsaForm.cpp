@@ -0,0 +1,477 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SsaForm - The static single assignment form of the
+//               code of a function, and its way back
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "SsaForm.h"
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <utility>    // std::pair
+#include <algorithm>  // std::find, std::remove_if
+#include <iterator>   // std::distance
+#include <climits>    // LONG_MAX
+#include <cstddef>    // std::size_t
+
+
+const uint32_t SsaForm::NoName;
+
+static std::string blockName(ControlFlowGraph::BlockId b) {
+  return "B" + std::to_string(b);
+}
+
+// Constructor
+SsaForm::SsaForm(IrFunction & Fn, ControlFlowGraph & Cfg) :
+  Fn(Fn),
+  Cfg(Cfg),
+  Code(Fn.instructions()),
+  NumTemps{0} {
+}
+
+bool SsaForm::build(std::size_t budget) {
+  findNames();
+  if (not placePhis(budget)) {
+    Phis.clear();
+    return false;
+  }
+  rename();
+  return true;
+}
+
+std::vector<SsaForm::Phi> & SsaForm::phis(BlockId b) {
+  // the blocks added on the edges of the graph have none
+  if (b >= Phis.size())
+    Phis.resize(Cfg.numBlocks());
+  return Phis[b];
+}
+
+const std::vector<SsaForm::Phi> & SsaForm::phis(BlockId b) const {
+  static const std::vector<Phi> none;
+  return b < Phis.size() ? Phis[b] : none;
+}
+
+SsaForm::BlockId SsaForm::defBlock(IrOperand t) const {
+  if (not t.isTemp() or t.id >= DefBlock.size())
+    return ControlFlowGraph::NoBlock;
+  return DefBlock[t.id];
+}
+
+void SsaForm::setDefBlock(IrOperand t, BlockId b) {
+  if (t.id >= DefBlock.size())
+    DefBlock.resize(t.id + 1, ControlFlowGraph::NoBlock);
+  DefBlock[t.id] = b;
+}
+
+uint32_t SsaForm::nameOf(IrOperand o) const {
+  if (o.isTemp())
+    return o.id < NumTemps ? o.id : NoName;
+  if (o.isVar())
+    return VarName[o.id];
+  return NoName;
+}
+
+void SsaForm::findNames() {
+  NumTemps = 0;
+  for (const IrInstr & instr : Code)
+    for (const IrOperand & o : instr.arg)
+      if (o.isTemp() and o.id >= NumTemps)
+        NumTemps = o.id + 1;
+  Names.clear();
+  for (uint32_t t = 0; t < NumTemps; ++t)
+    Names.push_back(IrOperand(IrOperand::TEMP, t));
+
+  // the arrays, and the parameters, are not renamed
+  std::vector<char> array(Fn.numVars(), false);
+  for (const IrInstr & instr : Code) {
+    if ((instr.op == IrOp::LOADX or instr.op == IrOp::ALOAD) and
+        instr.arg[1].isVar())
+      array[instr.arg[1].id] = true;
+    else if (instr.op == IrOp::XLOAD and instr.arg[0].isVar())
+      array[instr.arg[0].id] = true;
+  }
+  VarName.assign(Fn.numVars(), NoName);
+  for (uint32_t v = 0; v < Fn.numVars(); ++v) {
+    IrOperand var(IrOperand::VAR, v);
+    if (not array[v] and not Fn.isParam(var)) {
+      VarName[v] = Names.size();
+      Names.push_back(var);
+    }
+  }
+}
+
+bool SsaForm::placePhis(std::size_t budget) {
+  std::size_t numBlocks = Cfg.numBlocks();
+  std::size_t numNames = Names.size();
+
+  // the names read before being written in some block, and the
+  // blocks where each name is written
+  std::vector<char>                 global(numNames, false);
+  std::vector<std::vector<BlockId>> defBlocks(numNames);
+  std::vector<uint32_t>             definedIn(numNames, 0);   // block + 1
+  for (BlockId b = 0; b < numBlocks; ++b) {
+    const ControlFlowGraph::Block & block = Cfg.block(b);
+    for (IrList::iterator it = block.begin; it != block.end; ++it) {
+      IrOperand used[3];
+      std::size_t n = it->uses(used);
+      for (std::size_t k = 0; k < n; ++k) {
+        uint32_t name = nameOf(used[k]);
+        if (name != NoName and definedIn[name] != b + 1)
+          global[name] = true;
+      }
+      if (it->definesFirst()) {
+        uint32_t name = nameOf(it->arg[0]);
+        if (name != NoName and definedIn[name] != b + 1) {
+          definedIn[name] = b + 1;
+          defBlocks[name].push_back(b);
+        }
+      }
+    }
+  }
+
+  std::vector<std::vector<BlockId>> frontiers;
+  if (not Cfg.dominanceFrontiers(frontiers, budget))
+    return false;
+  std::size_t work = 0;
+  for (const std::vector<BlockId> & df : frontiers)
+    work += df.size();
+
+  // the iterated dominance frontier of the blocks that write each name
+  std::vector<std::pair<BlockId, uint32_t>> placed;
+  std::vector<uint32_t> hasPhi(numBlocks, NoName);
+  std::vector<uint32_t> queued(numBlocks, NoName);
+  std::vector<BlockId>  pending;
+  for (uint32_t name = 0; name < numNames; ++name) {
+    if (not global[name])
+      continue;
+    pending = defBlocks[name];
+    for (BlockId b : pending)
+      queued[b] = name;
+    while (not pending.empty()) {
+      BlockId b = pending.back();
+      pending.pop_back();
+      work += frontiers[b].size();
+      if (work > budget)
+        return false;
+      for (BlockId d : frontiers[b]) {
+        if (hasPhi[d] == name)
+          continue;
+        hasPhi[d] = name;
+        placed.push_back(std::make_pair(d, name));
+        if (queued[d] != name) {
+          queued[d] = name;
+          pending.push_back(d);
+        }
+      }
+    }
+  }
+
+  Phis.assign(numBlocks, std::vector<Phi>());
+  for (const std::pair<BlockId, uint32_t> & p : placed) {
+    Phi phi;
+    phi.name = Names[p.second];
+    phi.args.assign(Cfg.block(p.first).preds.size(), IrOperand());
+    Phis[p.first].push_back(phi);
+  }
+  return true;
+}
+
+IrOperand SsaForm::newDef(BlockId b) {
+  IrOperand t = Fn.newTemp();
+  setDefBlock(t, b);
+  return t;
+}
+
+void SsaForm::rename() {
+  // the definitions that reach the point of the walk, by name; the
+  // names pushed are logged to pop them when leaving the block
+  std::vector<std::vector<IrOperand>>          current(Names.size());
+  std::vector<uint32_t>                        pushed;
+  std::vector<std::pair<BlockId, std::size_t>> stack;   // block, next child
+  std::vector<std::size_t>                     mark;    // size of 'pushed'
+  DefBlock.clear();
+  if (Cfg.numBlocks() == 0)
+    return;
+  stack.push_back(std::make_pair(0, 0));
+  bool entering = true;
+  while (not stack.empty()) {
+    BlockId b = stack.back().first;
+    if (entering) {
+      const ControlFlowGraph::Block & block = Cfg.block(b);
+      mark.push_back(pushed.size());
+      for (Phi & phi : Phis[b]) {
+        uint32_t name = nameOf(phi.name);
+        phi.dest = newDef(b);
+        current[name].push_back(phi.dest);
+        pushed.push_back(name);
+      }
+      for (IrList::iterator it = block.begin; it != block.end; ++it) {
+        std::size_t pos[3];
+        std::size_t n = it->usePositions(pos);
+        for (std::size_t k = 0; k < n; ++k) {
+          uint32_t name = nameOf(it->arg[pos[k]]);
+          if (name != NoName and not current[name].empty())
+            it->arg[pos[k]] = current[name].back();
+        }
+        if (it->definesFirst()) {
+          uint32_t name = nameOf(it->arg[0]);
+          if (name != NoName) {
+            it->arg[0] = newDef(b);
+            current[name].push_back(it->arg[0]);
+            pushed.push_back(name);
+          }
+        }
+      }
+      for (BlockId s : block.succs) {
+        const std::vector<BlockId> & preds = Cfg.block(s).preds;
+        std::size_t k = std::distance(preds.begin(),
+                                      std::find(preds.begin(), preds.end(), b));
+        for (Phi & phi : Phis[s]) {
+          uint32_t name = nameOf(phi.name);
+          if (not current[name].empty())
+            phi.args[k] = current[name].back();
+        }
+      }
+    }
+    std::size_t & next = stack.back().second;
+    if (next < Cfg.block(b).children.size()) {
+      stack.push_back(std::make_pair(Cfg.block(b).children[next++], 0));
+      entering = true;
+    }
+    else {
+      for (std::size_t i = mark.back(); i < pushed.size(); ++i)
+        current[pushed[i]].pop_back();
+      pushed.resize(mark.back());
+      mark.pop_back();
+      stack.pop_back();
+      entering = false;
+    }
+  }
+}
+
+void SsaForm::removeDeadPhis() {
+  // the phi that defines each temporary
+  std::vector<std::pair<BlockId, std::size_t>> phiOf(Fn.numTemps() + 1,
+                                                     std::make_pair(ControlFlowGraph::NoBlock, 0));
+  for (BlockId b = 0; b < Phis.size(); ++b)
+    for (std::size_t i = 0; i < Phis[b].size(); ++i)
+      phiOf[Phis[b][i].dest.id] = std::make_pair(b, i);
+
+  // the phis read by the code are live, and so are the phis that the
+  // arguments of a live one name
+  std::vector<char> live(phiOf.size(), false);
+  std::vector<IrOperand> work;
+  auto markLive = [&](IrOperand o) {
+    if (o.isTemp() and o.id < phiOf.size() and
+        phiOf[o.id].first != ControlFlowGraph::NoBlock and not live[o.id]) {
+      live[o.id] = true;
+      work.push_back(o);
+    }
+  };
+  for (const IrInstr & instr : Code) {
+    IrOperand used[3];
+    std::size_t n = instr.uses(used);
+    for (std::size_t k = 0; k < n; ++k)
+      markLive(used[k]);
+  }
+  while (not work.empty()) {
+    IrOperand t = work.back();
+    work.pop_back();
+    for (const IrOperand & a : Phis[phiOf[t.id].first][phiOf[t.id].second].args)
+      markLive(a);
+  }
+
+  for (std::vector<Phi> & phis : Phis)
+    phis.erase(std::remove_if(phis.begin(), phis.end(), [&](const Phi & phi) {
+                 return not live[phi.dest.id];
+               }),
+               phis.end());
+}
+
+void SsaForm::lower() {
+  // the phis that only feed other phis would become copies that read
+  // each other, which the removal of dead code can not see
+  removeDeadPhis();
+  std::size_t numBlocks = Cfg.numBlocks();
+  for (BlockId b = 0; b < numBlocks and b < Phis.size(); ++b)
+    lowerPhis(b);
+  Phis.clear();
+  DefBlock.clear();
+}
+
+void SsaForm::lowerPhis(BlockId b) {
+  if (Phis[b].empty())
+    return;
+  std::vector<IrOperand> dests;
+  for (const Phi & phi : Phis[b])
+    dests.push_back(phi.dest);
+  auto isDest = [&](IrOperand o) {
+    return std::find(dests.begin(), dests.end(), o) != dests.end();
+  };
+
+  // the predecessors change when their edges are split
+  std::vector<BlockId> preds = Cfg.block(b).preds;
+  for (std::size_t k = 0; k < preds.size(); ++k) {
+    std::vector<std::pair<IrOperand, IrOperand>> copies;
+    bool clash = false;
+    for (const Phi & phi : Phis[b])
+      if (not phi.args[k].isNone() and phi.args[k] != phi.dest) {
+        copies.push_back(std::make_pair(phi.dest, phi.args[k]));
+        if (isDest(phi.args[k]))
+          clash = true;
+      }
+    if (copies.empty())
+      continue;
+
+    // the copies go on the edge, unless it is the only way out of the
+    // predecessor and its jump does not read what they write
+    BlockId q = preds[k];
+    bool split = Cfg.block(q).succs.size() > 1;
+    IrList::iterator at = Cfg.insertPoint(q);
+    if (at != Cfg.block(q).end) {
+      IrOperand used[3];
+      std::size_t n = at->uses(used);
+      for (std::size_t u = 0; u < n; ++u)
+        if (isDest(used[u]))
+          split = true;
+    }
+    if (split)
+      q = Cfg.splitEdge(q, b);
+    if (clash) {
+      std::vector<IrOperand> saved;
+      for (const std::pair<IrOperand, IrOperand> & c : copies) {
+        saved.push_back(Fn.newTemp());
+        Cfg.insert(q, IrInstr::LOAD(saved.back(), c.second));
+      }
+      for (std::size_t i = 0; i < copies.size(); ++i)
+        Cfg.insert(q, IrInstr::LOAD(copies[i].first, saved[i]));
+    }
+    else
+      for (const std::pair<IrOperand, IrOperand> & c : copies)
+        Cfg.insert(q, IrInstr::LOAD(c.first, c.second));
+  }
+}
+
+bool SsaForm::verify(std::string & error) const {
+  if (not Cfg.verify(error))
+    return false;
+
+  // the definition of each temporary: its block and position (-1 for
+  // a phi)
+  std::vector<std::pair<BlockId, long>> def(Fn.numTemps() + 1,
+                                            std::make_pair(ControlFlowGraph::NoBlock, 0L));
+  auto define = [&](IrOperand t, BlockId b, long pos) {
+    if (t.id >= def.size())
+      def.resize(t.id + 1, std::make_pair(ControlFlowGraph::NoBlock, 0L));
+    if (def[t.id].first != ControlFlowGraph::NoBlock) {
+      error = Fn.operandText(t) + " is defined twice";
+      return false;
+    }
+    def[t.id] = std::make_pair(b, pos);
+    return true;
+  };
+  for (BlockId b = 0; b < Cfg.numBlocks(); ++b) {
+    const ControlFlowGraph::Block & block = Cfg.block(b);
+    for (const Phi & phi : phis(b)) {
+      if (phi.args.size() != block.preds.size()) {
+        error = "a phi of " + blockName(b) + " does not have an argument by predecessor";
+        return false;
+      }
+      if (not define(phi.dest, b, -1))
+        return false;
+    }
+    long pos = 0;
+    for (IrList::const_iterator it = block.begin; it != block.end; ++it, ++pos)
+      if (it->definesFirst()) {
+        if (it->arg[0].isTemp() and not define(it->arg[0], b, pos))
+          return false;
+        if (it->arg[0].isVar() and VarName[it->arg[0].id] != NoName) {
+          error = Fn.operandText(it->arg[0]) + " is still written in " + blockName(b);
+          return false;
+        }
+      }
+  }
+
+  // each use is dominated by its definition, if it has one
+  auto reaches = [&](IrOperand t, BlockId b, long pos) {
+    if (not t.isTemp() or t.id >= def.size() or
+        def[t.id].first == ControlFlowGraph::NoBlock)
+      return true;
+    if (def[t.id].first == b)
+      return def[t.id].second < pos;
+    return Cfg.dominates(def[t.id].first, b);
+  };
+  for (BlockId b = 0; b < Cfg.numBlocks(); ++b) {
+    const ControlFlowGraph::Block & block = Cfg.block(b);
+    for (const Phi & phi : phis(b))
+      for (std::size_t k = 0; k < phi.args.size(); ++k)
+        // the value leaves the predecessor at its end
+        if (not reaches(phi.args[k], block.preds[k], LONG_MAX)) {
+          error = "the definition of " + Fn.operandText(phi.args[k]) +
+                  " does not reach a phi of " + blockName(b);
+          return false;
+        }
+    long pos = 0;
+    for (IrList::const_iterator it = block.begin; it != block.end; ++it, ++pos) {
+      IrOperand used[3];
+      std::size_t n = it->uses(used);
+      for (std::size_t u = 0; u < n; ++u)
+        if (not reaches(used[u], b, pos)) {
+          error = "the definition of " + Fn.operandText(used[u]) +
+                  " does not reach its use in " + blockName(b);
+          return false;
+        }
+    }
+  }
+  return true;
+}
+
+void SsaForm::dump(std::ostream & out) const {
+  out << "function " << Fn.name() << std::endl;
+  for (BlockId b = 0; b < Cfg.numBlocks(); ++b) {
+    const ControlFlowGraph::Block & block = Cfg.block(b);
+    out << blockName(b) << ":  preds";
+    for (BlockId p : block.preds)
+      out << " " << blockName(p);
+    out << "  succs";
+    for (BlockId s : block.succs)
+      out << " " << blockName(s);
+    out << "  idom " << blockName(block.idom) << std::endl;
+    for (const Phi & phi : phis(b)) {
+      out << "    PHI " << Fn.operandText(phi.dest);
+      for (const IrOperand & a : phi.args)
+        out << " " << (a.isNone() ? "-" : Fn.operandText(a));
+      out << "    (" << Fn.operandText(phi.name) << ")" << std::endl;
+    }
+    for (IrList::const_iterator it = block.begin; it != block.end; ++it)
+      out << "    " << Fn.instrText(*it) << std::endl;
+  }
+}
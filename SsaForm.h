@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SsaForm - The static single assignment form of the
+//               code of a function, and its way back
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>    // uint32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class SsaForm: puts the code of a function in static single
+// assignment form, so that every value has one definition that
+// dominates its uses, and converts it back to plain t-code.
+//  - Names: the temporaries, and the local variables that are not
+//    arrays (those never used as the array of LOADX, XLOAD or ALOAD).
+//    The parameters stay as they are: they are read and written by
+//    the caller.
+//  - Phis: they are kept apart from the code, in the block where the
+//    names meet, with one argument per predecessor of the block. Only
+//    the names read in a block before being written there (those live
+//    across blocks) get phis (the semi-pruned form).
+//  - Renaming: each definition, of a phi or an instruction, gets a
+//    new temporary, and each use the temporary of the definition that
+//    reaches it, walking the dominator tree. A use that no definition
+//    reaches (an undefined value) keeps its name.
+//  - Lowering: first the phis whose results are only read by other
+//    phis (where the name is dead) are removed. Each one of the rest
+//    becomes a copy at the end of each predecessor, or on a new block
+//    if the predecessor has other successors (a critical edge). The
+//    copies of a block happen at once, so they go through new
+//    temporaries when one of them reads the result of another.
+// The cost of placing the phis grows with the dominance frontiers,
+// which can be quadratic: build() gives up when it exceeds a budget,
+// so the time stays linear on huge functions.
+
+class SsaForm {
+
+public:
+
+  typedef ControlFlowGraph::BlockId BlockId;
+
+  struct Phi {
+    IrOperand              dest;   // the temporary it defines
+    IrOperand              name;   // the temporary or variable it merges
+    std::vector<IrOperand> args;   // by predecessor (NONE: undefined)
+  };
+
+  // Constructor
+  SsaForm(IrFunction & Fn, ControlFlowGraph & Cfg);
+
+  // Put the code in SSA form. If the work to place the phis exceeds
+  // 'budget' it gives up, without changing the code, and returns false
+  bool build(std::size_t budget);
+
+  // The phis of a block
+  std::vector<Phi> &       phis(BlockId b);
+  const std::vector<Phi> & phis(BlockId b) const;
+  // The block where the temporary is defined (NoBlock if it is not),
+  // and its change when a pass moves the definition
+  BlockId defBlock(IrOperand t) const;
+  void    setDefBlock(IrOperand t, BlockId b);
+
+  // Convert the phis into copies
+  void lower();
+
+  // Check the form (and the graph): on failure 'error' tells what is
+  // wrong
+  bool verify(std::string & error) const;
+  // Write the blocks with their phis and code
+  void dump(std::ostream & out) const;
+
+private:
+
+  static const uint32_t NoName = UINT32_MAX;
+
+  // The name of an operand, or NoName
+  uint32_t nameOf(IrOperand o) const;
+  void findNames();
+  // Place the phis; false if over the budget
+  bool placePhis(std::size_t budget);
+  void rename();
+  IrOperand newDef(BlockId b);
+  // Remove the phis that the code does not read, even through others
+  void removeDeadPhis();
+  void lowerPhis(BlockId b);
+
+  // Attributes
+  IrFunction &                     Fn;
+  ControlFlowGraph &               Cfg;
+  IrList &                         Code;
+  std::vector<std::vector<Phi>>    Phis;       // by block
+  std::vector<BlockId>             DefBlock;   // by temporary
+  uint32_t                         NumTemps;   // before the renaming
+  std::vector<uint32_t>            VarName;    // by variable slot
+  std::vector<IrOperand>           Names;      // by name
+
+};  // class SsaForm
@@ -0,0 +1,419 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    StrengthReduction - Replaces the multiplications of
+//                   the induction variables of a loop by additions
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "StrengthReduction.h"
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <iterator>   // std::prev
+#include <algorithm>  // std::min, std::max
+#include <cerrno>
+#include <cstdlib>    // std::strtol
+#include <cstdint>    // int32_t, int64_t
+#include <cstddef>    // std::size_t
+
+
+// Constructor
+StrengthReduction::StrengthReduction(IrFunction & Fn, ControlFlowGraph & Cfg,
+                                     SsaForm & Ssa) :
+  Fn(Fn),
+  Cfg(Cfg),
+  Ssa(Ssa),
+  NumReduced(0),
+  NumRemoved(0) {
+}
+
+bool StrengthReduction::run() {
+  NumReduced = NumRemoved = 0;
+  Def.assign(Fn.numTemps() + 1, nullptr);
+  Uses.assign(Fn.numTemps() + 1, 0);
+  Replaced.assign(Fn.numTemps() + 1, IrOperand());
+  for (BlockId b = 0; b < Cfg.numBlocks(); ++b) {
+    for (const SsaForm::Phi & phi : Ssa.phis(b))
+      for (IrOperand a : phi.args)
+        if (a.isTemp())
+          addUse(a, 1);
+    for (IrList::iterator it = Cfg.block(b).begin; it != Cfg.block(b).end; ++it) {
+      IrOperand used[3];
+      std::size_t n = it->uses(used);
+      for (std::size_t k = 0; k < n; ++k)
+        if (used[k].isTemp())
+          addUse(used[k], 1);
+      if (it->definesFirst() and it->arg[0].isTemp() and it->arg[0].id < Def.size())
+        Def[it->arg[0].id] = &*it;
+    }
+  }
+
+  std::vector<ControlFlowGraph::Loop> loops = Cfg.loops();
+  for (const ControlFlowGraph::Loop & loop : loops) {
+    BlockId preheader = Cfg.preheader(loop, loops);
+    if (preheader != ControlFlowGraph::NoBlock)
+      reduce(loop, preheader);
+  }
+  if (NumReduced == 0)
+    return false;
+
+  // the uses of the multiplications read the new variables
+  auto replace = [&](IrOperand & o) {
+    if (o.isTemp() and o.id < Replaced.size() and not Replaced[o.id].isNone())
+      o = Replaced[o.id];
+  };
+  for (BlockId b = 0; b < Cfg.numBlocks(); ++b) {
+    for (SsaForm::Phi & phi : Ssa.phis(b))
+      for (IrOperand & a : phi.args)
+        replace(a);
+    for (IrList::iterator it = Cfg.block(b).begin; it != Cfg.block(b).end; ++it) {
+      std::size_t pos[3];
+      std::size_t n = it->usePositions(pos);
+      for (std::size_t k = 0; k < n; ++k)
+        replace(it->arg[pos[k]]);
+    }
+  }
+  return true;
+}
+
+std::size_t StrengthReduction::numReduced() const {
+  return NumReduced;
+}
+
+std::size_t StrengthReduction::numRemoved() const {
+  return NumRemoved;
+}
+
+void StrengthReduction::reduce(const ControlFlowGraph::Loop & loop,
+                               BlockId preheader) {
+  BlockId header = loop.header;
+  const std::vector<BlockId> & preds = Cfg.block(header).preds;
+  // the preheader and a single back edge
+  if (preds.size() != 2)
+    return;
+  std::size_t in = preds[0] == preheader ? 0 : 1;
+  std::size_t back = 1 - in;
+  BlockId latch = preds[back];
+
+  std::vector<char> inLoop(Cfg.numBlocks(), false);
+  for (BlockId b : loop.blocks)
+    inLoop[b] = true;
+  std::vector<char> written(Fn.numVars(), false);
+  for (BlockId b : loop.blocks)
+    for (IrList::iterator it = Cfg.block(b).begin; it != Cfg.block(b).end; ++it)
+      if (it->definesFirst() and it->arg[0].isVar())
+        written[it->arg[0].id] = true;
+  auto invariant = [&](IrOperand o) {
+    if (o.isVar())
+      return not written[o.id];
+    if (not o.isTemp())
+      return false;
+    BlockId def = Ssa.defBlock(o);
+    return def == ControlFlowGraph::NoBlock or def >= inLoop.size() or not inLoop[def];
+  };
+
+  // the basic induction variables
+  std::vector<Induction> inductions;
+  std::vector<SsaForm::Phi> & phis = Ssa.phis(header);
+  for (std::size_t p = 0; p < phis.size(); ++p) {
+    Induction iv;
+    iv.phi = p;
+    iv.var = phis[p].dest;
+    iv.init = phis[p].args[in];
+    iv.next = phis[p].args[back];
+    iv.products = iv.multiplications = 0;
+    iv.bounded = iv.reduced = false;
+    iv.bound = iv.low = iv.high = 0;
+    if (not iv.init.isTemp() or not iv.next.isTemp() or iv.next.id >= Def.size() or
+        Def[iv.next.id] == nullptr)
+      continue;
+    const IrInstr & i = *Def[iv.next.id];
+    iv.down = i.op == IrOp::SUB;
+    if (i.op == IrOp::ADD and i.arg[1] == iv.var and invariant(i.arg[2]))
+      iv.step = i.arg[2];
+    else if (i.op == IrOp::ADD and i.arg[2] == iv.var and invariant(i.arg[1]))
+      iv.step = i.arg[1];
+    else if (i.op == IrOp::SUB and i.arg[1] == iv.var and invariant(i.arg[2]))
+      iv.step = i.arg[2];
+    else
+      continue;
+    inductions.push_back(iv);
+  }
+  if (inductions.empty())
+    return;
+  auto inductionOf = [&](IrOperand o) {
+    for (std::size_t v = 0; v < inductions.size(); ++v)
+      if (inductions[v].var == o)
+        return v;
+    return inductions.size();
+  };
+
+  // their multiplications by invariant factors, and their comparisons
+  // with invariant bounds
+  std::vector<Product> products;
+  std::vector<std::pair<IrInstr *, std::size_t>> multiplications;
+  for (BlockId b : loop.blocks)
+    for (IrList::iterator it = Cfg.block(b).begin; it != Cfg.block(b).end; ++it) {
+      if (it->op != IrOp::MUL and it->op != IrOp::LT and it->op != IrOp::LE)
+        continue;
+      std::size_t v = inductionOf(it->arg[1]);
+      IrOperand other = it->arg[2];
+      if (v == inductions.size()) {
+        v = inductionOf(it->arg[2]);
+        other = it->arg[1];
+      }
+      if (v == inductions.size() or not invariant(other))
+        continue;
+      if (it->op != IrOp::MUL) {
+        inductions[v].compares.push_back(&*it);
+        continue;
+      }
+      std::size_t p = 0;
+      while (p < products.size() and
+             (products[p].induction != v or products[p].factor != other))
+        ++p;
+      if (p == products.size()) {
+        products.push_back(Product{v, other, IrOperand()});
+        ++inductions[v].products;
+      }
+      ++inductions[v].multiplications;
+      multiplications.push_back(std::make_pair(&*it, p));
+    }
+  bool profitable = false;
+  for (std::size_t v = 0; v < inductions.size(); ++v) {
+    inductions[v].bounded = findBounds(inductions[v], header, inLoop);
+    inductions[v].reduced = isProfitable(inductions[v], products, v);
+    profitable = profitable or inductions[v].reduced;
+  }
+  if (not profitable)
+    return;
+
+  // a new induction variable by product
+  for (Product & p : products) {
+    const Induction & iv = inductions[p.induction];
+    if (not iv.reduced)
+      continue;
+    p.var = newTemp(header);
+    IrOperand init = product(preheader, iv.init, p.factor);
+    IrOperand step = product(preheader, iv.step, p.factor);
+    IrOperand next = newTemp(latch);
+    IrList::iterator it = Cfg.insert(latch, iv.down ? IrInstr::SUB(next, p.var, step)
+                                                    : IrInstr::ADD(next, p.var, step));
+    if (next.id >= Def.size())
+      Def.resize(next.id + 1, nullptr);
+    Def[next.id] = &*it;
+    addUse(p.var, 1);
+    addUse(step, 1);
+    SsaForm::Phi phi;
+    phi.dest = p.var;
+    phi.name = p.var;
+    phi.args.resize(2);
+    phi.args[in] = init;
+    phi.args[back] = next;
+    addUse(init, 1);
+    addUse(next, 1);
+    Ssa.phis(header).push_back(phi);
+  }
+  for (const std::pair<IrInstr *, std::size_t> & m : multiplications) {
+    const Product & p = products[m.second];
+    if (not inductions[p.induction].reduced)
+      continue;
+    IrOperand d = m.first->arg[0];
+    if (d.id >= Replaced.size())
+      Replaced.resize(d.id + 1, IrOperand());
+    Replaced[d.id] = p.var;
+    addUse(p.var, long(uses(d)));
+    addUse(d, -long(uses(d)));
+    addUse(inductions[p.induction].var, -1);
+    addUse(p.factor, -1);
+    ++NumReduced;
+  }
+
+  // the induction variables left only to be compared (the phis are
+  // erased from the last, so that the indices stay valid)
+  for (std::size_t v = inductions.size(); v-- > 0; ) {
+    const Induction & iv = inductions[v];
+    if (not iv.reduced or iv.compares.size() != 1 or uses(iv.var) != 2 or
+        uses(iv.next) != 1)
+      continue;
+    for (const Product & p : products)
+      if (p.induction == v and removeVariable(iv, p, preheader)) {
+        std::vector<SsaForm::Phi> & headerPhis = Ssa.phis(header);
+        headerPhis.erase(headerPhis.begin() + iv.phi);
+        break;
+      }
+  }
+}
+
+bool StrengthReduction::isProfitable(const Induction & iv,
+                                     const std::vector<Product> & products,
+                                     std::size_t v) const {
+  std::size_t saved = iv.multiplications;
+  // the old variable goes if its other uses are its addition and a
+  // comparison, that can be done on one of its products
+  bool removable = false;
+  for (const Product & p : products)
+    removable = removable or (p.induction == v and isRemovable(iv, p));
+  if (removable and iv.compares.size() == 1 and
+      uses(iv.var) == 2 + iv.multiplications and uses(iv.next) == 1)
+    saved += 2;
+  return saved > 2 * iv.products;
+}
+
+bool StrengthReduction::findBounds(Induction & iv, BlockId header,
+                                   const std::vector<char> & inLoop) const {
+  int32_t init, step, bound;
+  if (iv.down or iv.compares.size() != 1 or not constantOf(iv.init, init) or
+      not constantOf(iv.step, step) or step <= 0)
+    return false;
+  const IrInstr & compare = *iv.compares[0];
+  if (compare.arg[1] != iv.var or not constantOf(compare.arg[2], bound))
+    return false;
+  // the header ends with the jump out of the loop when the comparison,
+  // made in the header, does not hold
+  const ControlFlowGraph::Block & block = Cfg.block(header);
+  if (block.begin == block.end)
+    return false;
+  IrList::iterator jump = std::prev(block.end);
+  if (jump->op != IrOp::FJUMP or jump->arg[0] != compare.arg[0])
+    return false;
+  BlockId exit = Cfg.blockOfLabel(jump->arg[1]);
+  if (exit == ControlFlowGraph::NoBlock or (exit < inLoop.size() and inLoop[exit]))
+    return false;
+  IrList::iterator it = block.begin;
+  while (it != jump and &*it != &compare)
+    ++it;
+  if (it == jump)
+    return false;
+  // so the variable starts at 'init' and only goes on from the values
+  // that pass the comparison, up to the last one plus the step
+  int64_t last = compare.op == IrOp::LT ? int64_t(bound) - 1 : int64_t(bound);
+  iv.bound = bound;
+  iv.low = init;
+  iv.high = std::max<int64_t>(init, last + step);
+  return iv.high <= std::numeric_limits<int32_t>::max();
+}
+
+bool StrengthReduction::isRemovable(const Induction & iv, const Product & p) const {
+  int32_t factor;
+  if (not iv.bounded or not constantOf(p.factor, factor) or factor <= 0)
+    return false;
+  // the factor is positive, so these are the least and the greatest
+  // products
+  int64_t least = std::min(iv.low, iv.bound) * factor;
+  int64_t greatest = std::max(iv.high, iv.bound) * factor;
+  return least >= std::numeric_limits<int32_t>::min() and
+         greatest <= std::numeric_limits<int32_t>::max();
+}
+
+bool StrengthReduction::removeVariable(const Induction & iv, const Product & p,
+                                       BlockId preheader) {
+  if (not isRemovable(iv, p))
+    return false;
+  // the variable is on the left (see findBounds)
+  IrInstr & compare = *iv.compares[0];
+  IrOperand other = compare.arg[2];
+  compare.arg[1] = p.var;
+  compare.arg[2] = product(preheader, other, p.factor);
+  addUse(p.var, 1);
+  addUse(compare.arg[2], 1);
+  addUse(other, -1);
+  // the phi and its ADD (left dead) are no longer used
+  addUse(iv.init, -1);
+  addUse(iv.next, -1);
+  addUse(iv.var, -long(uses(iv.var)));
+  ++NumRemoved;
+  return true;
+}
+
+IrOperand StrengthReduction::product(BlockId preheader, IrOperand x, IrOperand y) {
+  int32_t a = 0, b = 0;
+  bool constX = constantOf(x, a), constY = constantOf(y, b);
+  if (constX and a == 1)
+    return y;
+  if (constY and b == 1)
+    return x;
+  IrOperand t = newTemp(preheader);
+  IrList::iterator it;
+  int64_t value = int64_t(a) * b;
+  if (constX and constY and value >= 0 and value <= std::numeric_limits<int32_t>::max())
+    it = Cfg.insert(preheader, IrInstr::ILOAD(t, IrOperand::imm(int32_t(value))));
+  else {
+    it = Cfg.insert(preheader, IrInstr::MUL(t, x, y));
+    addUse(x, 1);
+    addUse(y, 1);
+  }
+  if (t.id >= Def.size())
+    Def.resize(t.id + 1, nullptr);
+  Def[t.id] = &*it;
+  return t;
+}
+
+bool StrengthReduction::constantOf(IrOperand o, int32_t & value) const {
+  if (not o.isTemp() or o.id >= Def.size() or Def[o.id] == nullptr)
+    return false;
+  const IrInstr & i = *Def[o.id];
+  if (i.op != IrOp::LOAD and i.op != IrOp::ILOAD)
+    return false;
+  if (i.arg[1].isImm()) {
+    value = i.arg[1].immValue();
+    return true;
+  }
+  if (i.op != IrOp::ILOAD)
+    return false;
+  std::string text = Fn.operandText(i.arg[1]);
+  char *end;
+  errno = 0;
+  long v = std::strtol(text.c_str(), &end, 10);
+  if (*end != '\0' or errno != 0 or v < std::numeric_limits<int32_t>::min() or
+      v > std::numeric_limits<int32_t>::max())
+    return false;
+  value = static_cast<int32_t>(v);
+  return true;
+}
+
+std::size_t StrengthReduction::uses(IrOperand t) const {
+  return t.isTemp() and t.id < Uses.size() ? Uses[t.id] : 0;
+}
+
+void StrengthReduction::addUse(IrOperand o, long n) {
+  if (not o.isTemp())
+    return;
+  if (o.id >= Uses.size())
+    Uses.resize(o.id + 1, 0);
+  Uses[o.id] += n;
+}
+
+IrOperand StrengthReduction::newTemp(BlockId b) {
+  IrOperand t = Fn.newTemp();
+  Ssa.setDefBlock(t, b);
+  return t;
+}
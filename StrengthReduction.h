@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    StrengthReduction - Replaces the multiplications of
+//                   the induction variables of a loop by additions
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+
+#include <vector>
+#include <cstdint>    // int32_t, int64_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class StrengthReduction: an optimization pass over the SSA form of
+// a function, run after the loop invariant code motion. A basic
+// induction variable of a loop is a phi of its header that the loop
+// increases (or decreases) by an invariant step on each iteration:
+// the phi gets its value from the preheader and, from the only back
+// edge, the result of an ADD (or SUB) of itself and the step.
+//  - Each multiplication of an induction variable by an invariant
+//    value (as the index of a[k*i]) becomes a new induction variable:
+//    a phi that starts as the product of the initial value and goes
+//    up by the product of the step at the end of each iteration. The
+//    uses of the multiplication read the new phi, and the
+//    multiplication is left dead, for the dead code elimination.
+//  - When the only other use of the induction variable is the exit
+//    test of the loop, a LT or LE with a constant bound, and it is
+//    multiplied by a positive constant, the comparison is done on the
+//    new variable with the bound multiplied by it, and the old
+//    variable is removed. The original code may never compute those
+//    products, so this is only done when the start, the step and the
+//    bound are constants and the products of all the values that the
+//    variable can be compared with fit in an int: then they compare
+//    as the values. Otherwise the old comparison stays.
+//  - Each new variable adds to the iterations an addition and the
+//    copy of its phi, which cost as much as two multiplications: the
+//    products of an induction variable are only reduced if that saves
+//    instructions (usually, because the old variable is removed).
+// The element size of the arrays of the t-code is 1, so the index of
+// a[i] is i itself: only the scaled indices are reduced.
+
+class StrengthReduction {
+
+public:
+
+  // Constructor
+  StrengthReduction(IrFunction & Fn, ControlFlowGraph & Cfg, SsaForm & Ssa);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+  // Number of multiplications reduced, and of induction variables
+  // removed
+  std::size_t numReduced() const;
+  std::size_t numRemoved() const;
+
+private:
+
+  typedef ControlFlowGraph::BlockId BlockId;
+
+  // A basic induction variable of the loop
+  struct Induction {
+    std::size_t phi;        // index in the phis of the header
+    IrOperand   var;        // the phi
+    IrOperand   init;       // its value from the preheader
+    IrOperand   next;       // its value from the back edge
+    IrOperand   step;
+    bool        down;       // SUB instead of ADD
+    std::vector<IrInstr *> compares;
+    // when the only comparison is the exit test of the loop with
+    // constants, the values it compares: the bound and [low, high]
+    bool        bounded;
+    int64_t     bound, low, high;
+    std::size_t products;
+    std::size_t multiplications;
+    bool        reduced;
+  };
+
+  // The multiplications of an induction variable by the same factor
+  struct Product {
+    std::size_t induction;
+    IrOperand   factor;
+    IrOperand   var;        // the new induction variable
+  };
+
+  void reduce(const ControlFlowGraph::Loop & loop, BlockId preheader);
+  // Whether reducing the products of the induction variable saves
+  // instructions in the iterations
+  bool isProfitable(const Induction & iv,
+                    const std::vector<Product> & products, std::size_t v) const;
+  // Find the values compared by the exit test of the loop
+  bool findBounds(Induction & iv, BlockId header, const std::vector<char> & inLoop) const;
+  // Whether the comparison of the induction variable can be done on
+  // the product instead, and the variable removed
+  bool isRemovable(const Induction & iv, const Product & p) const;
+  // Remove the induction variable if it is only compared
+  bool removeVariable(const Induction & iv, const Product & p, BlockId preheader);
+  // Define in the preheader the product x * y, folding constants
+  IrOperand product(BlockId preheader, IrOperand x, IrOperand y);
+  // The value of a temporary defined as an integer constant
+  bool constantOf(IrOperand o, int32_t & value) const;
+  // The uses of a temporary, and their change
+  std::size_t uses(IrOperand t) const;
+  void addUse(IrOperand o, long n);
+  IrOperand newTemp(BlockId b);
+
+  // Attributes
+  IrFunction &           Fn;
+  ControlFlowGraph &     Cfg;
+  SsaForm &              Ssa;
+  std::vector<IrInstr *> Def;        // by temporary
+  std::vector<std::size_t> Uses;     // by temporary
+  std::vector<IrOperand> Replaced;   // by temporary
+  std::size_t            NumReduced;
+  std::size_t            NumRemoved;
+
+};  // class StrengthReduction
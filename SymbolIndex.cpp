@@ -0,0 +1,93 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SymbolIndex - Symbols of the program resolved to compact
+//           handles, indexed by interned name
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#include "SymbolIndex.h"
+
+#include <algorithm>  // std::sort, std::lower_bound
+
+
+// Constructor
+SymbolIndex::SymbolIndex(std::size_t numNames) :
+  Functions(numNames),
+  NumFunctions{0} {
+}
+
+SymbolIndex::ScopeId SymbolIndex::beginFunction(AslAst::NodeId fn) {
+  Scopes.push_back(Scope{fn, static_cast<uint32_t>(Entries.size()), 0});
+  return Scopes.size() - 1;
+}
+
+void SymbolIndex::addParameter(AslAst::NameId name, TypesMgr::TypeId t) {
+  addVar(name, SymbolHandle::PARAMETER, t);
+}
+
+void SymbolIndex::addLocalVar(AslAst::NameId name, TypesMgr::TypeId t) {
+  addVar(name, SymbolHandle::LOCALVAR, t);
+}
+
+void SymbolIndex::addVar(AslAst::NameId name, SymbolHandle::Kind k, TypesMgr::TypeId t) {
+  Scope & sc = Scopes.back();
+  Entries.push_back(Entry{name, SymbolHandle(k, sc.count, t)});
+  ++sc.count;
+}
+
+void SymbolIndex::endFunction() {
+  // sorted by name, for the lookups (the slots keep the order)
+  const Scope & sc = Scopes.back();
+  std::sort(Entries.begin() + sc.first, Entries.end(),
+            [](const Entry & a, const Entry & b) { return a.name < b.name; });
+}
+
+void SymbolIndex::addFunction(AslAst::NameId name, TypesMgr::TypeId t) {
+  Functions[name] = SymbolHandle(SymbolHandle::FUNCTION, NumFunctions++, t);
+}
+
+SymbolIndex::ScopeId SymbolIndex::scopeOf(AslAst::NodeId fn) const {
+  // the functions are declared in preorder, so Scopes is sorted
+  auto it = std::lower_bound(Scopes.begin(), Scopes.end(), fn,
+                             [](const Scope & s, AslAst::NodeId n) { return s.function < n; });
+  return it - Scopes.begin();
+}
+
+SymbolHandle SymbolIndex::lookup(ScopeId scope, AslAst::NameId name) const {
+  if (scope < Scopes.size()) {
+    const Scope & sc = Scopes[scope];
+    auto first = Entries.begin() + sc.first;
+    auto last  = first + sc.count;
+    auto it = std::lower_bound(first, last, name,
+                               [](const Entry & e, AslAst::NameId n) { return e.name < n; });
+    if (it != last and it->name == name)
+      return it->symbol;
+  }
+  return Functions[name];
+}
+
+std::size_t SymbolIndex::numSymbols() const {
+  return Entries.size() + NumFunctions;
+}
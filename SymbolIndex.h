@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SymbolIndex - Symbols of the program resolved to compact
+//           handles, indexed by interned name
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "AslAst.h"
+
+#include "../common/TypesMgr.h"
+
+#include <vector>
+#include <cstdint>    // uint8_t, uint32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class SymbolHandle: what an identifier refers to, resolved once and
+// stored on its ident node: the class of the symbol, its type and
+// its slot (the position of a parameter or local variable in its
+// function, parameters first, or the number of a function).
+
+class SymbolHandle {
+
+public:
+
+  enum Kind : uint8_t { NONE, FUNCTION, PARAMETER, LOCALVAR };
+
+  SymbolHandle() : kind(NONE), slot(0), type(TypesMgr::TypeId()) {}
+  SymbolHandle(Kind k, uint32_t s, TypesMgr::TypeId t) : kind(k), slot(s), type(t) {}
+
+  bool isNone()     const { return kind == NONE; }
+  bool isFunction() const { return kind == FUNCTION; }
+  bool isParam()    const { return kind == PARAMETER; }
+  bool isLocalVar() const { return kind == LOCALVAR; }
+
+  Kind             kind;
+  uint32_t         slot;
+  TypesMgr::TypeId type;
+
+};  // class SymbolHandle
+
+
+//////////////////////////////////////////////////////////////////////
+// Class SymbolIndex: the symbols declared in the program, filled by
+// the SymbolsListener next to the SymTable. Names are the interned
+// names of the AslAst, so a lookup compares integers: the functions
+// are a vector indexed by name, and the parameters and local
+// variables of each function a vector sorted by name. Once filled it
+// is only read, so several threads can look symbols up at once.
+
+class SymbolIndex {
+
+public:
+
+  typedef uint32_t ScopeId;   // the scope of a function
+
+  // Constructor, for the numNames interned names of the AST
+  SymbolIndex(std::size_t numNames);
+
+  // Declarations. The parameters and local variables go to the scope
+  // opened by beginFunction (for the function node 'fn')
+  ScopeId beginFunction(AslAst::NodeId fn);
+  void    addParameter(AslAst::NameId name, TypesMgr::TypeId t);
+  void    addLocalVar(AslAst::NameId name, TypesMgr::TypeId t);
+  void    endFunction();
+  void    addFunction(AslAst::NameId name, TypesMgr::TypeId t);
+
+  // The scope of the function node 'fn'
+  ScopeId scopeOf(AslAst::NodeId fn) const;
+
+  // The symbol a name refers to in the scope: a parameter or a local
+  // variable of its function, or else a function (NONE if undeclared)
+  SymbolHandle lookup(ScopeId scope, AslAst::NameId name) const;
+
+  // Number of symbols declared
+  std::size_t numSymbols() const;
+
+private:
+
+  struct Entry {
+    AslAst::NameId name;
+    SymbolHandle   symbol;
+  };
+
+  struct Scope {
+    AslAst::NodeId function;
+    uint32_t       first;     // Entries[first ... first+count)
+    uint32_t       count;
+  };
+
+  void addVar(AslAst::NameId name, SymbolHandle::Kind k, TypesMgr::TypeId t);
+
+  // Attributes
+  std::vector<SymbolHandle> Functions;    // indexed by name
+  std::vector<Entry>        Entries;      // variables, by scope
+  std::vector<Scope>        Scopes;       // by function node
+  uint32_t                  NumFunctions;
+
+};  // class SymbolIndex
@@ -1,11 +1,12 @@
 #include "SymbolsListener.h"
 
-#include "antlr4-runtime.h"
+#include "AslParser.h"
 
 #include "../common/TypesMgr.h"
 #include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
+#include "NodeDecorations.h"
+#include "SymbolIndex.h"
+#include "SemErrorLog.h"
 
 #include <iostream>
 #include <string>
@@ -21,280 +22,282 @@ using namespace std;
 
 
 // Constructor
-SymbolsListener::SymbolsListener(TypesMgr       & Types,
-				 SymTable       & Symbols,
-				 TreeDecoration & Decorations,
-				 SemErrors      & Errors) :
+SymbolsListener::SymbolsListener(TypesMgr        & Types,
+				 SymTable        & Symbols,
+				 NodeDecorations & Decorations,
+				 SemErrorLog     & Errors,
+				 const AslAst    & Ast,
+				 SymbolIndex     & Index) :
   Types{Types},
   Symbols{Symbols},
   Decorations{Decorations},
-  Errors{Errors} {
+  Errors{Errors},
+  Ast{Ast},
+  Index{Index} {
 }
 
-void SymbolsListener::enterBasic_type(AslParser::Basic_typeContext *ctx){
+void SymbolsListener::enterBasic_type(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void SymbolsListener::exitBasic_type(AslParser::Basic_typeContext *ctx){
+void SymbolsListener::exitBasic_type(AslAst::NodeId n){
     TypesMgr::TypeId t;
-    if(ctx->INT()){
+    if(Ast.node(n).op == AslParser::INT){
       t = Types.createIntegerTy();
     }
-    else if(ctx->BOOL()){
+    else if(Ast.node(n).op == AslParser::BOOL){
       t = Types.createBooleanTy();
     }
-    else if(ctx->FLOAT()){
+    else if(Ast.node(n).op == AslParser::FLOAT){
       t = Types.createFloatTy();
     }
-    else if(ctx->CHAR()){
+    else if(Ast.node(n).op == AslParser::CHAR){
       t = Types.createCharacterTy();
     }
-  putTypeDecor(ctx,t);
+  putTypeDecor(n,t);
   DEBUG_EXIT();
 }
 
 
-void SymbolsListener::enterProgram(AslParser::ProgramContext *ctx) {
+void SymbolsListener::enterProgram(AslAst::NodeId n) {
   DEBUG_ENTER();
   SymTable::ScopeId sc = Symbols.pushNewScope("$global$");
-  putScopeDecor(ctx, sc);
+  putScopeDecor(n, sc);
 }
-void SymbolsListener::exitProgram(AslParser::ProgramContext *ctx) {
+void SymbolsListener::exitProgram(AslAst::NodeId n) {
   // Symbols.print();
   Symbols.popScope();
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterFunction(AslParser::FunctionContext *ctx) {
+void SymbolsListener::enterFunction(AslAst::NodeId n) {
   DEBUG_ENTER();
-  std::string funcName = ctx->ID()->getText();
+  const std::string & funcName = Ast.name(n);
   SymTable::ScopeId sc = Symbols.pushNewScope(funcName);
-  putScopeDecor(ctx, sc);
+  putScopeDecor(n, sc);
+  Index.beginFunction(n);
 }
-void SymbolsListener::exitFunction(AslParser::FunctionContext *ctx) {
+void SymbolsListener::exitFunction(AslAst::NodeId n) {
   // Symbols.print();
   Symbols.popScope();
-  std::string ident = ctx->ID()->getText();
+  Index.endFunction();
+  const std::string & ident = Ast.name(n);
   if (Symbols.findInCurrentScope(ident)) {
-    Errors.declaredIdent(ctx->ID());
+    Errors.declaredIdent(n);
   }
   else {
     std::vector<TypesMgr::TypeId> lParamsTy;
-		if(ctx -> parameter_decl()){
-			for(auto i: ctx -> parameter_decl()->pdObj()){
-				lParamsTy.push_back(getTypeDecor(i->type()));
+		AslAst::NodeId params = Ast.findChild(n, AslAst::Parameter_decl);
+		if(params != AslAst::NoNode){
+			for(std::size_t i = 0; i < Ast.node(params).numChildren; ++i){
+				lParamsTy.push_back(getTypeDecor(Ast.child(Ast.child(params, i), 0)));
 			}
 		}
     TypesMgr::TypeId tRet = Types.createVoidTy();
-		if(ctx->return_type()) tRet = getTypeDecor(ctx->return_type()->type());
+		AslAst::NodeId ret = Ast.findChild(n, AslAst::Return_type);
+		if(ret != AslAst::NoNode) tRet = getTypeDecor(Ast.child(ret, 0));
 
 		//
     TypesMgr::TypeId tFunc = Types.createFunctionTy(lParamsTy, tRet);
     Symbols.addFunction(ident, tFunc);
+    Index.addFunction(Ast.nameId(n), tFunc);
   }
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterDeclarations(AslParser::DeclarationsContext *ctx) {
+void SymbolsListener::enterDeclarations(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitDeclarations(AslParser::DeclarationsContext *ctx) {
+void SymbolsListener::exitDeclarations(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
- void SymbolsListener::enterParameter_decl(AslParser::Parameter_declContext *ctx ) {
+ void SymbolsListener::enterParameter_decl(AslAst::NodeId n ) {
    DEBUG_ENTER();
   }
- void SymbolsListener::exitParameter_decl(AslParser::Parameter_declContext *ctx) {
-   for(auto ipdObj : ctx->pdObj()){
-     std::string ident = ipdObj-> ID() -> getText();
+ void SymbolsListener::exitParameter_decl(AslAst::NodeId n) {
+   for(std::size_t i = 0; i < Ast.node(n).numChildren; ++i){
+     AslAst::NodeId ipdObj = Ast.child(n, i);
+     const std::string & ident = Ast.name(ipdObj);
      if (Symbols.findInCurrentScope(ident)) {
-	    Errors.declaredIdent(ipdObj->ID());
+	    Errors.declaredIdent(ipdObj);
 	  }
     else{
-      TypesMgr::TypeId t1 = getTypeDecor(ipdObj->type());
+      TypesMgr::TypeId t1 = getTypeDecor(Ast.child(ipdObj, 0));
 	    Symbols.addParameter(ident, t1);
+	    Index.addParameter(Ast.nameId(ipdObj), t1);
     }
    }
    DEBUG_EXIT();
  }
 
 
-void SymbolsListener::enterVariable_decl(AslParser::Variable_declContext *ctx) {
+void SymbolsListener::enterVariable_decl(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitVariable_decl(AslParser::Variable_declContext *ctx) {
-  for(auto idCtx: ctx->ID()){
-	  std::string ident = idCtx->getText();
+void SymbolsListener::exitVariable_decl(AslAst::NodeId n) {
+  for(std::size_t i = 0; i < Ast.node(n).numNames; ++i){
+	  AslAst::NameId      name  = Ast.nameId(n, i);
+	  const std::string & ident = Ast.nameText(name);
 		if (Symbols.findInCurrentScope(ident)) {
-	    Errors.declaredIdent(idCtx);
+	    Errors.declaredIdent(n, i);
 	  }
 		else {
-	    TypesMgr::TypeId t1 = getTypeDecor(ctx->type());
+	    TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
 	    Symbols.addLocalVar(ident, t1);
+	    Index.addLocalVar(name, t1);
 	  }
   }
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterType(AslParser::TypeContext *ctx) {
+void SymbolsListener::enterType(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitType(AslParser::TypeContext *ctx) {
-  if (ctx->INT()) {
+void SymbolsListener::exitType(AslAst::NodeId n) {
+  if (Ast.node(n).op == AslParser::INT) {
     TypesMgr::TypeId t = Types.createIntegerTy();
-    putTypeDecor(ctx, t);
+    putTypeDecor(n, t);
   }
-  else if(ctx->CHAR()){
+  else if(Ast.node(n).op == AslParser::CHAR){
     TypesMgr::TypeId t = Types.createCharacterTy();
-    putTypeDecor(ctx, t);
+    putTypeDecor(n, t);
   }
-  else if(ctx->BOOL()){
+  else if(Ast.node(n).op == AslParser::BOOL){
     TypesMgr::TypeId t = Types.createBooleanTy();
-    putTypeDecor(ctx, t);
+    putTypeDecor(n, t);
   }
 
-  else if(ctx->FLOAT()){
+  else if(Ast.node(n).op == AslParser::FLOAT){
     TypesMgr::TypeId t = Types.createFloatTy();
-    putTypeDecor(ctx, t);
+    putTypeDecor(n, t);
   }
-  else if(ctx->vect()){
-    unsigned int size = stoi(ctx->vect()->INTVAL()->getText());
-    TypesMgr::TypeId elemType = getTypeDecor(ctx->vect()->type());
+  else if(Ast.node(n).numChildren > 0){
+    AslAst::NodeId vect = Ast.child(n, 0);
+    unsigned int size = stoi(Ast.name(vect));
+    TypesMgr::TypeId elemType = getTypeDecor(Ast.child(vect, 0));
     if(Types.isArrayTy(elemType)){
       cout << "Cuidado que intentas definir un array de mas de una dimension" << endl;
     }
     else {
       TypesMgr::TypeId t = Types.createArrayTy(size, elemType);
-      putTypeDecor(ctx,t);
+      putTypeDecor(n,t);
     }
   }
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterStatements(AslParser::StatementsContext *ctx) {
+void SymbolsListener::enterStatements(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitStatements(AslParser::StatementsContext *ctx) {
+void SymbolsListener::exitStatements(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterAssignStmt(AslParser::AssignStmtContext *ctx) {
+void SymbolsListener::enterAssignStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitAssignStmt(AslParser::AssignStmtContext *ctx) {
+void SymbolsListener::exitAssignStmt(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterIfStmt(AslParser::IfStmtContext *ctx) {
+void SymbolsListener::enterIfStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitIfStmt(AslParser::IfStmtContext *ctx) {
+void SymbolsListener::exitIfStmt(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterProcCall(AslParser::ProcCallContext *ctx) {
+void SymbolsListener::enterProcCall(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitProcCall(AslParser::ProcCallContext *ctx) {
+void SymbolsListener::exitProcCall(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterReturn_func(AslParser::Return_funcContext *ctx){
+void SymbolsListener::enterReturn_func(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void SymbolsListener::exitReturn_func(AslParser::Return_funcContext *ctx){
+void SymbolsListener::exitReturn_func(AslAst::NodeId n){
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterReadStmt(AslParser::ReadStmtContext *ctx) {
+void SymbolsListener::enterReadStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitReadStmt(AslParser::ReadStmtContext *ctx) {
+void SymbolsListener::exitReadStmt(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterWriteExpr(AslParser::WriteExprContext *ctx) {
+void SymbolsListener::enterWriteExpr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitWriteExpr(AslParser::WriteExprContext *ctx) {
+void SymbolsListener::exitWriteExpr(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterWriteString(AslParser::WriteStringContext *ctx) {
+void SymbolsListener::enterWriteString(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitWriteString(AslParser::WriteStringContext *ctx) {
+void SymbolsListener::exitWriteString(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
+void SymbolsListener::enterLeft_expr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
+void SymbolsListener::exitLeft_expr(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterArithmetic(AslParser::ArithmeticContext *ctx) {
+void SymbolsListener::enterArithmetic(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitArithmetic(AslParser::ArithmeticContext *ctx) {
+void SymbolsListener::exitArithmetic(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterRelational(AslParser::RelationalContext *ctx) {
+void SymbolsListener::enterRelational(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitRelational(AslParser::RelationalContext *ctx) {
+void SymbolsListener::exitRelational(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterValue(AslParser::ValueContext *ctx) {
+void SymbolsListener::enterValue(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitValue(AslParser::ValueContext *ctx) {
+void SymbolsListener::exitValue(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterExprIdent(AslParser::ExprIdentContext *ctx) {
+void SymbolsListener::enterExprIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitExprIdent(AslParser::ExprIdentContext *ctx) {
+void SymbolsListener::exitExprIdent(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void SymbolsListener::enterIdent(AslParser::IdentContext *ctx) {
+void SymbolsListener::enterIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void SymbolsListener::exitIdent(AslParser::IdentContext *ctx) {
+void SymbolsListener::exitIdent(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-// void SymbolsListener::enterEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_ENTER();
-// }
-// void SymbolsListener::exitEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_EXIT();
-// }
-// void SymbolsListener::visitTerminal(antlr4::tree::TerminalNode *node) {
-//   DEBUG("visitTerminal");
-// }
-// void SymbolsListener::visitErrorNode(antlr4::tree::ErrorNode *node) {
-// }
-
 // Getters for the necessary tree node atributes:
 //   Scope and Type
-SymTable::ScopeId SymbolsListener::getScopeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getScope(ctx);
+SymTable::ScopeId SymbolsListener::getScopeDecor(AslAst::NodeId n) {
+  return Decorations.getScope(n);
 }
-TypesMgr::TypeId SymbolsListener::getTypeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getType(ctx);
+TypesMgr::TypeId SymbolsListener::getTypeDecor(AslAst::NodeId n) {
+  return Decorations.getType(n);
 }
 
 // Setters for the necessary tree node attributes:
 //   Scope and Type
-void SymbolsListener::putScopeDecor(antlr4::ParserRuleContext *ctx, SymTable::ScopeId s) {
-  Decorations.putScope(ctx, s);
+void SymbolsListener::putScopeDecor(AslAst::NodeId n, SymTable::ScopeId s) {
+  Decorations.putScope(n, s);
 }
-void SymbolsListener::putTypeDecor(antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t) {
-  Decorations.putType(ctx, t);
+void SymbolsListener::putTypeDecor(AslAst::NodeId n, TypesMgr::TypeId t) {
+  Decorations.putType(n, t);
 }
@@ -1,118 +1,118 @@
 #pragma once
 
-#include "antlr4-runtime.h"
-#include "AslBaseListener.h"
+#include "AslAstListener.h"
+#include "AslAst.h"
+#include "SymbolIndex.h"
 
 #include "../common/TypesMgr.h"
 #include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
+#include "NodeDecorations.h"
+#include "SemErrorLog.h"
 
 // using namespace std;
 
 
 //////////////////////////////////////////////////////////////////////
-// Class SymbolListener:  derived from AslBaseListener.
-// The tree walker go through the parse tree and call the methods of
+// Class SymbolListener:  derived from AslAstListener.
+// The tree walker go through the AST and call the methods of
 // this listener to register the symbols of the program in the symbol
 // table. If an enter/exit method does not have an associated task,
 // it does not have to be redefined.
 
-class SymbolsListener final : public AslBaseListener {
+class SymbolsListener final : public AslAstListener {
 
 public:
 
   // Constructor
-  SymbolsListener(TypesMgr       & Types,
-		  SymTable       & Symbols,
-		  TreeDecoration & TreeNodeProps,
-		  SemErrors      & Errors);
+  SymbolsListener(TypesMgr        & Types,
+		  SymTable        & Symbols,
+		  NodeDecorations & TreeNodeProps,
+		  SemErrorLog     & Errors,
+		  const AslAst    & Ast,
+		  SymbolIndex     & Index);
 
 
-  void enterBasic_type(AslParser::Basic_typeContext *ctx);
-  void exitBasic_type(AslParser::Basic_typeContext *ctx);
+  void enterBasic_type(AslAst::NodeId n);
+  void exitBasic_type(AslAst::NodeId n);
 
-  void enterProgram(AslParser::ProgramContext *ctx);
-  void exitProgram(AslParser::ProgramContext *ctx);
+  void enterProgram(AslAst::NodeId n);
+  void exitProgram(AslAst::NodeId n);
 
-  void enterFunction(AslParser::FunctionContext *ctx);
-  void exitFunction(AslParser::FunctionContext *ctx);
+  void enterFunction(AslAst::NodeId n);
+  void exitFunction(AslAst::NodeId n);
 
-  void enterReturn_func(AslParser::Return_funcContext *ctx);
-  void exitReturn_func(AslParser::Return_funcContext *ctx);
+  void enterReturn_func(AslAst::NodeId n);
+  void exitReturn_func(AslAst::NodeId n);
 
-  void enterDeclarations(AslParser::DeclarationsContext *ctx);
-  void exitDeclarations(AslParser::DeclarationsContext *ctx);
+  void enterDeclarations(AslAst::NodeId n);
+  void exitDeclarations(AslAst::NodeId n);
 
-  void enterParameter_decl(AslParser::Parameter_declContext *ctx);
-  void exitParameter_decl(AslParser::Parameter_declContext *ctx);
+  void enterParameter_decl(AslAst::NodeId n);
+  void exitParameter_decl(AslAst::NodeId n);
 
-  void enterVariable_decl(AslParser::Variable_declContext *ctx);
-  void exitVariable_decl(AslParser::Variable_declContext *ctx);
+  void enterVariable_decl(AslAst::NodeId n);
+  void exitVariable_decl(AslAst::NodeId n);
 
-  void enterType(AslParser::TypeContext *ctx);
-  void exitType(AslParser::TypeContext *ctx);
+  void enterType(AslAst::NodeId n);
+  void exitType(AslAst::NodeId n);
 
-  void enterStatements(AslParser::StatementsContext *ctx);
-  void exitStatements(AslParser::StatementsContext *ctx);
+  void enterStatements(AslAst::NodeId n);
+  void exitStatements(AslAst::NodeId n);
 
-  void enterAssignStmt(AslParser::AssignStmtContext *ctx);
-  void exitAssignStmt(AslParser::AssignStmtContext *ctx);
+  void enterAssignStmt(AslAst::NodeId n);
+  void exitAssignStmt(AslAst::NodeId n);
 
-  void enterIfStmt(AslParser::IfStmtContext *ctx);
-  void exitIfStmt(AslParser::IfStmtContext *ctx);
+  void enterIfStmt(AslAst::NodeId n);
+  void exitIfStmt(AslAst::NodeId n);
 
-  void enterProcCall(AslParser::ProcCallContext *ctx);
-  void exitProcCall(AslParser::ProcCallContext *ctx);
+  void enterProcCall(AslAst::NodeId n);
+  void exitProcCall(AslAst::NodeId n);
 
-  void enterReadStmt(AslParser::ReadStmtContext *ctx);
-  void exitReadStmt(AslParser::ReadStmtContext *ctx);
+  void enterReadStmt(AslAst::NodeId n);
+  void exitReadStmt(AslAst::NodeId n);
 
-  void enterWriteExpr(AslParser::WriteExprContext *ctx);
-  void exitWriteExpr(AslParser::WriteExprContext *ctx);
+  void enterWriteExpr(AslAst::NodeId n);
+  void exitWriteExpr(AslAst::NodeId n);
 
-  void enterWriteString(AslParser::WriteStringContext *ctx);
-  void exitWriteString(AslParser::WriteStringContext *ctx);
+  void enterWriteString(AslAst::NodeId n);
+  void exitWriteString(AslAst::NodeId n);
 
-  void enterLeft_expr(AslParser::Left_exprContext *ctx);
-  void exitLeft_expr(AslParser::Left_exprContext *ctx);
+  void enterLeft_expr(AslAst::NodeId n);
+  void exitLeft_expr(AslAst::NodeId n);
 
-  void enterArithmetic(AslParser::ArithmeticContext *ctx);
-  void exitArithmetic(AslParser::ArithmeticContext *ctx);
+  void enterArithmetic(AslAst::NodeId n);
+  void exitArithmetic(AslAst::NodeId n);
 
-  void enterRelational(AslParser::RelationalContext *ctx);
-  void exitRelational(AslParser::RelationalContext *ctx);
+  void enterRelational(AslAst::NodeId n);
+  void exitRelational(AslAst::NodeId n);
 
-  void enterValue(AslParser::ValueContext *ctx);
-  void exitValue(AslParser::ValueContext *ctx);
+  void enterValue(AslAst::NodeId n);
+  void exitValue(AslAst::NodeId n);
 
-  void enterExprIdent(AslParser::ExprIdentContext *ctx);
-  void exitExprIdent(AslParser::ExprIdentContext *ctx);
+  void enterExprIdent(AslAst::NodeId n);
+  void exitExprIdent(AslAst::NodeId n);
 
-  void enterIdent(AslParser::IdentContext *ctx);
-  void exitIdent(AslParser::IdentContext *ctx);
-
-  // void enterEveryRule(antlr4::ParserRuleContext *ctx);
-  // void exitEveryRule(antlr4::ParserRuleContext *ctx);
-  // void visitTerminal(antlr4::tree::TerminalNode *node);
-  // void visitErrorNode(antlr4::tree::ErrorNode *node);
+  void enterIdent(AslAst::NodeId n);
+  void exitIdent(AslAst::NodeId n);
 
 private:
 
   // Attributes:
-  TypesMgr       & Types;
-  SymTable       & Symbols;
-  TreeDecoration & Decorations;
-  SemErrors      & Errors;
+  TypesMgr        & Types;
+  SymTable        & Symbols;
+  NodeDecorations & Decorations;
+  SemErrorLog     & Errors;
+  const AslAst    & Ast;
+  SymbolIndex     & Index;
 
   // Getters for the necessary tree node atributes:
   //   Scope and Type
-  SymTable::ScopeId getScopeDecor (antlr4::ParserRuleContext *ctx);
-  TypesMgr::TypeId  getTypeDecor  (antlr4::ParserRuleContext *ctx);
+  SymTable::ScopeId getScopeDecor (AslAst::NodeId n);
+  TypesMgr::TypeId  getTypeDecor  (AslAst::NodeId n);
 
   // Setters for the necessary tree node attributes:
   //   Scope and Type
-  void putScopeDecor (antlr4::ParserRuleContext *ctx, SymTable::ScopeId s);
-  void putTypeDecor  (antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t);
+  void putScopeDecor (AslAst::NodeId n, SymTable::ScopeId s);
+  void putTypeDecor  (AslAst::NodeId n, TypesMgr::TypeId t);
 
 };  // class SymbolsListener
@@ -0,0 +1,245 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    TempAllocator - Reuses the temporaries of a function whose
+//               lifetimes do not overlap
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "TempAllocator.h"
+
+#include "IrCode.h"
+
+#include <vector>
+#include <queue>
+#include <algorithm>  // std::sort
+#include <functional> // std::greater
+#include <limits>
+#include <utility>    // std::pair
+
+
+static const uint32_t    NONE = std::numeric_limits<uint32_t>::max();
+static const std::size_t NOWHERE = std::numeric_limits<std::size_t>::max();
+
+
+// Constructor
+TempAllocator::TempAllocator(IrFunction & Fn) :
+  Fn(Fn) {
+}
+
+bool TempAllocator::run() {
+  Code.clear();
+  for (IrInstr & i : Fn.instructions())
+    Code.push_back(&i);
+  if (Fn.numTemps() == 0)
+    return false;
+  buildBlocks();
+  computeLiveness();
+  computeIntervals();
+  std::vector<uint32_t> newId;
+  uint32_t count = linearScan(newId);
+  Fn.renameTemps(newId, count);
+  // a copy whose source and destination got the same name does nothing
+  Fn.instructions().remove_if([](const IrInstr & i) {
+    return i.op == IrOp::LOAD and i.arg[0] == i.arg[1];
+  });
+  return true;
+}
+
+void TempAllocator::buildBlocks() {
+  Blocks.clear();
+  std::vector<uint32_t> blockOfLabel;
+  for (std::size_t n = 0; n < Code.size(); ++n) {
+    const IrInstr & i = *Code[n];
+    if (Blocks.empty() or i.op == IrOp::LABEL or
+        (n > 0 and (Code[n-1]->op == IrOp::UJUMP or Code[n-1]->op == IrOp::FJUMP or
+                    Code[n-1]->op == IrOp::RETURN)))
+      Blocks.push_back(Block{n, n, {}});
+    Blocks.back().last = n;
+    if (i.op == IrOp::LABEL) {
+      if (blockOfLabel.size() <= i.arg[0].id)
+        blockOfLabel.resize(i.arg[0].id + 1, NONE);
+      blockOfLabel[i.arg[0].id] = Blocks.size() - 1;
+    }
+  }
+  for (std::size_t b = 0; b < Blocks.size(); ++b) {
+    const IrInstr & i = *Code[Blocks[b].last];
+    if (i.op == IrOp::UJUMP or i.op == IrOp::FJUMP) {
+      IrOperand label = i.op == IrOp::UJUMP ? i.arg[0] : i.arg[1];
+      if (label.id < blockOfLabel.size() and blockOfLabel[label.id] != NONE)
+        Blocks[b].succs.push_back(blockOfLabel[label.id]);
+    }
+    if (i.op != IrOp::UJUMP and i.op != IrOp::RETURN and b + 1 < Blocks.size())
+      Blocks[b].succs.push_back(b + 1);
+  }
+}
+
+void TempAllocator::computeLiveness() {
+  // the temporaries that may be live at the boundary of a block: those
+  // of several blocks, or read in a block before being written
+  std::size_t numTemps = Fn.numTemps() + 1;
+  std::vector<uint32_t> blockOf(numTemps, NONE);
+  std::vector<char>     defined(numTemps, false);
+  GlobalIndex.assign(numTemps, NONE);
+  Globals.clear();
+  IrOperand used[3];
+  auto makeGlobal = [&](uint32_t t) {
+    if (GlobalIndex[t] == NONE) {
+      GlobalIndex[t] = Globals.size();
+      Globals.push_back(t);
+    }
+  };
+  for (std::size_t b = 0; b < Blocks.size(); ++b) {
+    for (std::size_t n = Blocks[b].first; n <= Blocks[b].last; ++n) {
+      const IrInstr & i = *Code[n];
+      std::size_t k = i.uses(used);
+      for (std::size_t u = 0; u < k; ++u) {
+        if (not used[u].isTemp())
+          continue;
+        uint32_t t = used[u].id;
+        if (blockOf[t] != b or not defined[t])
+          makeGlobal(t);
+        blockOf[t] = b;
+      }
+      if (i.definesFirst() and i.arg[0].isTemp()) {
+        uint32_t t = i.arg[0].id;
+        if (blockOf[t] != NONE and blockOf[t] != b)
+          makeGlobal(t);
+        blockOf[t] = b;
+        defined[t] = true;
+      }
+    }
+    // 'defined' only holds inside a block
+    for (std::size_t n = Blocks[b].first; n <= Blocks[b].last; ++n)
+      if (Code[n]->definesFirst() and Code[n]->arg[0].isTemp())
+        defined[Code[n]->arg[0].id] = false;
+  }
+
+  // the uses (read before written) and the definitions of each block
+  std::size_t words = (Globals.size() + 63) / 64;
+  std::vector<BitSet> use(Blocks.size(), BitSet(words, 0));
+  std::vector<BitSet> def(Blocks.size(), BitSet(words, 0));
+  for (std::size_t b = 0; b < Blocks.size(); ++b) {
+    for (std::size_t n = Blocks[b].first; n <= Blocks[b].last; ++n) {
+      const IrInstr & i = *Code[n];
+      std::size_t k = i.uses(used);
+      for (std::size_t u = 0; u < k; ++u) {
+        if (not used[u].isTemp() or GlobalIndex[used[u].id] == NONE)
+          continue;
+        uint32_t g = GlobalIndex[used[u].id];
+        if (not (def[b][g / 64] >> (g % 64) & 1))
+          use[b][g / 64] |= uint64_t(1) << (g % 64);
+      }
+      if (i.definesFirst() and i.arg[0].isTemp() and GlobalIndex[i.arg[0].id] != NONE) {
+        uint32_t g = GlobalIndex[i.arg[0].id];
+        def[b][g / 64] |= uint64_t(1) << (g % 64);
+      }
+    }
+  }
+
+  // in(b) = use(b) + (out(b) - def(b)),  out(b) = union of in(succs)
+  LiveIn.assign(Blocks.size(), BitSet(words, 0));
+  LiveOut.assign(Blocks.size(), BitSet(words, 0));
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (std::size_t b = Blocks.size(); b-- > 0; ) {
+      BitSet & out = LiveOut[b];
+      for (uint32_t s : Blocks[b].succs)
+        for (std::size_t w = 0; w < words; ++w)
+          out[w] |= LiveIn[s][w];
+      for (std::size_t w = 0; w < words; ++w) {
+        uint64_t in = use[b][w] | (out[w] & ~def[b][w]);
+        if (in != LiveIn[b][w]) {
+          LiveIn[b][w] = in;
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+void TempAllocator::computeIntervals() {
+  std::size_t numTemps = Fn.numTemps() + 1;
+  Start.assign(numTemps, NOWHERE);
+  End.assign(numTemps, 0);
+  auto extend = [&](uint32_t t, std::size_t pos) {
+    if (Start[t] == NOWHERE or pos < Start[t])
+      Start[t] = pos;
+    if (pos > End[t])
+      End[t] = pos;
+  };
+  IrOperand used[3];
+  for (std::size_t n = 0; n < Code.size(); ++n) {
+    const IrInstr & i = *Code[n];
+    std::size_t k = i.uses(used);
+    for (std::size_t u = 0; u < k; ++u)
+      if (used[u].isTemp())
+        extend(used[u].id, 2 * n);
+    // a temporary only written lives at least until it is written
+    for (const IrOperand & o : i.arg)
+      if (o.isTemp())
+        extend(o.id, i.definesFirst() and o == i.arg[0] ? 2 * n + 1 : 2 * n);
+  }
+  for (std::size_t b = 0; b < Blocks.size(); ++b)
+    for (std::size_t g = 0; g < Globals.size(); ++g) {
+      if (LiveIn[b][g / 64] >> (g % 64) & 1)
+        extend(Globals[g], 2 * Blocks[b].first);
+      if (LiveOut[b][g / 64] >> (g % 64) & 1)
+        extend(Globals[g], 2 * Blocks[b].last + 2);
+    }
+}
+
+uint32_t TempAllocator::linearScan(std::vector<uint32_t> & newId) const {
+  std::vector<uint32_t> order;
+  for (uint32_t t = 1; t < Start.size(); ++t)
+    if (Start[t] != NOWHERE)
+      order.push_back(t);
+  std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+      return Start[a] < Start[b] or (Start[a] == Start[b] and a < b);
+    });
+
+  typedef std::pair<std::size_t, uint32_t> Active;   // end, name
+  std::priority_queue<Active, std::vector<Active>, std::greater<Active>> active;
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> free;
+  uint32_t count = 0;
+  newId.assign(Start.size(), 0);
+  for (uint32_t t : order) {
+    while (not active.empty() and active.top().first < Start[t]) {
+      free.push(active.top().second);
+      active.pop();
+    }
+    uint32_t name;
+    if (free.empty())
+      name = ++count;
+    else {
+      name = free.top();
+      free.pop();
+    }
+    newId[t] = name;
+    active.push(Active(End[t], name));
+  }
+  return count;
+}
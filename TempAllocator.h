@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    TempAllocator - Reuses the temporaries of a function whose
+//               lifetimes do not overlap
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <cstdint>    // uint32_t, uint64_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class TempAllocator: an optimization pass that gives the temporaries
+// of a function as few names as possible, as a register allocator
+// does with an unbounded number of registers. The code generator
+// takes a new temporary for every node, so without it the frame of a
+// function has a slot for each one.
+//  - Liveness: the code is split in basic blocks, and the temporaries
+//    live at their entry and exit are computed by the usual backwards
+//    dataflow. Only the temporaries that appear in more than one
+//    block, or are read before being written in their block, take
+//    part in it: the rest live inside a block.
+//  - Lifetimes: each temporary gets the interval of the positions of
+//    the code (in its order) where it is live. A read comes before
+//    the write of the same instruction, so the destination can reuse
+//    the name of an operand read for the last time.
+//  - Linear scan: the intervals are taken by their start and each one
+//    gets the lowest name free at that point.
+//  - The copies left between two temporaries of the same name (as
+//    those of the phis of the SSA form) are removed.
+
+class TempAllocator {
+
+public:
+
+  // Constructor
+  TempAllocator(IrFunction & Fn);
+
+  // Run the pass; returns true if the temporaries have been renamed
+  bool run();
+
+private:
+
+  struct Block {
+    std::size_t           first, last;   // instructions [first, last]
+    std::vector<uint32_t> succs;
+  };
+
+  typedef std::vector<uint64_t> BitSet;
+
+  void buildBlocks();
+  void computeLiveness();
+  void computeIntervals();
+  uint32_t linearScan(std::vector<uint32_t> & newId) const;
+
+  // Attributes
+  IrFunction &                 Fn;
+  std::vector<IrInstr *>       Code;
+  std::vector<Block>           Blocks;
+  // index of each temporary among the global ones (or NONE)
+  std::vector<uint32_t>        GlobalIndex;
+  std::vector<uint32_t>        Globals;
+  std::vector<BitSet>          LiveIn, LiveOut;
+  // lifetime of each temporary, in positions: 2i reads and 2i+1
+  // writes instruction i
+  std::vector<std::size_t>     Start, End;
+
+};  // class TempAllocator
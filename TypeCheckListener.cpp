@@ -1,6 +1,6 @@
 //////////////////////////////////////////////////////////////////////
 //
-//    TypeCheckListener - Walk the parser tree to do the semantic
+//    TypeCheckListener - Walk the AST to do the semantic
 //                        typecheck for the Asl programming language
 //
 //    Copyright (C) 2018  Universitat Politecnica de Catalunya
@@ -29,12 +29,13 @@
 
 #include "TypeCheckListener.h"
 
-#include "antlr4-runtime.h"
+#include "AslParser.h"
 
 #include "../common/TypesMgr.h"
 #include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
+#include "NodeDecorations.h"
+#include "SymbolIndex.h"
+#include "SemErrorLog.h"
 
 #include <iostream>
 #include <string>
@@ -46,212 +47,230 @@
 using namespace std;
 
 
+// Text of a relational operator, as TypesMgr::comparableTypes takes it
+static std::string relationalText(std::size_t op) {
+  switch (op) {
+  case AslParser::EQUAL: return "==";
+  case AslParser::NE:    return "!=";
+  case AslParser::GT:    return ">";
+  case AslParser::GE:    return ">=";
+  case AslParser::LE:    return "<=";
+  case AslParser::LT:    return "<";
+  }
+  return "";
+}
+
 // Constructor
-TypeCheckListener::TypeCheckListener(TypesMgr       & Types,
-				     SymTable       & Symbols,
-				     TreeDecoration & Decorations,
-				     SemErrors      & Errors) :
+TypeCheckListener::TypeCheckListener(TypesMgr        & Types,
+				     SymTable        & Symbols,
+				     NodeDecorations & Decorations,
+				     SemErrorLog     & Errors,
+				     const AslAst    & Ast,
+				     const SymbolIndex & Index) :
   Types{Types},
   Symbols {Symbols},
   Decorations{Decorations},
-  Errors{Errors} {
-}
-
-void TypeCheckListener::enterProgram(AslParser::ProgramContext *ctx) {
+  Errors{Errors},
+  Ast{Ast},
+  Index{Index},
+  CurrentScope{0},
+  IntegerTy{Types.createIntegerTy()},
+  FloatTy{Types.createFloatTy()},
+  BooleanTy{Types.createBooleanTy()},
+  CharacterTy{Types.createCharacterTy()},
+  VoidTy{Types.createVoidTy()},
+  ErrorTy{Types.createErrorTy()},
+  CurrentFunctionTy{VoidTy} {
+}
+
+void TypeCheckListener::enterProgram(AslAst::NodeId n) {
   DEBUG_ENTER();
-  SymTable::ScopeId sc = getScopeDecor(ctx);
+  SymTable::ScopeId sc = getScopeDecor(n);
   Symbols.pushThisScope(sc);
 }
-void TypeCheckListener::exitProgram(AslParser::ProgramContext *ctx) {
+void TypeCheckListener::exitProgram(AslAst::NodeId n) {
   if (Symbols.noMainProperlyDeclared())
-    Errors.noMainProperlyDeclared(ctx);
+    Errors.noMainProperlyDeclared(n);
   Symbols.popScope();
-  Errors.print();
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterFunction(AslParser::FunctionContext *ctx) {
+void TypeCheckListener::enterFunction(AslAst::NodeId n) {
   DEBUG_ENTER();
-  SymTable::ScopeId sc = getScopeDecor(ctx);
-  Symbols.pushThisScope(sc);
-
-  TypesMgr::TypeId tRet = Types.createVoidTy();
-  if(ctx->return_type()){
-    tRet = getTypeDecor(ctx->return_type()->type());
+  // the identifiers of the body are looked up in the Index, so the
+  // scope of the function is not pushed in the SymTable
+  CurrentScope = Index.scopeOf(n);
+
+  TypesMgr::TypeId tRet = VoidTy;
+  AslAst::NodeId ret = Ast.findChild(n, AslAst::Return_type);
+  if(ret != AslAst::NoNode){
+    tRet = getTypeDecor(Ast.child(ret, 0));
   }
-  Symbols.setCurrentFunctionTy(tRet);
-  // Symbols.print();
+  CurrentFunctionTy = tRet;
 }
-void TypeCheckListener::exitFunction(AslParser::FunctionContext *ctx) {
-  Symbols.popScope();
+void TypeCheckListener::exitFunction(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
 
 
-void TypeCheckListener::enterDeclarations(AslParser::DeclarationsContext *ctx) {
+void TypeCheckListener::enterDeclarations(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitDeclarations(AslParser::DeclarationsContext *ctx) {
+void TypeCheckListener::exitDeclarations(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterVariable_decl(AslParser::Variable_declContext *ctx) {
+void TypeCheckListener::enterVariable_decl(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitVariable_decl(AslParser::Variable_declContext *ctx) {
+void TypeCheckListener::exitVariable_decl(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterType(AslParser::TypeContext *ctx) {
+void TypeCheckListener::enterType(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitType(AslParser::TypeContext *ctx) {
+void TypeCheckListener::exitType(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterStatements(AslParser::StatementsContext *ctx) {
+void TypeCheckListener::enterStatements(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitStatements(AslParser::StatementsContext *ctx) {
+void TypeCheckListener::exitStatements(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterAssignStmt(AslParser::AssignStmtContext *ctx) {
+void TypeCheckListener::enterAssignStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
 
-void TypeCheckListener::exitAssignStmt(AslParser::AssignStmtContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->left_expr());
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr());
+void TypeCheckListener::exitAssignStmt(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
 
   if ((not Types.isErrorTy(t1)) and (not Types.isErrorTy(t2)) and
       (not Types.copyableTypes(t1, t2)) ) {
-    Errors.incompatibleAssignment(ctx->ASSIGN());
+    Errors.incompatibleAssignment(n);
   }
 
 
-  if ((not Types.isErrorTy(t1)) and (not getIsLValueDecor(ctx->left_expr())))
-    Errors.nonReferenceableLeftExpr(ctx->left_expr());
+  if ((not Types.isErrorTy(t1)) and (not getIsLValueDecor(Ast.child(n, 0))))
+    Errors.nonReferenceableLeftExpr(Ast.child(n, 0));
 
 
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterReturn(AslParser::ReturnContext *ctx){
+void TypeCheckListener::enterReturn(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitReturn(AslParser::ReturnContext *ctx){
+void TypeCheckListener::exitReturn(AslAst::NodeId n){
   DEBUG_EXIT();
 
-  if(ctx -> expr()){
-    TypesMgr::TypeId t = getTypeDecor(ctx->expr());
+  if(Ast.node(n).numChildren > 0){
+    TypesMgr::TypeId t = getTypeDecor(Ast.child(n, 0));
     if(not Types.isErrorTy(t) and not Types.isPrimitiveNonVoidTy(t)){
-      Errors.incompatibleReturn(ctx->RETURN());
+      Errors.incompatibleReturn(n);
     }
-    else if(not Types.isErrorTy(t) and not Types.equalTypes(t, Symbols.getCurrentFunctionTy())){
-      if(not Types.copyableTypes( Symbols.getCurrentFunctionTy(),t))
-        Errors.incompatibleReturn(ctx->RETURN());
+    else if(not Types.isErrorTy(t) and not Types.equalTypes(t, CurrentFunctionTy)){
+      if(not Types.copyableTypes( CurrentFunctionTy,t))
+        Errors.incompatibleReturn(n);
     }
 
   }
   else{
-    if(not Types.isVoidTy(Symbols.getCurrentFunctionTy())){
-      Errors.incompatibleReturn(ctx->RETURN());
+    if(not Types.isVoidTy(CurrentFunctionTy)){
+      Errors.incompatibleReturn(n);
     }
   }
 
 }
 
-void TypeCheckListener::enterIfStmt(AslParser::IfStmtContext *ctx) {
+void TypeCheckListener::enterIfStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitIfStmt(AslParser::IfStmtContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr());
+void TypeCheckListener::exitIfStmt(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
   if ((not Types.isErrorTy(t1)) and (not Types.isBooleanTy(t1)))
-    Errors.booleanRequired(ctx);
+    Errors.booleanRequired(n);
   DEBUG_EXIT();
 }
 
 
-void TypeCheckListener::enterWhileStmt(AslParser::WhileStmtContext *ctx){
+void TypeCheckListener::enterWhileStmt(AslAst::NodeId n){
 DEBUG_ENTER();
 }
-void TypeCheckListener::exitWhileStmt(AslParser::WhileStmtContext *ctx){
-	TypesMgr::TypeId t1 = getTypeDecor(ctx->expr());
+void TypeCheckListener::exitWhileStmt(AslAst::NodeId n){
+	TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
 	if ((not Types.isErrorTy(t1)) and (not Types.isBooleanTy(t1)))
-	Errors.booleanRequired(ctx);
+	Errors.booleanRequired(n);
 	DEBUG_EXIT();
 }
 
 
-void TypeCheckListener::enterProcCall(AslParser::ProcCallContext *ctx) {
+void TypeCheckListener::enterProcCall(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitProcCall(AslParser::ProcCallContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->ident());
+void TypeCheckListener::exitProcCall(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
 
   if(Types.isFunctionTy(t1)){
     //TypesMgr::TypeId return_ty = Types.getFuncReturnType(t1);
     //assert(Types.isVoidTy(return_ty));
     //if(not Types.isVoidTy(return_ty)){
-    //	Errors.isNotProcedure(ctx->ident());
+    //	Errors.isNotProcedure(Ast.child(n, 0));
     //}
 
     int numParams = Types.getNumOfParameters(t1);
-    int comptadorParams = ctx->expr().size();
-    //if(ctx->expr(0)){
-    //  for(auto i:ctx->expr()) comptadorParams++;
-    //}
+    int comptadorParams = Ast.node(n).numChildren - 1;
     if(comptadorParams != numParams){
-    		Errors.numberOfParameters(ctx->ident());
+    		Errors.numberOfParameters(Ast.child(n, 0));
     }
     else{
       vector<TypesMgr::TypeId> param_types = Types.getFuncParamsTypes(t1);
 
       for(uint i = 0; i < Types.getNumOfParameters(t1); i++){
-          if(not Types.copyableTypes(param_types[i] , getTypeDecor(ctx->expr(i))))
-            Errors.incompatibleParameter(ctx->expr(i), i+1, ctx->ident());
+          if(not Types.copyableTypes(param_types[i] , getTypeDecor(Ast.child(n, i + 1))))
+            Errors.incompatibleParameter(Ast.child(n, i + 1), i+1, Ast.child(n, 0));
 
       }
 
     }
   }
   else if (not Types.isFunctionTy(t1) and not Types.isErrorTy(t1)) { //treure la primera comprovacio, pero es per recordar el que fa
-    Errors.isNotCallable(ctx->ident());
+    Errors.isNotCallable(Ast.child(n, 0));
   }
 
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterReturn_func(AslParser::Return_funcContext *ctx){
+void TypeCheckListener::enterReturn_func(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitReturn_func(AslParser::Return_funcContext *ctx){
-TypesMgr::TypeId t1 = getTypeDecor(ctx->ident());
-TypesMgr::TypeId tAux = Types.createErrorTy();
+void TypeCheckListener::exitReturn_func(AslAst::NodeId n){
+TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+TypesMgr::TypeId tAux = ErrorTy;
   if(Types.isFunctionTy(t1)){
     TypesMgr::TypeId return_ty = Types.getFuncReturnType(t1);
 
     if(Types.isVoidTy(return_ty)){
-    	Errors.isNotFunction(ctx->ident());
+    	Errors.isNotFunction(Ast.child(n, 0));
     }
     else tAux = return_ty;
 
     int numParams = Types.getNumOfParameters(t1);
-    int comptadorParams = ctx->expr().size();
-    //if(ctx->expr(0)){
-    //  for(auto i:ctx->expr()) comptadorParams++;
-    //}
+    int comptadorParams = Ast.node(n).numChildren - 1;
     if(comptadorParams != numParams){
-        Errors.numberOfParameters(ctx->ident());
+        Errors.numberOfParameters(Ast.child(n, 0));
     }
     else{
       vector<TypesMgr::TypeId> param_types = Types.getFuncParamsTypes(t1);
 
       for(uint i = 0; i < Types.getNumOfParameters(t1); i++){
-          if(not Types.copyableTypes(param_types[i] , getTypeDecor(ctx->expr(i))))
-            Errors.incompatibleParameter(ctx->expr(i), i+1, ctx->ident());
+          if(not Types.copyableTypes(param_types[i] , getTypeDecor(Ast.child(n, i + 1))))
+            Errors.incompatibleParameter(Ast.child(n, i + 1), i+1, Ast.child(n, 0));
 
       }
     }
@@ -259,63 +278,63 @@ TypesMgr::TypeId tAux = Types.createErrorTy();
 
   }
   else if (not Types.isFunctionTy(t1) and not Types.isErrorTy(t1)) { //treure la primera comprovacio, pero es per recordar el que fa
-    Errors.isNotCallable(ctx->ident());
+    Errors.isNotCallable(Ast.child(n, 0));
   }
-  bool b = getIsLValueDecor(ctx->ident());
-  putIsLValueDecor(ctx, b);
-  putTypeDecor(ctx, tAux);
+  bool b = getIsLValueDecor(Ast.child(n, 0));
+  putIsLValueDecor(n, b);
+  putTypeDecor(n, tAux);
 
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterReadStmt(AslParser::ReadStmtContext *ctx) {
+void TypeCheckListener::enterReadStmt(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitReadStmt(AslParser::ReadStmtContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->left_expr());
+void TypeCheckListener::exitReadStmt(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
   if ((not Types.isErrorTy(t1)) and (not Types.isPrimitiveTy(t1)) and
       (not Types.isFunctionTy(t1)))
-    Errors.readWriteRequireBasic(ctx);
-  if ((not Types.isErrorTy(t1)) and (not getIsLValueDecor(ctx->left_expr())))
-    Errors.nonReferenceableExpression(ctx);
+    Errors.readWriteRequireBasic(n);
+  if ((not Types.isErrorTy(t1)) and (not getIsLValueDecor(Ast.child(n, 0))))
+    Errors.nonReferenceableExpression(n);
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterWriteExpr(AslParser::WriteExprContext *ctx) {
+void TypeCheckListener::enterWriteExpr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitWriteExpr(AslParser::WriteExprContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr());
+void TypeCheckListener::exitWriteExpr(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
   if ((not Types.isErrorTy(t1)) and (not Types.isPrimitiveTy(t1)))
-    Errors.readWriteRequireBasic(ctx);
+    Errors.readWriteRequireBasic(n);
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterWriteString(AslParser::WriteStringContext *ctx) {
+void TypeCheckListener::enterWriteString(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitWriteString(AslParser::WriteStringContext *ctx) {
+void TypeCheckListener::exitWriteString(AslAst::NodeId n) {
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterLeft_expr(AslParser::Left_exprContext *ctx) {
+void TypeCheckListener::enterLeft_expr(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->ident());
-  TypesMgr::TypeId tRes = Types.createErrorTy();
+void TypeCheckListener::exitLeft_expr(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId tRes = ErrorTy;
   //cout << not Types.isErrorTy(t1) << endl;
 
-  if(ctx->expr()){
+  if(Ast.node(n).numChildren > 1){
     bool estaBe = true;
     if(not Types.isErrorTy(t1) and not Types.isArrayTy(t1)){
-      Errors.nonArrayInArrayAccess(ctx->ident());
+      Errors.nonArrayInArrayAccess(Ast.child(n, 0));
       estaBe = false;
     }
 
-    TypesMgr::TypeId t2 = getTypeDecor(ctx->expr());
+    TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
     if(not Types.isErrorTy(t2) and not Types.isIntegerTy(t2)){
-      Errors.nonIntegerIndexInArrayAccess(ctx->expr());
+      Errors.nonIntegerIndexInArrayAccess(Ast.child(n, 1));
       estaBe = false;
     }
 
@@ -329,37 +348,37 @@ void TypeCheckListener::exitLeft_expr(AslParser::Left_exprContext *ctx) {
   }
 
 
-  putTypeDecor(ctx, tRes);
-  bool b = getIsLValueDecor(ctx->ident());
-  putIsLValueDecor(ctx, b);
+  putTypeDecor(n, tRes);
+  bool b = getIsLValueDecor(Ast.child(n, 0));
+  putIsLValueDecor(n, b);
   DEBUG_EXIT();
 }
 
 
 
-void TypeCheckListener::enterArray_read(AslParser::Array_readContext *ctx){
+void TypeCheckListener::enterArray_read(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitArray_read(AslParser::Array_readContext *ctx){
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->ident());
-  TypesMgr::TypeId tRes = Types.createErrorTy();
+void TypeCheckListener::exitArray_read(AslAst::NodeId n){
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId tRes = ErrorTy;
 
   bool estaBe = true;
 
   if(not Types.isErrorTy(t1) and not Types.isArrayTy(t1)){
-    Errors.nonArrayInArrayAccess(ctx->ident());
+    Errors.nonArrayInArrayAccess(Ast.child(n, 0));
     estaBe = false;
   }
 
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr());
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
   if(not Types.isErrorTy(t2) and not Types.isIntegerTy(t2)){
-    Errors.nonIntegerIndexInArrayAccess(ctx->expr());
+    Errors.nonIntegerIndexInArrayAccess(Ast.child(n, 1));
     estaBe = false;
   }
   if(estaBe and not Types.isErrorTy(t1)) tRes = Types.getArrayElemType(t1);
-  putTypeDecor(ctx, tRes);
-  bool b = getIsLValueDecor(ctx->ident());
-  putIsLValueDecor(ctx, b);
+  putTypeDecor(n, tRes);
+  bool b = getIsLValueDecor(Ast.child(n, 0));
+  putIsLValueDecor(n, b);
   DEBUG_EXIT();
 }
 
@@ -368,159 +387,157 @@ void TypeCheckListener::exitArray_read(AslParser::Array_readContext *ctx){
 
 
 
-void TypeCheckListener::enterArithmetic(AslParser::ArithmeticContext *ctx) {
+void TypeCheckListener::enterArithmetic(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitArithmetic(AslParser::ArithmeticContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  TypesMgr::TypeId t = Types.createIntegerTy();
+void TypeCheckListener::exitArithmetic(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  TypesMgr::TypeId t = IntegerTy;
   if(Types.isFloatTy(t1) or Types.isFloatTy(t2)){
-        t = Types.createFloatTy();
+        t = FloatTy;
   }
 
   if (((not Types.isErrorTy(t1)) and (not Types.isNumericTy(t1))) or
       ((not Types.isErrorTy(t2)) and (not Types.isNumericTy(t2)))){
-    Errors.incompatibleOperator(ctx->op);
+    Errors.incompatibleOperator(n);
   }
   else {
-    if(ctx->MOD()){
+    if(Ast.node(n).op == AslParser::MOD){
       if((not Types.isErrorTy(t1) and not Types.isIntegerTy(t1)) or (not Types.isErrorTy(t2) and not Types.isIntegerTy(t2))){
-        Errors.incompatibleOperator(ctx->op);
+        Errors.incompatibleOperator(n);
       }
-      t = Types.createIntegerTy();
+      t = IntegerTy;
     }
   }
-  putTypeDecor(ctx, t);
-  putIsLValueDecor(ctx, false);
+  putTypeDecor(n, t);
+  putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterRelational(AslParser::RelationalContext *ctx) {
+void TypeCheckListener::enterRelational(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitRelational(AslParser::RelationalContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  TypesMgr::TypeId t = Types.createBooleanTy();
-  std::string oper = ctx->op->getText();
+void TypeCheckListener::exitRelational(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  TypesMgr::TypeId t = BooleanTy;
+  std::string oper = relationalText(Ast.node(n).op);
   if ((not Types.isErrorTy(t1)) and (not Types.isErrorTy(t2)) and
       (not Types.comparableTypes(t1, t2, oper))){
-    Errors.incompatibleOperator(ctx->op);
+    Errors.incompatibleOperator(n);
   }
 
 
-  putTypeDecor(ctx, t);
-  putIsLValueDecor(ctx, false);
+  putTypeDecor(n, t);
+  putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
 
 
-void TypeCheckListener::enterNotplusminus(AslParser::NotplusminusContext *ctx){
+void TypeCheckListener::enterNotplusminus(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitNotplusminus(AslParser::NotplusminusContext *ctx){
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr());
-  TypesMgr::TypeId t = Types.createVoidTy();
-  if(ctx->NOT()){
+void TypeCheckListener::exitNotplusminus(AslAst::NodeId n){
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t = VoidTy;
+  if(Ast.node(n).op == AslParser::NOT){
 		if((not Types.isErrorTy(t1)) and (not Types.isBooleanTy(t1))){
-			Errors.incompatibleOperator(ctx->op);
-			//Errors.booleanRequired(ctx->expr());
-			//t = Types.createErrorTy();
+			Errors.incompatibleOperator(n);
+			//Errors.booleanRequired(Ast.child(n, 0));
+			//t = ErrorTy;
 	}
-     t = Types.createBooleanTy();
+     t = BooleanTy;
 
   }
-  else if(ctx->PLUS()){
+  else if(Ast.node(n).op == AslParser::PLUS){
     if(not Types.isErrorTy(t1) and not Types.isNumericTy(t1)){
-      Errors.incompatibleOperator(ctx->op);
+      Errors.incompatibleOperator(n);
     }
-    t = Types.createIntegerTy();
+    t = IntegerTy;
     if(Types.isFloatTy(t1)){
-      t = Types.createFloatTy();
+      t = FloatTy;
     }
   }
-  else if(ctx->MINUS()){
+  else if(Ast.node(n).op == AslParser::MINUS){
     if(not Types.isErrorTy(t1) and not Types.isNumericTy(t1)){
-      Errors.incompatibleOperator(ctx->op);
+      Errors.incompatibleOperator(n);
     }
-    t = Types.createIntegerTy();
+    t = IntegerTy;
     if(Types.isFloatTy(t1)){
-      t = Types.createFloatTy();
+      t = FloatTy;
     }
 
   }
-  putTypeDecor(ctx, t);
-    putIsLValueDecor(ctx, false);
+  putTypeDecor(n, t);
+    putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
 
-void TypeCheckListener::enterLogic(AslParser::LogicContext * ctx){
+void TypeCheckListener::enterLogic(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitLogic(AslParser::LogicContext * ctx){
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->expr(0));
-  TypesMgr::TypeId t2 = getTypeDecor(ctx->expr(1));
-  TypesMgr::TypeId t = Types.createVoidTy();
-  std::string oper = ctx->op->getText();
-
+void TypeCheckListener::exitLogic(AslAst::NodeId n){
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  TypesMgr::TypeId t2 = getTypeDecor(Ast.child(n, 1));
+  TypesMgr::TypeId t = VoidTy;
 
   if ((not Types.isErrorTy(t1)) and (not Types.isErrorTy(t2)) and
       (not Types.equalTypes(t1, t2) or not Types.isBooleanTy(t1))){
-        Errors.incompatibleOperator(ctx->op);
+        Errors.incompatibleOperator(n);
   }
-  t = Types.createBooleanTy();
+  t = BooleanTy;
 
-  putTypeDecor(ctx, t);
-  putIsLValueDecor(ctx, false);
+  putTypeDecor(n, t);
+  putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
 
 
-void TypeCheckListener::enterValue(AslParser::ValueContext *ctx) {
+void TypeCheckListener::enterValue(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitValue(AslParser::ValueContext *ctx) { //NO SE SI HAURIA D"ANAR AL SYMBOL
-    TypesMgr::TypeId t = Types.createVoidTy();
-  if(ctx->INTVAL()){
-    t = Types.createIntegerTy();
+void TypeCheckListener::exitValue(AslAst::NodeId n) { //NO SE SI HAURIA D"ANAR AL SYMBOL
+    TypesMgr::TypeId t = VoidTy;
+  if(Ast.node(n).op == AslParser::INTVAL){
+    t = IntegerTy;
   }
-  else if(ctx->CHARVAL()){
-    t = Types.createCharacterTy();
+  else if(Ast.node(n).op == AslParser::CHARVAL){
+    t = CharacterTy;
   }
-  else if(ctx->BOOLVAL()){
-    t = Types.createBooleanTy();
+  else if(Ast.node(n).op == AslParser::BOOLVAL){
+    t = BooleanTy;
   }
 
-  else if(ctx->FLOATVAL()){
-    t = Types.createFloatTy();
+  else if(Ast.node(n).op == AslParser::FLOATVAL){
+    t = FloatTy;
   }
-  putTypeDecor(ctx, t);
-  putIsLValueDecor(ctx, false);
+  putTypeDecor(n, t);
+  putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterPar(AslParser::ParContext *ctx){
+void TypeCheckListener::enterPar(AslAst::NodeId n){
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitPar(AslParser::ParContext *ctx){
-  TypesMgr::TypeId t = getTypeDecor(ctx->expr());
-  putTypeDecor(ctx, t);
-  putIsLValueDecor(ctx, false);
+void TypeCheckListener::exitPar(AslAst::NodeId n){
+  TypesMgr::TypeId t = getTypeDecor(Ast.child(n, 0));
+  putTypeDecor(n, t);
+  putIsLValueDecor(n, false);
   DEBUG_EXIT();
 }
 
-void TypeCheckListener::enterExprIdent(AslParser::ExprIdentContext *ctx) {
+void TypeCheckListener::enterExprIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitExprIdent(AslParser::ExprIdentContext *ctx) {
-  TypesMgr::TypeId t1 = getTypeDecor(ctx->ident());
-  putTypeDecor(ctx, t1);
-  bool b = getIsLValueDecor(ctx->ident());
-  putIsLValueDecor(ctx, b);
+void TypeCheckListener::exitExprIdent(AslAst::NodeId n) {
+  TypesMgr::TypeId t1 = getTypeDecor(Ast.child(n, 0));
+  putTypeDecor(n, t1);
+  bool b = getIsLValueDecor(Ast.child(n, 0));
+  putIsLValueDecor(n, b);
   DEBUG_EXIT();
 }
 
@@ -528,63 +545,54 @@ void TypeCheckListener::exitExprIdent(AslParser::ExprIdentContext *ctx) {
 
 
 
-void TypeCheckListener::enterIdent(AslParser::IdentContext *ctx) {
+void TypeCheckListener::enterIdent(AslAst::NodeId n) {
   DEBUG_ENTER();
 }
-void TypeCheckListener::exitIdent(AslParser::IdentContext *ctx) {
-  std::string ident = ctx->getText();
-  if (Symbols.findInStack(ident) == -1) {
-    Errors.undeclaredIdent(ctx->ID());
-    TypesMgr::TypeId te = Types.createErrorTy();
-    putTypeDecor(ctx, te);
-    putIsLValueDecor(ctx, true);
+void TypeCheckListener::exitIdent(AslAst::NodeId n) {
+  // resolved once: the handle stays on the node for the next passes
+  SymbolHandle sym = Index.lookup(CurrentScope, Ast.nameId(n));
+  putSymbolDecor(n, sym);
+  if (sym.isNone()) {
+    Errors.undeclaredIdent(n);
+    TypesMgr::TypeId te = ErrorTy;
+    putTypeDecor(n, te);
+    putIsLValueDecor(n, true);
   }
   else {
-    TypesMgr::TypeId t1 = Symbols.getType(ident);
-    putTypeDecor(ctx, t1);
-    if (Symbols.isFunctionClass(ident))
-      putIsLValueDecor(ctx, false);
+    putTypeDecor(n, sym.type);
+    if (sym.isFunction())
+      putIsLValueDecor(n, false);
     else
-      putIsLValueDecor(ctx, true);
+      putIsLValueDecor(n, true);
   }
   DEBUG_EXIT();
 }
 
 
 
-// void TypeCheckListener::enterEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_ENTER();
-// }
-// void TypeCheckListener::exitEveryRule(antlr4::ParserRuleContext *ctx) {
-//   DEBUG_EXIT();
-// }
-// void TypeCheckListener::visitTerminal(antlr4::tree::TerminalNode *node) {
-//   DEBUG("visitTerminal");
-// }
-// void TypeCheckListener::visitErrorNode(antlr4::tree::ErrorNode *node) {
-// }
-
-
 // Getters for the necessary tree node atributes:
 //   Scope, Type ans IsLValue
-SymTable::ScopeId TypeCheckListener::getScopeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getScope(ctx);
+SymTable::ScopeId TypeCheckListener::getScopeDecor(AslAst::NodeId n) {
+  return Decorations.getScope(n);
 }
-TypesMgr::TypeId TypeCheckListener::getTypeDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getType(ctx);
+TypesMgr::TypeId TypeCheckListener::getTypeDecor(AslAst::NodeId n) {
+  return Decorations.getType(n);
 }
-bool TypeCheckListener::getIsLValueDecor(antlr4::ParserRuleContext *ctx) {
-  return Decorations.getIsLValue(ctx);
+bool TypeCheckListener::getIsLValueDecor(AslAst::NodeId n) {
+  return Decorations.getIsLValue(n);
 }
 
 // Setters for the necessary tree node attributes:
-//   Scope, Type ans IsLValue
-void TypeCheckListener::putScopeDecor(antlr4::ParserRuleContext *ctx, SymTable::ScopeId s) {
-  Decorations.putScope(ctx, s);
+//   Scope, Type, IsLValue and Symbol
+void TypeCheckListener::putScopeDecor(AslAst::NodeId n, SymTable::ScopeId s) {
+  Decorations.putScope(n, s);
+}
+void TypeCheckListener::putTypeDecor(AslAst::NodeId n, TypesMgr::TypeId t) {
+  Decorations.putType(n, t);
 }
-void TypeCheckListener::putTypeDecor(antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t) {
-  Decorations.putType(ctx, t);
+void TypeCheckListener::putIsLValueDecor(AslAst::NodeId n, bool b) {
+  Decorations.putIsLValue(n, b);
 }
-void TypeCheckListener::putIsLValueDecor(antlr4::ParserRuleContext *ctx, bool b) {
-  Decorations.putIsLValue(ctx, b);
+void TypeCheckListener::putSymbolDecor(AslAst::NodeId n, SymbolHandle s) {
+  Decorations.putSymbol(n, s);
 }
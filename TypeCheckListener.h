@@ -1,6 +1,6 @@
 //////////////////////////////////////////////////////////////////////
 //
-//    TypeCheckListener - Walk the parser tree to do the semantic
+//    TypeCheckListener - Walk the AST to do the semantic
 //                        typecheck for the Asl programming language
 //
 //    Copyright (C) 2018  Universitat Politecnica de Catalunya
@@ -29,134 +29,149 @@
 
 #pragma once
 
-#include "antlr4-runtime.h"
-#include "AslBaseListener.h"
+#include "AslAstListener.h"
+#include "AslAst.h"
+#include "SymbolIndex.h"
 
 #include "../common/TypesMgr.h"
 #include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
+#include "NodeDecorations.h"
+#include "SemErrorLog.h"
 
 // using namespace std;
 
 
 //////////////////////////////////////////////////////////////////////
-// Class TypeCheckListener: derived from AslBaseListener.
-// The tree walker go through the parser tree and call the methods of
+// Class TypeCheckListener: derived from AslAstListener.
+// The tree walker go through the AST and call the methods of
 // this listener to do the semantic typecheck of the program. This is
 // done once the SymbolsListener has finish and all the symbols of the
 // program has been added to their respective scope. If an enter/exit
 // method does not have an associated task, it does not have to be
 // redefined.
 
-class TypeCheckListener final : public AslBaseListener {
+class TypeCheckListener final : public AslAstListener {
 
 public:
 
   // Constructor
-  TypeCheckListener(TypesMgr       & Types,
-		    SymTable       & Symbols,
-		    TreeDecoration & Decorations,
-		    SemErrors      & Errors);
+  TypeCheckListener(TypesMgr        & Types,
+		    SymTable        & Symbols,
+		    NodeDecorations & Decorations,
+		    SemErrorLog     & Errors,
+		    const AslAst    & Ast,
+		    const SymbolIndex & Index);
 
-  void enterProgram(AslParser::ProgramContext *ctx);
-  void exitProgram(AslParser::ProgramContext *ctx);
+  void enterProgram(AslAst::NodeId n);
+  void exitProgram(AslAst::NodeId n);
 
-  void enterFunction(AslParser::FunctionContext *ctx);
-  void exitFunction(AslParser::FunctionContext *ctx);
+  void enterFunction(AslAst::NodeId n);
+  void exitFunction(AslAst::NodeId n);
 
-  void enterReturn_func(AslParser::Return_funcContext *ctx); 
-  void exitReturn_func(AslParser::Return_funcContext *ctx);
+  void enterReturn_func(AslAst::NodeId n); 
+  void exitReturn_func(AslAst::NodeId n);
 
-  void enterReturn(AslParser::ReturnContext *ctx);
-  void exitReturn(AslParser::ReturnContext *ctx);
+  void enterReturn(AslAst::NodeId n);
+  void exitReturn(AslAst::NodeId n);
 
-  void enterDeclarations(AslParser::DeclarationsContext *ctx);
-  void exitDeclarations(AslParser::DeclarationsContext *ctx);
+  void enterDeclarations(AslAst::NodeId n);
+  void exitDeclarations(AslAst::NodeId n);
 
-  void enterVariable_decl(AslParser::Variable_declContext *ctx);
-  void exitVariable_decl(AslParser::Variable_declContext *ctx);
+  void enterVariable_decl(AslAst::NodeId n);
+  void exitVariable_decl(AslAst::NodeId n);
 
-  void enterType(AslParser::TypeContext *ctx);
-  void exitType(AslParser::TypeContext *ctx);
+  void enterType(AslAst::NodeId n);
+  void exitType(AslAst::NodeId n);
 
-  void enterStatements(AslParser::StatementsContext *ctx);
-  void exitStatements(AslParser::StatementsContext *ctx);
+  void enterStatements(AslAst::NodeId n);
+  void exitStatements(AslAst::NodeId n);
 
-  void enterAssignStmt(AslParser::AssignStmtContext *ctx);
-  void exitAssignStmt(AslParser::AssignStmtContext *ctx);
+  void enterAssignStmt(AslAst::NodeId n);
+  void exitAssignStmt(AslAst::NodeId n);
 
-  void enterIfStmt(AslParser::IfStmtContext *ctx);
-  void exitIfStmt(AslParser::IfStmtContext *ctx);
+  void enterIfStmt(AslAst::NodeId n);
+  void exitIfStmt(AslAst::NodeId n);
 
-  void enterWhileStmt(AslParser::WhileStmtContext *ctx);
-  void exitWhileStmt(AslParser::WhileStmtContext *ctx);
+  void enterWhileStmt(AslAst::NodeId n);
+  void exitWhileStmt(AslAst::NodeId n);
 
-  void enterProcCall(AslParser::ProcCallContext *ctx);
-  void exitProcCall(AslParser::ProcCallContext *ctx);
+  void enterProcCall(AslAst::NodeId n);
+  void exitProcCall(AslAst::NodeId n);
 
-  void enterReadStmt(AslParser::ReadStmtContext *ctx);
-  void exitReadStmt(AslParser::ReadStmtContext *ctx);
+  void enterReadStmt(AslAst::NodeId n);
+  void exitReadStmt(AslAst::NodeId n);
 
-  void enterWriteExpr(AslParser::WriteExprContext *ctx);
-  void exitWriteExpr(AslParser::WriteExprContext *ctx);
+  void enterWriteExpr(AslAst::NodeId n);
+  void exitWriteExpr(AslAst::NodeId n);
 
-  void enterWriteString(AslParser::WriteStringContext *ctx);
-  void exitWriteString(AslParser::WriteStringContext *ctx);
+  void enterWriteString(AslAst::NodeId n);
+  void exitWriteString(AslAst::NodeId n);
 
-  void enterLeft_expr(AslParser::Left_exprContext *ctx);
-  void exitLeft_expr(AslParser::Left_exprContext *ctx);
+  void enterLeft_expr(AslAst::NodeId n);
+  void exitLeft_expr(AslAst::NodeId n);
 
-  void enterArray_read(AslParser::Array_readContext *ctx);
-  void exitArray_read(AslParser::Array_readContext *ctx);
+  void enterArray_read(AslAst::NodeId n);
+  void exitArray_read(AslAst::NodeId n);
 
-  void enterArithmetic(AslParser::ArithmeticContext *ctx);
-  void exitArithmetic(AslParser::ArithmeticContext *ctx);
+  void enterArithmetic(AslAst::NodeId n);
+  void exitArithmetic(AslAst::NodeId n);
 
-  void enterRelational(AslParser::RelationalContext *ctx);
-  void exitRelational(AslParser::RelationalContext *ctx);
+  void enterRelational(AslAst::NodeId n);
+  void exitRelational(AslAst::NodeId n);
 
-  void enterValue(AslParser::ValueContext *ctx);
-  void exitValue(AslParser::ValueContext *ctx);
+  void enterValue(AslAst::NodeId n);
+  void exitValue(AslAst::NodeId n);
 
-  void enterExprIdent(AslParser::ExprIdentContext *ctx);
-  void exitExprIdent(AslParser::ExprIdentContext *ctx);
+  void enterExprIdent(AslAst::NodeId n);
+  void exitExprIdent(AslAst::NodeId n);
 
-  void enterLogic(AslParser::LogicContext * ctx);
-  void exitLogic(AslParser::LogicContext * ctx);
+  void enterLogic(AslAst::NodeId n);
+  void exitLogic(AslAst::NodeId n);
 
-  void enterPar(AslParser::ParContext *ctx);
-  void exitPar(AslParser::ParContext *ctx);
+  void enterPar(AslAst::NodeId n);
+  void exitPar(AslAst::NodeId n);
 
-  void enterIdent(AslParser::IdentContext *ctx);
-  void exitIdent(AslParser::IdentContext *ctx);
+  void enterIdent(AslAst::NodeId n);
+  void exitIdent(AslAst::NodeId n);
 
-  void enterNotplusminus(AslParser::NotplusminusContext *ctx);
-  void exitNotplusminus(AslParser::NotplusminusContext *ctx);
-
-  // void enterEveryRule(antlr4::ParserRuleContext *ctx);
-  // void exitEveryRule(antlr4::ParserRuleContext *ctx);
-  // void visitTerminal(antlr4::tree::TerminalNode *node);
-  // void visitErrorNode(antlr4::tree::ErrorNode *node);
+  void enterNotplusminus(AslAst::NodeId n);
+  void exitNotplusminus(AslAst::NodeId n);
 
 private:
 
   // Attributes
-  TypesMgr       & Types;
-  SymTable       & Symbols;
-  TreeDecoration & Decorations;
-  SemErrors      & Errors;
+  TypesMgr        & Types;
+  SymTable        & Symbols;
+  NodeDecorations & Decorations;
+  SemErrorLog     & Errors;
+  const AslAst    & Ast;
+  const SymbolIndex & Index;
+
+  // Scope (in Index) and return type of the function being checked
+  SymbolIndex::ScopeId CurrentScope;
+
+  // The basic types, created once: while the functions are checked
+  // the TypesMgr is only read, so they can be checked concurrently
+  const TypesMgr::TypeId IntegerTy;
+  const TypesMgr::TypeId FloatTy;
+  const TypesMgr::TypeId BooleanTy;
+  const TypesMgr::TypeId CharacterTy;
+  const TypesMgr::TypeId VoidTy;
+  const TypesMgr::TypeId ErrorTy;
+
+  TypesMgr::TypeId     CurrentFunctionTy;
 
   // Getters for the necessary tree node atributes:
   //   Scope, Type ans IsLValue
-  SymTable::ScopeId getScopeDecor    (antlr4::ParserRuleContext *ctx);
-  TypesMgr::TypeId  getTypeDecor     (antlr4::ParserRuleContext *ctx);
-  bool              getIsLValueDecor (antlr4::ParserRuleContext *ctx);
+  SymTable::ScopeId getScopeDecor    (AslAst::NodeId n);
+  TypesMgr::TypeId  getTypeDecor     (AslAst::NodeId n);
+  bool              getIsLValueDecor (AslAst::NodeId n);
 
   // Setters for the necessary tree node attributes:
-  //   Scope, Type ans IsLValue
-  void putScopeDecor    (antlr4::ParserRuleContext *ctx, SymTable::ScopeId s);
-  void putTypeDecor     (antlr4::ParserRuleContext *ctx, TypesMgr::TypeId t);
-  void putIsLValueDecor (antlr4::ParserRuleContext *ctx, bool b);
+  //   Scope, Type, IsLValue and Symbol
+  void putScopeDecor    (AslAst::NodeId n, SymTable::ScopeId s);
+  void putTypeDecor     (AslAst::NodeId n, TypesMgr::TypeId t);
+  void putIsLValueDecor (AslAst::NodeId n, bool b);
+  void putSymbolDecor   (AslAst::NodeId n, SymbolHandle s);
 
 };  // class TypeCheckListener
@@ -0,0 +1,224 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ValueNumbering - Removes the computations of a function
+//               whose value is already at hand
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "ValueNumbering.h"
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "DeadCodeEliminator.h"
+
+#include <vector>
+#include <utility>    // std::pair, std::swap
+#include <algorithm>  // std::find
+#include <iterator>   // std::distance
+#include <cstddef>    // std::size_t
+
+
+// Whether the operands of the operation can be swapped
+static bool isCommutative(IrOp op) {
+  switch (op) {
+  case IrOp::ADD:  case IrOp::MUL:  case IrOp::EQ:
+  case IrOp::AND:  case IrOp::OR:
+  case IrOp::FADD: case IrOp::FMUL: case IrOp::FEQ:
+    return true;
+  default:
+    return false;
+  }
+}
+
+std::size_t ValueNumbering::ExprHash::operator()(const Expr & e) const {
+  std::size_t h = static_cast<std::size_t>(e.op);
+  h = h * 31 + e.a.kind;
+  h = h * 1000003 + e.a.id;
+  h = h * 31 + e.b.kind;
+  h = h * 1000003 + e.b.id;
+  return h * 1000003 + e.epoch;
+}
+
+// Constructor
+ValueNumbering::ValueNumbering(IrFunction & Fn, ControlFlowGraph & Cfg, SsaForm & Ssa) :
+  Fn(Fn),
+  Cfg(Cfg),
+  Ssa(Ssa),
+  NumEpochs{0},
+  NumReplaced{0} {
+}
+
+bool ValueNumbering::run() {
+  Replaced.assign(Fn.numTemps() + 1, IrOperand());
+  Table.clear();
+  NumReplaced = 0;
+  if (Cfg.numBlocks() == 0)
+    return false;
+
+  // walk the dominator tree; the expressions added by a block are
+  // removed from the table when leaving it
+  std::vector<uint32_t> endEpoch(Cfg.numBlocks(), 0);
+  std::vector<std::vector<Expr>> added;
+  std::vector<std::pair<BlockId, std::size_t>> stack;   // block, next child
+  stack.push_back(std::make_pair(0, 0));
+  bool entering = true;
+  while (not stack.empty()) {
+    BlockId b = stack.back().first;
+    if (entering) {
+      const std::vector<BlockId> & preds = Cfg.block(b).preds;
+      uint32_t epoch = preds.size() == 1 ? endEpoch[preds[0]] : ++NumEpochs;
+      added.push_back(std::vector<Expr>());
+      visitPhis(b);
+      visitCode(b, epoch, added.back());
+      endEpoch[b] = epoch;
+    }
+    std::size_t & next = stack.back().second;
+    if (next < Cfg.block(b).children.size()) {
+      stack.push_back(std::make_pair(Cfg.block(b).children[next++], 0));
+      entering = true;
+    }
+    else {
+      for (const Expr & e : added.back())
+        Table.erase(e);
+      added.pop_back();
+      stack.pop_back();
+      entering = false;
+    }
+  }
+  return NumReplaced > 0;
+}
+
+std::size_t ValueNumbering::numReplaced() const {
+  return NumReplaced;
+}
+
+IrOperand ValueNumbering::value(IrOperand o) {
+  if (not o.isTemp() or o.id >= Replaced.size() or Replaced[o.id].isNone())
+    return o;
+  IrOperand v = value(Replaced[o.id]);
+  Replaced[o.id] = v;
+  return v;
+}
+
+void ValueNumbering::replace(IrOperand t, IrOperand v) {
+  if (t.id >= Replaced.size())
+    Replaced.resize(t.id + 1, IrOperand());
+  Replaced[t.id] = v;
+  ++NumReplaced;
+}
+
+void ValueNumbering::visitPhis(BlockId b) {
+  std::vector<SsaForm::Phi> & phis = Ssa.phis(b);
+  std::size_t i = 0;
+  while (i < phis.size()) {
+    SsaForm::Phi & phi = phis[i];
+    // the arguments of the back edges are not numbered yet, so the
+    // phis of a loop are only replaced when those are already equal
+    IrOperand same;
+    bool trivial = true;
+    for (IrOperand & a : phi.args) {
+      a = value(a);
+      if (a == phi.dest)
+        continue;
+      if (a.isNone() or (not same.isNone() and a != same))
+        trivial = false;
+      same = a;
+    }
+    std::size_t j = 0;
+    while (j < i and phis[j].args != phi.args)
+      ++j;
+    if (trivial and not same.isNone())
+      replace(phi.dest, same);
+    else if (j < i)
+      replace(phi.dest, phis[j].dest);
+    else {
+      ++i;
+      continue;
+    }
+    phis.erase(phis.begin() + i);
+  }
+}
+
+void ValueNumbering::visitCode(BlockId b, uint32_t & epoch, std::vector<Expr> & added) {
+  const ControlFlowGraph::Block & block = Cfg.block(b);
+  for (IrList::iterator it = block.begin; it != block.end; ++it) {
+    std::size_t pos[3];
+    std::size_t n = it->usePositions(pos);
+    for (std::size_t k = 0; k < n; ++k)
+      it->arg[pos[k]] = value(it->arg[pos[k]]);
+    if (writesMemory(*it)) {
+      epoch = ++NumEpochs;
+      continue;
+    }
+    if (not DeadCodeEliminator::isPure(*it) or not it->arg[0].isTemp())
+      continue;
+    if (it->op == IrOp::LOAD and it->arg[1].isTemp()) {
+      replace(it->arg[0], it->arg[1]);
+      continue;
+    }
+    Expr e;
+    e.op = it->op;
+    e.a = it->arg[1];
+    e.b = it->arg[2];
+    e.epoch = readsMemory(*it) ? epoch : 0;
+    if (isCommutative(e.op) and
+        (e.b.kind < e.a.kind or (e.b.kind == e.a.kind and e.b.id < e.a.id)))
+      std::swap(e.a, e.b);
+    std::unordered_map<Expr, IrOperand, ExprHash>::iterator found = Table.find(e);
+    if (found != Table.end())
+      replace(it->arg[0], found->second);
+    else {
+      Table[e] = it->arg[0];
+      added.push_back(e);
+    }
+  }
+
+  // the values that leave the block through the phis of its successors
+  for (BlockId s : block.succs) {
+    const std::vector<BlockId> & preds = Cfg.block(s).preds;
+    std::size_t k = std::distance(preds.begin(),
+                                  std::find(preds.begin(), preds.end(), b));
+    for (SsaForm::Phi & phi : Ssa.phis(s))
+      phi.args[k] = value(phi.args[k]);
+  }
+}
+
+bool ValueNumbering::readsMemory(const IrInstr & i) const {
+  if (i.op == IrOp::LOADX)
+    return true;
+  IrOperand used[3];
+  std::size_t n = i.uses(used);
+  for (std::size_t k = 0; k < n; ++k)
+    if (used[k].isVar())
+      return true;
+  return false;
+}
+
+bool ValueNumbering::writesMemory(const IrInstr & i) const {
+  return i.op == IrOp::XLOAD or i.op == IrOp::CALL or
+         (i.definesFirst() and i.arg[0].isVar());
+}
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ValueNumbering - Removes the computations of a function
+//               whose value is already at hand
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>    // uint32_t
+#include <cstddef>    // std::size_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class ValueNumbering: an optimization pass over the SSA form of a
+// function (common subexpression elimination). It walks the dominator
+// tree with a scoped table of the expressions computed so far: an
+// instruction without side effects whose expression is in the table
+// of its block, or of a block that dominates it, is not needed, and
+// its uses read the temporary of the first one instead. Copies of a
+// temporary, phis whose arguments are all the same value and phis
+// equal to another one of the block are also replaced.
+//  - Memory: the expressions that read an array or a variable that is
+//    not renamed (a parameter) also depend on the state of memory, an
+//    epoch that changes with every XLOAD, CALL or write to such a
+//    variable. A block with several predecessors starts a new epoch,
+//    a block with one continues the epoch of its predecessor.
+//  - The instructions replaced are left dead, for the
+//    DeadCodeEliminator to remove once the form is lowered.
+
+class ValueNumbering {
+
+public:
+
+  // Constructor
+  ValueNumbering(IrFunction & Fn, ControlFlowGraph & Cfg, SsaForm & Ssa);
+
+  // Run the pass; returns true if the code has changed
+  bool run();
+
+  // Number of instructions and phis replaced
+  std::size_t numReplaced() const;
+
+private:
+
+  typedef ControlFlowGraph::BlockId BlockId;
+
+  struct Expr {
+    IrOp      op;
+    IrOperand a, b;
+    uint32_t  epoch;      // 0 if it does not read memory
+    bool operator==(const Expr & o) const {
+      return op == o.op and a == o.a and b == o.b and epoch == o.epoch;
+    }
+  };
+
+  struct ExprHash {
+    std::size_t operator()(const Expr & e) const;
+  };
+
+  // The value that replaces an operand (itself if none)
+  IrOperand value(IrOperand o);
+  void replace(IrOperand t, IrOperand v);
+  // Number the phis and the instructions of a block
+  void visitPhis(BlockId b);
+  void visitCode(BlockId b, uint32_t & epoch, std::vector<Expr> & added);
+  // Whether the instruction reads memory (an array or a variable that
+  // is not renamed), or changes it
+  bool readsMemory(const IrInstr & i) const;
+  bool writesMemory(const IrInstr & i) const;
+
+  // Attributes
+  IrFunction &                                 Fn;
+  ControlFlowGraph &                           Cfg;
+  SsaForm &                                    Ssa;
+  std::vector<IrOperand>                       Replaced;   // by temporary
+  std::unordered_map<Expr, IrOperand, ExprHash> Table;
+  uint32_t                                     NumEpochs;
+  std::size_t                                  NumReplaced;
+
+};  // class ValueNumbering
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+#
+# bench.py - Compile-throughput benchmark of the asl compiler
+#
+# For every shape of genasl.py and every size, a program is generated
+# and compiled with --time-passes --stats --stats-json; the time of
+# each phase (the best of some runs) and the peak memory of the
+# process are recorded. Then:
+#
+#  - scaling: between two consecutive sizes the growth of the time
+#    of every phase is compared with the growth of the size; an
+#    exponent (log time ratio / log size ratio) over --max-exponent
+#    is reported as superlinear
+#  - regressions: the total time and the peak memory are compared
+#    with those stored in the baseline; more than --tolerance times
+#    the baseline is reported as a regression
+#
+# Exits with 1 if anything has been reported. --update-baseline
+# stores the results as the new baseline instead.
+#
+# Usage: bench.py [--asl <compiler>] [--shapes a,b] [--sizes n,m]
+#                 [--runs r] [--baseline <file>] [--update-baseline]
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import genasl
+
+DEFAULT_SIZES = {
+    "functions": [250, 500, 1000, 2000],
+    "long":      [500, 1000, 2000, 4000],
+    "deep":      [100, 200, 400, 800],
+    "chain":     [12500, 25000, 50000, 100000],
+    "strings":   [250, 500, 1000, 2000],
+    "arrays":    [1000, 10000, 100000, 1000000],
+    "calls":     [250, 500, 1000, 2000],
+}
+
+# below this time (in ms) a phase is noise, not scaling
+MIN_MS = 2.0
+
+
+def compile_once(asl, source):
+    # the rusage of the child gives its peak memory
+    with open(os.devnull, "w") as devnull:
+        proc = subprocess.Popen([asl, "--time-passes", "--stats", "--stats-json", source],
+                                stdout=devnull, stderr=subprocess.PIPE,
+                                universal_newlines=True)
+        errors = proc.stderr.read()
+        _, status, usage = os.wait4(proc.pid, 0)
+        proc.returncode = status   # reaped by wait4
+    # a failed compilation has no valid time: it must not be a sample
+    if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+        raise RuntimeError("%s %s: failed with status %d\n%s"
+                           % (asl, source, status, errors))
+    report = None
+    for line in errors.splitlines():
+        if line.startswith("{"):
+            report = json.loads(line)
+    if report is None:
+        raise RuntimeError("%s %s: no statistics\n%s" % (asl, source, errors))
+    # ru_maxrss is in KB on Linux
+    return report, usage.ru_maxrss
+
+
+def measure(asl, shape, size, runs, workdir):
+    source = os.path.join(workdir, "%s_%d.asl" % (shape, size))
+    with open(source, "w") as f:
+        f.write(genasl.generate(shape, size))
+    passes = {}
+    peak_kb = 0
+    counts = {}
+    for _ in range(runs):
+        report, rss = compile_once(asl, source)
+        peak_kb = max(peak_kb, rss)
+        counts = report.get("counts", {})
+        for p in report["passes"]:
+            ms = p["wall_ms"]
+            passes[p["name"]] = min(ms, passes.get(p["name"], ms))
+    return {"size": size,
+            "passes": passes,
+            "total_ms": sum(passes.values()),
+            "peak_kb": peak_kb,
+            "tokens": counts.get("tokens", 0),
+            "nodes": counts.get("nodes", 0)}
+
+
+def check_scaling(shape, results, max_exponent):
+    problems = []
+    for a, b in zip(results, results[1:]):
+        growth = math.log(float(b["size"]) / a["size"])
+        for name, ms in sorted(b["passes"].items()):
+            before = a["passes"].get(name, 0.0)
+            if ms < MIN_MS or before <= 0.0:
+                continue
+            exponent = math.log(ms / before) / growth
+            if exponent > max_exponent:
+                problems.append("%s: %s grows as n^%.2f from size %d to %d "
+                                "(%.2f ms -> %.2f ms)"
+                                % (shape, name, exponent, a["size"], b["size"],
+                                   before, ms))
+    return problems
+
+
+def check_baseline(shape, results, baseline, tolerance):
+    problems = []
+    stored = dict((r["size"], r) for r in baseline.get(shape, []))
+    for r in results:
+        base = stored.get(r["size"])
+        if base is None:
+            continue
+        if r["total_ms"] > MIN_MS and r["total_ms"] > tolerance * base["total_ms"]:
+            problems.append("%s %d: time %.2f ms, baseline %.2f ms"
+                            % (shape, r["size"], r["total_ms"], base["total_ms"]))
+        if r["peak_kb"] > tolerance * base["peak_kb"]:
+            problems.append("%s %d: peak memory %d KB, baseline %d KB"
+                            % (shape, r["size"], r["peak_kb"], base["peak_kb"]))
+    return problems
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Compile-throughput benchmark")
+    parser.add_argument("--asl", default=os.path.join(here, "..", "asl"))
+    parser.add_argument("--shapes", default=",".join(sorted(DEFAULT_SIZES)))
+    parser.add_argument("--sizes", default="",
+                        help="sizes for all the shapes (default: per shape)")
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--baseline", default=os.path.join(here, "baseline.json"))
+    parser.add_argument("--update-baseline", action="store_true")
+    parser.add_argument("--tolerance", type=float, default=1.25)
+    parser.add_argument("--max-exponent", type=float, default=1.3)
+    args = parser.parse_args()
+
+    results = {}
+    problems = []
+    workdir = tempfile.mkdtemp(prefix="aslbench.")
+    try:
+        for shape in args.shapes.split(","):
+            if args.sizes:
+                sizes = [int(s) for s in args.sizes.split(",")]
+            else:
+                sizes = DEFAULT_SIZES[shape]
+            results[shape] = []
+            for size in sizes:
+                r = measure(args.asl, shape, size, args.runs, workdir)
+                results[shape].append(r)
+                print("%-10s %8d  %9.2f ms  %8d KB  %s"
+                      % (shape, size, r["total_ms"], r["peak_kb"],
+                         " ".join("%s=%.2f" % (n, ms)
+                                  for n, ms in sorted(r["passes"].items()))))
+            problems += check_scaling(shape, results[shape], args.max_exponent)
+    finally:
+        for name in os.listdir(workdir):
+            os.remove(os.path.join(workdir, name))
+        os.rmdir(workdir)
+
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+            f.write("\n")
+        print("baseline written to %s" % args.baseline)
+    elif os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        for shape in results:
+            problems += check_baseline(shape, results[shape], baseline, args.tolerance)
+    else:
+        print("no baseline (%s): make bench-baseline to store one" % args.baseline)
+
+    for p in problems:
+        print("WARNING: " + p)
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
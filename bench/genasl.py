@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+#
+# genasl.py - Generator of synthetic Asl programs for the benchmarks
+#
+# Every shape stresses one dimension of the compiler and grows
+# linearly with the size given:
+#
+#   functions    N small functions, all called from main
+#   long         one function of N statements
+#   deep         an expression nested N levels deep
+#   chain        an expression of N operands, a + b - c + ...
+#   strings      N writes of long strings
+#   arrays       arrays of N elements, filled, copied and summed
+#   calls        N functions, each one calling the previous ones
+#
+# The programs are correct (they type check), so the code generation
+# is measured too.
+#
+# Usage: genasl.py <shape> <size> [<output file>]
+
+import sys
+
+
+def functions(n):
+    out = []
+    for i in range(n):
+        out.append("func f%d(a : int, b : int) : int\n"
+                   "  var c : int\n"
+                   "  c = a * %d + b;\n"
+                   "  if c > 100 then\n"
+                   "    c = c - 100;\n"
+                   "  endif\n"
+                   "  return c;\n"
+                   "endfunc\n\n" % (i, i % 7 + 1))
+    out.append("func main()\n  var s : int\n  s = 0;\n")
+    for i in range(n):
+        out.append("  s = f%d(s, %d);\n" % (i, i))
+    out.append("  write s;\n  write \"\\n\";\nendfunc\n")
+    return "".join(out)
+
+
+def long_function(n):
+    out = ["func main()\n  var i, j, k : int\n  var x : float\n"
+           "  var b : bool\n  i = 1;\n  j = 2;\n  k = 3;\n  x = 0.5;\n"]
+    for s in range(n):
+        kind = s % 5
+        if kind == 0:
+            out.append("  i = (j + k * %d) %% 97;\n" % s)
+        elif kind == 1:
+            out.append("  x = x * 0.5 + i;\n")
+        elif kind == 2:
+            out.append("  b = i < j or k == %d;\n" % s)
+        elif kind == 3:
+            out.append("  if b then\n    j = j + 1;\n  else\n    k = k - 1;\n  endif\n")
+        else:
+            out.append("  while k > 10 do\n    k = k / 2;\n  endwhile\n")
+    out.append("  write i + j + k;\n  write \"\\n\";\nendfunc\n")
+    return "".join(out)
+
+
+def deep(n):
+    expr = "x"
+    for d in range(n):
+        op = "+-*"[d % 3]
+        expr = "(%s %s %d)" % (expr, op, d % 9 + 1)
+    return ("func main()\n  var x, y : int\n  x = 1;\n"
+            "  y = %s;\n  write y;\n  write \"\\n\";\nendfunc\n" % expr)
+
+
+def chain(n):
+    terms = ["x"]
+    for d in range(1, n):
+        terms.append("-+"[d % 2])
+        terms.append("x" if d % 3 == 0 else str(d % 9 + 1))
+    return ("func main()\n  var x, y : int\n  x = 1;\n"
+            "  y = %s;\n  write y;\n  write \"\\n\";\nendfunc\n" % " ".join(terms))
+
+
+def strings(n):
+    text = "The quick brown fox jumps over the lazy dog. " * 4
+    out = ["func main()\n"]
+    for s in range(n):
+        out.append("  write \"%d: %s\\n\";\n" % (s, text))
+    out.append("endfunc\n")
+    return "".join(out)
+
+
+def arrays(n):
+    return ("func sum(v : array [%d] of int) : int\n"
+            "  var i, s : int\n"
+            "  i = 0;\n  s = 0;\n"
+            "  while i < %d do\n    s = s + v[i];\n    i = i + 1;\n  endwhile\n"
+            "  return s;\nendfunc\n\n"
+            "func main()\n"
+            "  var a, b : array [%d] of int\n"
+            "  var i : int\n"
+            "  i = 0;\n"
+            "  while i < %d do\n    a[i] = i %% 10;\n    i = i + 1;\n  endwhile\n"
+            "  b = a;\n"
+            "  write sum(b);\n  write \"\\n\";\nendfunc\n" % (n, n, n, n))
+
+
+def calls(n):
+    out = ["func g0(a : int) : int\n  return a + 1;\nendfunc\n\n"]
+    for i in range(1, n):
+        callees = sorted(set([i - 1, i // 2, i // 3]))
+        body = " + ".join("g%d(a %% 7)" % c for c in callees)
+        out.append("func g%d(a : int) : int\n  return %s;\nendfunc\n\n" % (i, body))
+    out.append("func main()\n  write g%d(3);\n  write \"\\n\";\nendfunc\n" % (n - 1))
+    return "".join(out)
+
+
+SHAPES = {
+    "functions": functions,
+    "long":      long_function,
+    "deep":      deep,
+    "chain":     chain,
+    "strings":   strings,
+    "arrays":    arrays,
+    "calls":     calls,
+}
+
+
+def generate(shape, size):
+    return SHAPES[shape](max(1, size))
+
+
+def main(argv):
+    if len(argv) not in (3, 4) or argv[1] not in SHAPES:
+        sys.stderr.write("Usage: genasl.py <shape> <size> [<output file>]\n"
+                         "Shapes: %s\n" % " ".join(sorted(SHAPES)))
+        return 1
+    program = generate(argv[1], int(argv[2]))
+    if len(argv) == 4:
+        with open(argv[3], "w") as f:
+            f.write(program)
+    else:
+        sys.stdout.write(program)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -60,3 +60,46 @@ echo "END   examples-initial/execution"
      rm -f tmp.t tmp.out
  done
  echo "END   examples-full/execution"
+
+# the same executions with the passes over the SSA form, which are
+# checked after each one (an internal error aborts asl)
+echo ""
+echo "BEGIN examples/execution -O2"
+for f in ../examples/jpbasic_genc_*.asl ../examples/jp_genc_*.asl; do
+    echo $(basename "$f")
+    ./asl -O2 --verify-ir "$f" > tmp.t
+    ../tvm/tvm tmp.t < "${f/asl/in}" > tmp.out
+    diff tmp.out "${f/asl/out}"
+    rm -f tmp.t tmp.out
+done
+echo "END   examples/execution -O2"
+
+echo ""
+echo "BEGIN examples/batch"
+# all the examples compiled at once, in a single asl process, must give
+# the same output as each one compiled alone: tmp.out/<name>.t has the
+# code of <name>.asl, or tmp.out/<name>.err its errors. asl exits with
+# 1 if some file has errors, as the typecheck ones; more is a crash
+rm -rf tmp.out; mkdir tmp.out
+./asl -o tmp.out ../examples/jpbasic_*.asl ../examples/jp_*.asl 2> tmp.log
+status=$?
+if [ $status -gt 1 ]; then
+    echo "asl -o exited with status $status"
+    cat tmp.log
+fi
+for f in ../examples/jpbasic_*.asl ../examples/jp_*.asl; do
+    name=$(basename "${f%.asl}")
+    if [ -f tmp.out/$name.t ]; then
+        batch=tmp.out/$name.t
+    elif [ -f tmp.out/$name.err ]; then
+        batch=tmp.out/$name.err
+    else
+        echo "$name: no output of asl -o"
+        continue
+    fi
+    ./asl "$f" > tmp.one
+    diff -q tmp.one $batch > /dev/null || echo "$name: asl -o differs from asl"
+    rm -f tmp.one
+done
+rm -rf tmp.out tmp.log
+echo "END   examples/batch"
@@ -31,108 +31,158 @@
 
 
 #include "antlr4-runtime.h"
-#include "AslLexer.h"
-#include "AslParser.h"
-#include "tree/ParseTreeWalker.h"
-
-#include "../common/TypesMgr.h"
-#include "../common/SymTable.h"
-#include "../common/TreeDecoration.h"
-#include "../common/SemErrors.h"
-#include "SymbolsListener.h"
-#include "TypeCheckListener.h"
-#include "../common/code.h"
-#include "CodeGenListener.h"
+
+#include "Compiler.h"
+#include "CompileServer.h"
+#include "MappedCharStream.h"
 
 #include <iostream>
 #include <fstream>    // ifstream
+#include <sstream>    // ostringstream
+#include <string>
+#include <vector>
 
-#include <cstdio>     // fopen
-#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS, atoi
 
 // using namespace std;
 // using namespace antlr4;
 
 
+static void usage() {
+  std::cout << "Usage: ./main [<options>] [<file>]" << std::endl;
+  std::cout << "       ./main [<options>] [-j <jobs>] -o <dir> <file>... | @<list>" << std::endl;
+  std::cout << "       ./main [<options>] [-j <jobs>] --server <socket>" << std::endl;
+  std::cout << "       ./main --client <socket> [<file>]" << std::endl;
+  std::cout << "Options: --stats                report the sizes of the program" << std::endl;
+  std::cout << "         --time-passes          report the time and allocations of every phase" << std::endl;
+  std::cout << "         --stats-json           write these reports as one line of JSON" << std::endl;
+  std::cout << "         --function-jobs <n>    check and generate the functions of a file with n threads" << std::endl;
+  std::cout << "         -O0                    do not optimize the generated code" << std::endl;
+  std::cout << "         -O2                    also optimize over the SSA form of each function" << std::endl;
+  std::cout << "         --verify-ir            check the SSA form after each pass that uses it" << std::endl;
+  std::cout << "         --short-circuit        'and'/'or' do not evaluate their right operand when" << std::endl;
+  std::cout << "                                the left one decides the result, even if it calls functions" << std::endl;
+}
+
 int main(int argc, const char* argv[]) {
   // check the correct use of the program
-  if (argc > 2) {
-    std::cout << "Usage: ./main [<file>]" << std::endl;
-    return EXIT_FAILURE;
-  }
-  if (argc == 2 and not std::fopen(argv[1], "r")) {
-    std::cout << "No such file: " << argv[1] << std::endl;
-    return EXIT_FAILURE;
+  Compiler::Options        options;
+  std::string              outDir;      // batch mode: where the outputs go
+  std::string              serverSocket;   // server mode: socket to listen on
+  std::string              clientSocket;   // client mode: socket of the server
+  unsigned int             jobs = 0;    // batch mode: number of workers
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--stats")
+      options.stats = true;
+    else if (arg == "--time-passes")
+      options.timePasses = true;
+    else if (arg == "--stats-json")
+      options.statsJson = true;
+    else if (arg == "-O0")
+      options.optimize = 0;
+    else if (arg == "-O1")
+      options.optimize = 1;
+    else if (arg == "-O2")
+      options.optimize = 2;
+    else if (arg == "--verify-ir")
+      options.verifyIr = true;
+    else if (arg == "--short-circuit")
+      options.shortCircuit = true;
+    else if (arg == "--function-jobs" and i+1 < argc)
+      options.functionJobs = std::atoi(argv[++i]);
+    else if (arg == "-o" and i+1 < argc)
+      outDir = argv[++i];
+    else if (arg == "-j" and i+1 < argc)
+      jobs = std::atoi(argv[++i]);
+    else if (arg == "--server" and i+1 < argc)
+      serverSocket = argv[++i];
+    else if (arg == "--client" and i+1 < argc)
+      clientSocket = argv[++i];
+    else if (arg[0] == '@') {   // a file with the list of inputs
+      std::ifstream list(arg.substr(1));
+      if (not list) {
+        std::cout << "No such file: " << arg.substr(1) << std::endl;
+        return EXIT_FAILURE;
+      }
+      for (std::string name; list >> name; )
+        files.push_back(name);
+    }
+    else if (arg[0] != '-')
+      files.push_back(arg);
+    else {
+      usage();
+      return EXIT_FAILURE;
+    }
   }
 
-  // open input file (or std::cin) and create a character stream
-  antlr4::ANTLRInputStream input;
-  if (argc == 2) {  // reads from <file>
-    std::ifstream stream;
-    stream.open(argv[1]);
-    input = antlr4::ANTLRInputStream(stream);
-  }
-  else {            // reads fron std::cin
-    input = antlr4::ANTLRInputStream(std::cin);
+  // server mode: compile the sources sent by the clients
+  if (not serverSocket.empty()) {
+    if (not files.empty() or not outDir.empty()) {
+      usage();
+      return EXIT_FAILURE;
+    }
+    CompileServer server(options, jobs);
+    return server.run(serverSocket, std::cerr) ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
-  // create a lexer that consumes the character stream and produce a token stream
-  AslLexer lexer(&input);
-  antlr4::CommonTokenStream tokens(&lexer);
-
-  // create a parser that consumes the token stream, and parses it.
-  AslParser parser(&tokens);
+  // client mode: send the source to the server and print its answer
+  if (not clientSocket.empty()) {
+    if (files.size() > 1 or not outDir.empty()) {
+      usage();
+      return EXIT_FAILURE;
+    }
+    std::ostringstream source;
+    if (not files.empty()) {
+      std::ifstream stream(files[0]);
+      if (not stream) {
+        std::cout << "No such file: " << files[0] << std::endl;
+        return EXIT_FAILURE;
+      }
+      source << stream.rdbuf();
+    }
+    else
+      source << std::cin.rdbuf();
+    return CompileServer::request(clientSocket, source.str(), std::cout, std::cerr);
+  }
 
-  // call the parser and get the parse tree
-  antlr4::tree::ParseTree *tree = parser.program();
+  Compiler compiler(options);
 
-  // check for lexical or syntactical errors
-  if (lexer.getNumberOfSyntaxErrors() > 0 or
-      parser.getNumberOfSyntaxErrors() > 0) {
-    std::cout << "Lexical and/or syntactical errors have been found." << std::endl;
-    return EXIT_FAILURE;
+  // batch mode: compile all the inputs in this process
+  if (not outDir.empty()) {
+    if (files.empty()) {
+      usage();
+      return EXIT_FAILURE;
+    }
+    bool ok = compiler.compileFiles(files, outDir, jobs, std::cerr);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
   }
-
-  // print the parse tree (for debugging purposes)
-  // std::cout << tree->toStringTree(&parser) << std::endl;
-
-  // create a walker that will traverse the tree and do several things,
-  // like checking variable types or generating code.
-  antlr4::tree::ParseTreeWalker walker;
-
-  // Auxililary classes we are going to need to store information while
-  // traversing the tree. They are described below in this document
-  TypesMgr       types;
-  SymTable       symbols(types);
-  TreeDecoration decorations;
-  SemErrors      errors;
-
-  // Create a Listener that looks for variables and function declarations in the tree
-  // and stores required information
-  SymbolsListener symboldecl(types, symbols, decorations, errors);
-  // Traverse the tree using this listener, to collect information about declared identifiers
-  walker.walk(&symboldecl, tree);
-
-  // Create another Listener that will perform type checkings wherever it is needed
-  // (on expressions, assignments, parameter passing, etc)
-  TypeCheckListener typecheck(types, symbols, decorations, errors);
-  // Traverse the tree using this listener, so all types are checked
-  walker.walk(&typecheck, tree);
-
-  if (errors.getNumberOfSemanticErrors() > 0) {
-    std::cout << "There are semantic errors: no code generated." << std::endl;
+  if (files.size() > 1) {
+    usage();
     return EXIT_FAILURE;
   }
 
-  // Auxiliary class to store the code we will be creating
-  code mycode;
-  // Create a third listener that will generate code for each part of the tree
-  CodeGenListener codegenerator(types, symbols, decorations, mycode);
-  // Traverse the tree using this listener, so code is generated and stored in 'mycode'
-  walker.walk(&codegenerator, tree);
+  // open input file (or std::cin) and create a character stream.
+  // The file is mapped in memory and std::cin is read into a single
+  // buffer: the lexer reads the bytes of the source from there.
+  MappedCharStream input;
+  if (not files.empty()) {   // reads from <file>
+    if (not input.openFile(files[0])) {
+      std::cout << "No such file: " << files[0] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  else {                     // reads fron std::cin
+    if (not input.readStream(std::cin)) {
+      std::cout << "Error reading <stdin>" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
 
-  // print generated code as output
-  std::cout << mycode.dump() << std::endl;
+  // translate the program and write the generated code on std::cout
+  if (not compiler.compile(input, std::cout, std::cerr))
+    return EXIT_FAILURE;
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,135 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ConstantFolderTest - The folding of constants on small
+//                         functions of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "ConstantFolder.h"
+#include "DeadCodeEliminator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// The number of instructions of the code with operation 'op'
+static std::size_t count(const IrFunction & fn, IrOp op) {
+  std::size_t n = 0;
+  for (const IrInstr & instr : fn.instructions())
+    n += instr.op == op;
+  return n;
+}
+
+// Negative results are folded, and loaded as the negation of their
+// absolute value: 3-5, (3-5)*7 and -(-14/-2) are all known.
+//
+//     ILOAD t0 3; ILOAD t1 5; SUB t2 t0 t1; WRITEI t2
+//     ILOAD t3 7; MUL t4 t2 t3; WRITEI t4
+//     DIV t5 t4 t2; NEG t6 t5; WRITEI t6; RETURN
+static bool testNegative() {
+  IrFunction fn("negative");
+  IrList & code = fn.instructions();
+  IrOperand t[7];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  code.push_back(IrInstr::ILOAD(t[0], fn.constant("3")));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("5")));
+  code.push_back(IrInstr::SUB(t[2], t[0], t[1]));
+  code.push_back(IrInstr::WRITEI(t[2]));
+  code.push_back(IrInstr::ILOAD(t[3], fn.constant("7")));
+  code.push_back(IrInstr::MUL(t[4], t[2], t[3]));
+  code.push_back(IrInstr::WRITEI(t[4]));
+  code.push_back(IrInstr::DIV(t[5], t[4], t[2]));
+  code.push_back(IrInstr::NEG(t[6], t[5]));
+  code.push_back(IrInstr::WRITEI(t[6]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  ConstantFolder(fn).run();
+  DeadCodeEliminator(fn).run();
+  if (count(fn, IrOp::SUB) + count(fn, IrOp::MUL) + count(fn, IrOp::DIV) > 0)
+    return fail("negative", "an operation is left", fn);
+  std::string error;
+  if (not sameOutput(before, fn, {}, error))
+    return fail("negative", error, fn);
+  return true;
+}
+
+// A result that is not an int32, or whose negation is not (INT_MIN),
+// is not folded: the operation stays and wraps at run time.
+//
+//     ILOAD t0 2147483647; ILOAD t1 1; ADD t2 t0 t1; WRITEI t2
+//     ILOAD t3 65536; MUL t4 t3 t3; WRITEI t4
+//     NEG t5 t0; SUB t6 t5 t1; WRITEI t6; RETURN
+static bool testOverflow() {
+  IrFunction fn("overflow");
+  IrList & code = fn.instructions();
+  IrOperand t[7];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  code.push_back(IrInstr::ILOAD(t[0], fn.constant("2147483647")));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("1")));
+  code.push_back(IrInstr::ADD(t[2], t[0], t[1]));
+  code.push_back(IrInstr::WRITEI(t[2]));
+  code.push_back(IrInstr::ILOAD(t[3], fn.constant("65536")));
+  code.push_back(IrInstr::MUL(t[4], t[3], t[3]));
+  code.push_back(IrInstr::WRITEI(t[4]));
+  code.push_back(IrInstr::NEG(t[5], t[0]));
+  code.push_back(IrInstr::SUB(t[6], t[5], t[1]));
+  code.push_back(IrInstr::WRITEI(t[6]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  ConstantFolder(fn).run();
+  DeadCodeEliminator(fn).run();
+  if (count(fn, IrOp::ADD) != 1 or count(fn, IrOp::MUL) != 1 or count(fn, IrOp::SUB) != 1)
+    return fail("overflow", "a result out of range is folded", fn);
+  std::string error;
+  if (not sameOutput(before, fn, {}, error))
+    return fail("overflow", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testNegative();
+  ok = testOverflow() and ok;
+  std::cout << (ok ? "ConstantFolderTest: ok" : "ConstantFolderTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,293 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    IrInterpreter - Runs the code of a function, to compare its
+//                    output before and after the passes
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "IrCode.h"
+
+#include <vector>
+#include <string>
+#include <sstream>    // ostringstream
+#include <cstdint>    // int32_t, uint32_t
+
+
+//////////////////////////////////////////////////////////////////////
+// Class IrInterpreter: a helper of the tests that runs the code of an
+// IrFunction as the tvm runs the t-code, and keeps what it writes. It
+// only runs a function alone: the parameters start as 0, and CALL,
+// PUSH and POP are errors. The integers are of 32 bits and wrap; a
+// division by zero, an index out of range or a run of more than
+// MaxSteps instructions are errors.
+
+class IrInterpreter {
+
+public:
+
+  static const std::size_t MaxSteps = 10000000;
+
+  // Constructor
+  IrInterpreter(const IrFunction & Fn) : Fn(Fn) {}
+
+  // Run the function: READI, READF and READC take the values of
+  // 'input' in order. Returns false, with the reason in 'error', if
+  // the run fails; 'output' has what it wrote until then
+  bool run(const std::vector<double> & input, std::string & output,
+           std::string & error);
+
+private:
+
+  // A value: an integer (also a bool or a char), a float, or the
+  // address of the array of a variable (its slot + 1)
+  struct Value {
+    int32_t  i;
+    float    f;
+    uint32_t array;
+    Value() : i(0), f(0), array(0) {}
+  };
+
+  Value & value(IrOperand o);
+  int32_t intOf(IrOperand o);
+  float   floatOf(IrOperand o);
+  void    setInt(IrOperand o, int64_t x);
+  void    setFloat(IrOperand o, double x);
+  // The elements of the array of 'a' (a local array or an address),
+  // or nullptr if it is not one
+  std::vector<Value> * arrayOf(IrOperand a);
+
+  // Attributes
+  const IrFunction &              Fn;
+  std::vector<std::vector<Value>> Vars;
+  std::vector<Value>              Temps;
+  Value                           Literal;
+
+};  // class IrInterpreter
+
+
+// Run 'before' and 'after' on 'input': true if both runs finish and
+// write the same. Otherwise 'error' tells what is different
+inline bool sameOutput(const IrFunction & before, const IrFunction & after,
+                       const std::vector<double> & input, std::string & error) {
+  std::string out1, out2, error1, error2;
+  bool ok1 = IrInterpreter(before).run(input, out1, error1);
+  bool ok2 = IrInterpreter(after).run(input, out2, error2);
+  if (not ok1)
+    error = "the code before the pass fails: " + error1;
+  else if (not ok2)
+    error = "the code after the pass fails: " + error2;
+  else if (out1 != out2)
+    error = "the output was \"" + out1 + "\" and is \"" + out2 + "\"";
+  return ok1 and ok2 and out1 == out2;
+}
+
+
+inline IrInterpreter::Value & IrInterpreter::value(IrOperand o) {
+  if (o.isTemp())
+    return Temps[o.id];
+  if (o.isVar())
+    return Vars[o.id][0];
+  // an immediate or a literal is read into a scratch value
+  Literal = Value();
+  if (o.isImm())
+    Literal.i = o.immValue();
+  else
+    Literal.i = std::stoi(Fn.operandText(o));
+  return Literal;
+}
+
+inline int32_t IrInterpreter::intOf(IrOperand o) {
+  return value(o).i;
+}
+
+inline float IrInterpreter::floatOf(IrOperand o) {
+  return value(o).f;
+}
+
+inline void IrInterpreter::setInt(IrOperand o, int64_t x) {
+  Value v;
+  v.i = static_cast<int32_t>(static_cast<uint32_t>(x));
+  value(o) = v;
+}
+
+inline void IrInterpreter::setFloat(IrOperand o, double x) {
+  Value v;
+  v.f = static_cast<float>(x);
+  value(o) = v;
+}
+
+inline std::vector<IrInterpreter::Value> * IrInterpreter::arrayOf(IrOperand a) {
+  if (a.isVar() and not Fn.isParam(a))
+    return &Vars[a.id];
+  uint32_t array = value(a).array;
+  return array > 0 ? &Vars[array - 1] : nullptr;
+}
+
+inline bool IrInterpreter::run(const std::vector<double> & input,
+                               std::string & output, std::string & error) {
+  Vars.assign(Fn.numVars(), std::vector<Value>());
+  for (uint32_t v = 0; v < Vars.size(); ++v)
+    Vars[v].resize(Fn.varSize(IrOperand(IrOperand::VAR, v)));
+  Temps.assign(Fn.numTemps() + 1, Value());
+  // the instructions, and the position of each label among them
+  std::vector<const IrInstr *> code;
+  std::vector<std::size_t> labels;
+  for (const IrInstr & instr : Fn.instructions()) {
+    if (instr.op == IrOp::LABEL) {
+      if (labels.size() <= instr.arg[0].id)
+        labels.resize(instr.arg[0].id + 1, std::size_t(-1));
+      labels[instr.arg[0].id] = code.size();
+    }
+    code.push_back(&instr);
+  }
+  std::ostringstream out;
+  std::size_t next = 0, pc = 0, steps = 0;
+  error.clear();
+  while (pc < code.size() and error.empty()) {
+    if (++steps > MaxSteps) {
+      error = "too many steps";
+      break;
+    }
+    const IrInstr & instr = *code[pc++];
+    IrOperand a = instr.arg[0], b = instr.arg[1], c = instr.arg[2];
+    switch (instr.op) {
+    case IrOp::LABEL:
+      break;
+    case IrOp::UJUMP:
+    case IrOp::FJUMP: {
+      IrOperand l = instr.op == IrOp::UJUMP ? a : b;
+      if (instr.op == IrOp::FJUMP and intOf(a) != 0)
+        break;
+      if (l.id >= labels.size() or labels[l.id] == std::size_t(-1))
+        error = "jump to a missing label: " + Fn.instrText(instr);
+      else
+        pc = labels[l.id];
+      break;
+    }
+    case IrOp::LOAD: {
+      Value v = value(b);
+      value(a) = v;
+      break;
+    }
+    case IrOp::ILOAD:
+      setInt(a, intOf(b));
+      break;
+    case IrOp::FLOAD:
+      setFloat(a, std::stod(Fn.operandText(b)));
+      break;
+    case IrOp::CHLOAD: {
+      std::string text = Fn.operandText(b);
+      char ch = text[0];
+      if (text.size() == 2 and text[0] == '\\')
+        ch = text[1] == 'n' ? '\n' : text[1] == 't' ? '\t' : text[1];
+      setInt(a, ch);
+      break;
+    }
+    case IrOp::ALOAD: {
+      Value v;
+      if (b.isVar() and not Fn.isParam(b))
+        v.array = b.id + 1;
+      else
+        v = value(b);
+      value(a) = v;
+      break;
+    }
+    case IrOp::LOADX:
+    case IrOp::XLOAD: {
+      std::vector<Value> * array = arrayOf(instr.op == IrOp::LOADX ? b : a);
+      int32_t k = intOf(instr.op == IrOp::LOADX ? c : b);
+      if (array == nullptr)
+        error = "not an array: " + Fn.instrText(instr);
+      else if (k < 0 or std::size_t(k) >= array->size())
+        error = "index " + std::to_string(k) + " out of range: " + Fn.instrText(instr);
+      else if (instr.op == IrOp::LOADX)
+        value(a) = (*array)[k];
+      else
+        (*array)[k] = value(c);
+      break;
+    }
+    case IrOp::READI:
+    case IrOp::READF:
+    case IrOp::READC:
+      if (next == input.size())
+        error = "no more input";
+      else if (instr.op == IrOp::READF)
+        setFloat(a, input[next++]);
+      else
+        setInt(a, static_cast<int64_t>(input[next++]));
+      break;
+    case IrOp::WRITEI:
+      out << intOf(a);
+      break;
+    case IrOp::WRITEF:
+      out << floatOf(a);
+      break;
+    case IrOp::WRITEC:
+      out << static_cast<char>(intOf(a));
+      break;
+    case IrOp::WRITELN:
+      out << std::endl;
+      break;
+    case IrOp::ADD:  setInt(a, int64_t(intOf(b)) + intOf(c));  break;
+    case IrOp::SUB:  setInt(a, int64_t(intOf(b)) - intOf(c));  break;
+    case IrOp::MUL:  setInt(a, int64_t(intOf(b)) * intOf(c));  break;
+    case IrOp::DIV:
+      if (intOf(c) == 0)
+        error = "division by zero: " + Fn.instrText(instr);
+      else
+        setInt(a, int64_t(intOf(b)) / intOf(c));
+      break;
+    case IrOp::NEG:  setInt(a, -int64_t(intOf(b)));            break;
+    case IrOp::EQ:   setInt(a, intOf(b) == intOf(c));          break;
+    case IrOp::LT:   setInt(a, intOf(b) <  intOf(c));          break;
+    case IrOp::LE:   setInt(a, intOf(b) <= intOf(c));          break;
+    case IrOp::AND:  setInt(a, intOf(b) != 0 and intOf(c) != 0); break;
+    case IrOp::OR:   setInt(a, intOf(b) != 0 or intOf(c) != 0);  break;
+    case IrOp::NOT:  setInt(a, intOf(b) == 0);                 break;
+    case IrOp::FADD: setFloat(a, floatOf(b) + floatOf(c));     break;
+    case IrOp::FSUB: setFloat(a, floatOf(b) - floatOf(c));     break;
+    case IrOp::FMUL: setFloat(a, floatOf(b) * floatOf(c));     break;
+    case IrOp::FDIV: setFloat(a, floatOf(b) / floatOf(c));     break;
+    case IrOp::FNEG: setFloat(a, -floatOf(b));                 break;
+    case IrOp::FEQ:  setInt(a, floatOf(b) == floatOf(c));      break;
+    case IrOp::FLT:  setInt(a, floatOf(b) <  floatOf(c));      break;
+    case IrOp::FLE:  setInt(a, floatOf(b) <= floatOf(c));      break;
+    case IrOp::FLOAT: setFloat(a, intOf(b));                   break;
+    case IrOp::PUSH:
+    case IrOp::POP:
+    case IrOp::CALL:
+      error = "calls are not run: " + Fn.instrText(instr);
+      break;
+    case IrOp::RETURN:
+      pc = code.size();
+      break;
+    }
+  }
+  output = out.str();
+  return error.empty();
+}
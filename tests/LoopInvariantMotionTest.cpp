@@ -0,0 +1,191 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    LoopInvariantMotionTest - The loop invariant code motion
+//                         on small functions of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "LoopInvariantMotion.h"
+#include "DeadCodeEliminator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// Build the SSA form of 'fn', hoist the invariants of its loops, lower
+// it and remove what is left dead. Returns the number of instructions
+// hoisted, or -1 if the form can not be built or is wrong after the
+// pass
+static long hoist(IrFunction & fn, std::string & error) {
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  if (not ssa.build(1000)) {
+    error = "over the budget";
+    return -1;
+  }
+  LoopInvariantMotion licm(fn, cfg, ssa);
+  licm.run();
+  if (not ssa.verify(error))
+    return -1;
+  ssa.lower();
+  DeadCodeEliminator(fn).run();
+  long hoisted = 0;
+  for (std::size_t n : licm.hoisted())
+    hoisted += n;
+  return hoisted;
+}
+
+// The product n*k and the sum that reads it do not change in the loop:
+// they leave it. The division by d is under a condition and may fail,
+// so it stays, even if it is invariant: with d = 0 the loop does not
+// divide, and the code after the pass must not either.
+//
+//     READI n; READI k; READI d; LOAD i 0
+//   while:
+//     LT t0 i n; FJUMP t0 endwhile
+//     MUL t1 n k; ILOAD t2 1; ADD t3 t1 t2   (invariant)
+//     ADD t4 t3 i; WRITEI t4
+//     ILOAD t5 0; EQ t6 d t5; NOT t7 t6; FJUMP t7 endif
+//     DIV t8 n d; WRITEI t8                  (invariant, may fail)
+//   endif:
+//     ADD i i t2; UJUMP while
+//   endwhile:
+//     RETURN
+static bool testHoist() {
+  IrFunction fn("hoist");
+  IrList & code = fn.instructions();
+  IrOperand n = fn.addVar("n", 1), k = fn.addVar("k", 1);
+  IrOperand d = fn.addVar("d", 1), i = fn.addVar("i", 1);
+  IrOperand t[9];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  IrOperand endIf = fn.newLabel("endif");
+  code.push_back(IrInstr::READI(n));
+  code.push_back(IrInstr::READI(k));
+  code.push_back(IrInstr::READI(d));
+  code.push_back(IrInstr::LOAD(i, IrOperand::imm(0)));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t[0], i, n));
+  code.push_back(IrInstr::FJUMP(t[0], endLoop));
+  code.push_back(IrInstr::MUL(t[1], n, k));
+  code.push_back(IrInstr::ILOAD(t[2], fn.constant("1")));
+  code.push_back(IrInstr::ADD(t[3], t[1], t[2]));
+  code.push_back(IrInstr::ADD(t[4], t[3], i));
+  code.push_back(IrInstr::WRITEI(t[4]));
+  code.push_back(IrInstr::ILOAD(t[5], fn.constant("0")));
+  code.push_back(IrInstr::EQ(t[6], d, t[5]));
+  code.push_back(IrInstr::NOT(t[7], t[6]));
+  code.push_back(IrInstr::FJUMP(t[7], endIf));
+  code.push_back(IrInstr::DIV(t[8], n, d));
+  code.push_back(IrInstr::WRITEI(t[8]));
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::ADD(i, i, t[2]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  std::string error;
+  long hoisted = hoist(fn, error);
+  if (hoisted < 0)
+    return fail("hoist", error, fn);
+  if (hoisted < 3)
+    return fail("hoist", "n*k+1 is left in the loop", fn);
+  // with d = 0 a division hoisted out of the condition fails
+  for (const std::vector<double> & input :
+         std::vector<std::vector<double>>{{0, 5, 0}, {3, 2, 0}, {4, -3, 2}})
+    if (not sameOutput(before, fn, input, error))
+      return fail("hoist", error, fn);
+  return true;
+}
+
+// A value written in the loop is not invariant, even if the
+// instruction that reads it has the same operands on each iteration:
+// s+k reads the s of the previous one.
+//
+//     READI n; READI k; LOAD s 0; LOAD i 0
+//   while:
+//     LT t0 i n; FJUMP t0 endwhile
+//     ADD s s k; ILOAD t1 1; ADD i i t1; UJUMP while
+//   endwhile:
+//     WRITEI s; RETURN
+static bool testVariant() {
+  IrFunction fn("variant");
+  IrList & code = fn.instructions();
+  IrOperand n = fn.addVar("n", 1), k = fn.addVar("k", 1);
+  IrOperand s = fn.addVar("s", 1), i = fn.addVar("i", 1);
+  IrOperand t0 = fn.newTemp(), t1 = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  code.push_back(IrInstr::READI(n));
+  code.push_back(IrInstr::READI(k));
+  code.push_back(IrInstr::LOAD(s, IrOperand::imm(0)));
+  code.push_back(IrInstr::LOAD(i, IrOperand::imm(0)));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t0, i, n));
+  code.push_back(IrInstr::FJUMP(t0, endLoop));
+  code.push_back(IrInstr::ADD(s, s, k));
+  code.push_back(IrInstr::ILOAD(t1, fn.constant("1")));
+  code.push_back(IrInstr::ADD(i, i, t1));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(s));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  std::string error;
+  if (hoist(fn, error) < 0)
+    return fail("variant", error, fn);
+  for (const std::vector<double> & input :
+         std::vector<std::vector<double>>{{0, 7}, {1, 7}, {5, -2}})
+    if (not sameOutput(before, fn, input, error))
+      return fail("variant", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testHoist();
+  ok = testVariant() and ok;
+  std::cout << (ok ? "LoopInvariantMotionTest: ok" : "LoopInvariantMotionTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    PeepholeTest - The peephole patterns on small functions
+//                   of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "Peephole.h"
+#include "DeadCodeEliminator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// A jump to a label followed by a jump goes to the end of the chain,
+// and the labels no longer jumped to are removed. Then the UJUMPs
+// after them can not be reached.
+//
+//     READI t0; FJUMP t0 else
+//     ILOAD t1 1; WRITEI t1; UJUMP next
+//   else:
+//     UJUMP endif
+//   next:
+//     UJUMP endif
+//   endif:
+//     ILOAD t2 2; WRITEI t2; RETURN
+static bool testJumpToJump() {
+  IrFunction fn("jumptojump");
+  IrList & code = fn.instructions();
+  IrOperand t0 = fn.newTemp(), t1 = fn.newTemp(), t2 = fn.newTemp();
+  IrOperand orElse = fn.newLabel("else"), next = fn.newLabel("next");
+  IrOperand endIf = fn.newLabel("endif");
+  code.push_back(IrInstr::READI(t0));
+  code.push_back(IrInstr::FJUMP(t0, orElse));
+  code.push_back(IrInstr::ILOAD(t1, fn.constant("1")));
+  code.push_back(IrInstr::WRITEI(t1));
+  code.push_back(IrInstr::UJUMP(next));
+  code.push_back(IrInstr::LABEL(orElse));
+  code.push_back(IrInstr::UJUMP(endIf));
+  code.push_back(IrInstr::LABEL(next));
+  code.push_back(IrInstr::UJUMP(endIf));
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::ILOAD(t2, fn.constant("2")));
+  code.push_back(IrInstr::WRITEI(t2));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  Peephole peephole(fn);
+  peephole.run();
+  DeadCodeEliminator(fn).run();
+  if (peephole.fired(Peephole::JumpToJump) == 0)
+    return fail("jump to jump", "the jumps are not retargeted", fn);
+  for (const IrInstr & instr : fn.instructions()) {
+    if (instr.op == IrOp::LABEL and instr.arg[0] != endIf)
+      return fail("jump to jump", "a label is left: " + fn.instrText(instr), fn);
+    if (instr.op == IrOp::UJUMP)
+      return fail("jump to jump", "a jump is left: " + fn.instrText(instr), fn);
+  }
+  std::string error;
+  for (double cond : {0, 1})
+    if (not sameOutput(before, fn, {cond}, error))
+      return fail("jump to jump", error, fn);
+  return true;
+}
+
+// The labels never jumped to are removed, also one that starts the
+// code or two in a row; the one jumped to stays.
+//
+//   first:
+//     READI t0
+//   unused:
+//   loop:
+//     WRITEI t0; ILOAD t1 1; SUB t0 t0 t1; FJUMP t0 end
+//     UJUMP loop
+//   end:
+//     RETURN
+static bool testUnusedLabel() {
+  IrFunction fn("unusedlabel");
+  IrList & code = fn.instructions();
+  IrOperand t0 = fn.newTemp(), t1 = fn.newTemp();
+  IrOperand first = fn.newLabel("first"), unused = fn.newLabel("unused");
+  IrOperand loop = fn.newLabel("loop"), end = fn.newLabel("end");
+  code.push_back(IrInstr::LABEL(first));
+  code.push_back(IrInstr::READI(t0));
+  code.push_back(IrInstr::LABEL(unused));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::WRITEI(t0));
+  code.push_back(IrInstr::ILOAD(t1, fn.constant("1")));
+  code.push_back(IrInstr::SUB(t0, t0, t1));
+  code.push_back(IrInstr::FJUMP(t0, end));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(end));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  Peephole peephole(fn);
+  peephole.run();
+  if (peephole.fired(Peephole::UnusedLabel) != 2)
+    return fail("unused label", "the unused labels are not both removed", fn);
+  for (const IrInstr & instr : fn.instructions())
+    if (instr.op == IrOp::LABEL and instr.arg[0] != loop and instr.arg[0] != end)
+      return fail("unused label", "a label is left: " + fn.instrText(instr), fn);
+  std::string error;
+  for (double times : {1, 4})
+    if (not sameOutput(before, fn, {times}, error))
+      return fail("unused label", error, fn);
+  return true;
+}
+
+// Jumps that only lead to each other: following the chain must stop.
+//
+//     UJUMP a
+//   a:
+//     UJUMP b
+//   b:
+//     UJUMP a
+static bool testJumpCycle() {
+  IrFunction fn("jumpcycle");
+  IrList & code = fn.instructions();
+  IrOperand a = fn.newLabel("a"), b = fn.newLabel("b");
+  code.push_back(IrInstr::UJUMP(a));
+  code.push_back(IrInstr::LABEL(a));
+  code.push_back(IrInstr::UJUMP(b));
+  code.push_back(IrInstr::LABEL(b));
+  code.push_back(IrInstr::UJUMP(a));
+  Peephole(fn).run();
+  return true;
+}
+
+int main() {
+  bool ok = testJumpToJump();
+  ok = testUnusedLabel() and ok;
+  ok = testJumpCycle() and ok;
+  std::cout << (ok ? "PeepholeTest: ok" : "PeepholeTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    SsaFormTest - The SSA form and the control flow graph
+//                   on small functions of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "DeadCodeEliminator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// A name written in a loop and never read after it has phis only
+// read by each other, at the end of the if and at the loop header.
+// They must not become copies that DCE can not remove.
+//
+//     READI x; READI t0; FJUMP t0 skip; WRITEI i
+//   skip:
+//     WRITEI x                      (x is read across blocks)
+//   while:
+//     ILOAD t1 10; LT t2 i t1; FJUMP t2 endwhile
+//     ILOAD t3 5; EQ t4 i t3; FJUMP t4 endif
+//     LOAD x i
+//   endif:
+//     ILOAD t5 1; ADD i i t5; UJUMP while
+//   endwhile:
+//     WRITEI i; RETURN
+static bool testDeadPhis() {
+  IrFunction fn("deadphis");
+  IrList & code = fn.instructions();
+  IrOperand i = fn.addParam("i");
+  IrOperand x = fn.addVar("x", 1);
+  IrOperand t[6];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand skip = fn.newLabel("skip"), loop = fn.newLabel("while");
+  IrOperand endIf = fn.newLabel("endif"), endLoop = fn.newLabel("endwhile");
+  code.push_back(IrInstr::READI(x));
+  code.push_back(IrInstr::READI(t[0]));
+  code.push_back(IrInstr::FJUMP(t[0], skip));
+  code.push_back(IrInstr::WRITEI(i));
+  code.push_back(IrInstr::LABEL(skip));
+  code.push_back(IrInstr::WRITEI(x));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("10")));
+  code.push_back(IrInstr::LT(t[2], i, t[1]));
+  code.push_back(IrInstr::FJUMP(t[2], endLoop));
+  code.push_back(IrInstr::ILOAD(t[3], fn.constant("5")));
+  code.push_back(IrInstr::EQ(t[4], i, t[3]));
+  code.push_back(IrInstr::FJUMP(t[4], endIf));
+  code.push_back(IrInstr::LOAD(x, i));
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::ILOAD(t[5], fn.constant("1")));
+  code.push_back(IrInstr::ADD(i, i, t[5]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(i));
+  code.push_back(IrInstr::RETURN());
+
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  std::string error;
+  if (not ssa.build(1000))
+    return fail("dead phis", "over the budget", fn);
+  if (not ssa.verify(error))
+    return fail("dead phis", error, fn);
+  ssa.lower();
+  DeadCodeEliminator(fn).run();
+  // the parameter is not renamed: any copy left is one of x
+  for (const IrInstr & instr : code)
+    if (instr.op == IrOp::LOAD)
+      return fail("dead phis", "a copy is left: " + fn.instrText(instr), fn);
+  return true;
+}
+
+// A function that starts with the header of a loop: the reads of the
+// name at the header are reached by the writes of the loop, so they
+// must be renamed even if no write comes before the loop.
+//
+//   top:
+//     WRITEI x; READI x; READI t0; FJUMP t0 top
+//     RETURN
+static bool testEntryLoop() {
+  IrFunction fn("entryloop");
+  IrList & code = fn.instructions();
+  IrOperand x = fn.addVar("x", 1);
+  IrOperand t0 = fn.newTemp();
+  IrOperand top = fn.newLabel("top");
+  code.push_back(IrInstr::LABEL(top));
+  code.push_back(IrInstr::WRITEI(x));
+  code.push_back(IrInstr::READI(x));
+  code.push_back(IrInstr::READI(t0));
+  code.push_back(IrInstr::FJUMP(t0, top));
+  code.push_back(IrInstr::RETURN());
+
+  ControlFlowGraph cfg(fn);
+  if (not cfg.block(0).preds.empty())
+    return fail("entry loop", "the entry block has predecessors", fn);
+  SsaForm ssa(fn, cfg);
+  std::string error;
+  if (not ssa.build(1000))
+    return fail("entry loop", "over the budget", fn);
+  if (not ssa.verify(error))
+    return fail("entry loop", error, fn);
+  for (const IrInstr & instr : code)
+    for (const IrOperand & o : instr.arg)
+      if (o == x)
+        return fail("entry loop", "x is not renamed in " + fn.instrText(instr), fn);
+  return true;
+}
+
+// The form built and lowered must not change what the code writes:
+// the loops and the ifs merge several values of the names, which the
+// phis and then their copies carry.
+//
+//     READI n; LOAD i 0; LOAD s 0
+//   while:
+//     LT t0 i n; FJUMP t0 endwhile
+//     XLOAD a i i; ILOAD t1 2; LOADX t2 a t1 (a[2] once it is written)
+//     LT t3 t2 i; FJUMP t3 else; ADD s s i; UJUMP endif
+//   else:
+//     SUB s s t2
+//   endif:
+//     ILOAD t4 1; ADD i i t4; UJUMP while
+//   endwhile:
+//     WRITEI s; WRITEI i; RETURN
+static bool testOutput() {
+  IrFunction fn("output");
+  IrList & code = fn.instructions();
+  IrOperand n = fn.addVar("n", 1), i = fn.addVar("i", 1);
+  IrOperand s = fn.addVar("s", 1), a = fn.addVar("a", 10);
+  IrOperand t[5];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  IrOperand orElse = fn.newLabel("else"), endIf = fn.newLabel("endif");
+  code.push_back(IrInstr::READI(n));
+  code.push_back(IrInstr::LOAD(i, IrOperand::imm(0)));
+  code.push_back(IrInstr::LOAD(s, IrOperand::imm(0)));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t[0], i, n));
+  code.push_back(IrInstr::FJUMP(t[0], endLoop));
+  code.push_back(IrInstr::XLOAD(a, i, i));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("2")));
+  code.push_back(IrInstr::LOADX(t[2], a, t[1]));
+  code.push_back(IrInstr::LT(t[3], t[2], i));
+  code.push_back(IrInstr::FJUMP(t[3], orElse));
+  code.push_back(IrInstr::ADD(s, s, i));
+  code.push_back(IrInstr::UJUMP(endIf));
+  code.push_back(IrInstr::LABEL(orElse));
+  code.push_back(IrInstr::SUB(s, s, t[2]));
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::ILOAD(t[4], fn.constant("1")));
+  code.push_back(IrInstr::ADD(i, i, t[4]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(s));
+  code.push_back(IrInstr::WRITEI(i));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  std::string error;
+  if (not ssa.build(1000))
+    return fail("output", "over the budget", fn);
+  if (not ssa.verify(error))
+    return fail("output", error, fn);
+  ssa.lower();
+  DeadCodeEliminator(fn).run();
+  for (double size : {0, 1, 3, 10})
+    if (not sameOutput(before, fn, {size}, error))
+      return fail("output", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testDeadPhis();
+  ok = testEntryLoop() and ok;
+  ok = testOutput() and ok;
+  std::cout << (ok ? "SsaFormTest: ok" : "SsaFormTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
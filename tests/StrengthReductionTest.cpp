@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    StrengthReductionTest - The strength reduction on small
+//                         functions of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "LoopInvariantMotion.h"
+#include "StrengthReduction.h"
+#include "DeadCodeEliminator.h"
+#include "IrOptimizer.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// Build the SSA form of 'fn', hoist the invariants of its loops (the
+// factors and the steps must be out of them), reduce the
+// multiplications, lower the form and remove what is left dead.
+// Returns false if the form can not be built or is wrong after the
+// passes
+static bool reduce(IrFunction & fn, std::size_t & reduced, std::size_t & removed,
+                   std::string & error) {
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  if (not ssa.build(1000)) {
+    error = "over the budget";
+    return false;
+  }
+  LoopInvariantMotion(fn, cfg, ssa).run();
+  StrengthReduction reduction(fn, cfg, ssa);
+  reduction.run();
+  if (not ssa.verify(error))
+    return false;
+  ssa.lower();
+  DeadCodeEliminator(fn).run();
+  reduced = reduction.numReduced();
+  removed = reduction.numRemoved();
+  return true;
+}
+
+// The code of a loop over the even elements of an array, up to the
+// bound 'bound' (a variable read before the loop, or a literal). It
+// stops at the first element that is 0: it writes 1 and returns.
+// Otherwise it writes 0 at the end.
+//
+//     READI n; LOAD i 0             (or ILOAD n <bound>)
+//   while:
+//     LT t0 i n; FJUMP t0 endwhile
+//     ILOAD t1 2; MUL t2 t1 i; LOADX t3 a t2
+//     ILOAD t4 0; EQ t5 t3 t4; FJUMP t5 endif
+//     ILOAD t6 1; WRITEI t6; RETURN
+//   endif:
+//     ILOAD t7 1; ADD i i t7; UJUMP while
+//   endwhile:
+//     WRITEI t4; RETURN
+static void buildSearch(IrFunction & fn, const std::string & bound, bool zero) {
+  IrList & code = fn.instructions();
+  IrOperand n = fn.addVar("n", 1), i = fn.addVar("i", 1);
+  IrOperand a = fn.addVar("a", 20);
+  IrOperand t[9];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  IrOperand endIf = fn.newLabel("endif");
+  // the elements are 1, but for a[0] if 'zero'
+  code.push_back(IrInstr::ILOAD(t[8], fn.constant("1")));
+  for (int32_t k = zero ? 1 : 0; k < 20; ++k)
+    code.push_back(IrInstr::XLOAD(a, IrOperand::imm(k), t[8]));
+  if (bound.empty())
+    code.push_back(IrInstr::READI(n));
+  else
+    code.push_back(IrInstr::ILOAD(n, fn.constant(bound)));
+  code.push_back(IrInstr::LOAD(i, IrOperand::imm(0)));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t[0], i, n));
+  code.push_back(IrInstr::FJUMP(t[0], endLoop));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("2")));
+  code.push_back(IrInstr::MUL(t[2], t[1], i));
+  code.push_back(IrInstr::LOADX(t[3], a, t[2]));
+  code.push_back(IrInstr::ILOAD(t[4], fn.constant("0")));
+  code.push_back(IrInstr::EQ(t[5], t[3], t[4]));
+  code.push_back(IrInstr::FJUMP(t[5], endIf));
+  code.push_back(IrInstr::ILOAD(t[6], fn.constant("1")));
+  code.push_back(IrInstr::WRITEI(t[6]));
+  code.push_back(IrInstr::RETURN());
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::ILOAD(t[7], fn.constant("1")));
+  code.push_back(IrInstr::ADD(i, i, t[7]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(t[4]));
+  code.push_back(IrInstr::RETURN());
+}
+
+// With a bound read at run time, the bound multiplied by 2 may
+// overflow where i < n does not: with n = 2^30, 2*n is INT_MIN and the
+// loop would not run. The variable must stay, at -O2 as well.
+static bool testBoundRead() {
+  IrFunction fn("boundread");
+  buildSearch(fn, "", true);
+  IrFunction before = fn;
+  std::size_t reduced, removed;
+  std::string error;
+  if (not reduce(fn, reduced, removed, error))
+    return fail("bound read", error, fn);
+  if (removed != 0)
+    return fail("bound read", "i is removed, and compared as 2*i < 2*n", fn);
+  for (double size : {0.0, 3.0, 1073741824.0})
+    if (not sameOutput(before, fn, {size}, error))
+      return fail("bound read", error, fn);
+
+  IrFunction optimized = before;
+  IrOptimizer(2, true).run(optimized);
+  for (double size : {0.0, 3.0, 1073741824.0})
+    if (not sameOutput(before, optimized, {size}, error))
+      return fail("bound read -O2", error, optimized);
+  return true;
+}
+
+// With a literal bound whose products fit in an int, i is only
+// compared and is removed: the loop goes on while 2*i < 2*10.
+static bool testBoundLiteral() {
+  IrFunction fn("boundliteral");
+  buildSearch(fn, "10", false);
+  IrFunction before = fn;
+  std::size_t reduced, removed;
+  std::string error;
+  if (not reduce(fn, reduced, removed, error))
+    return fail("bound literal", error, fn);
+  if (reduced != 1 or removed != 1)
+    return fail("bound literal", "2*i is not reduced, or i is not removed", fn);
+  if (not sameOutput(before, fn, {}, error))
+    return fail("bound literal", error, fn);
+  return true;
+}
+
+// A literal bound whose product overflows: 2*2^30 is not an int, so i
+// stays even if the bound is known. The loop stops at a[0] = 0.
+static bool testBoundOverflow() {
+  IrFunction fn("boundoverflow");
+  buildSearch(fn, "1073741824", true);
+  IrFunction before = fn;
+  std::size_t reduced, removed;
+  std::string error;
+  if (not reduce(fn, reduced, removed, error))
+    return fail("bound overflow", error, fn);
+  if (removed != 0)
+    return fail("bound overflow", "i is removed, and 2*2^30 overflows", fn);
+  if (not sameOutput(before, fn, {}, error))
+    return fail("bound overflow", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testBoundRead();
+  ok = testBoundLiteral() and ok;
+  ok = testBoundOverflow() and ok;
+  std::cout << (ok ? "StrengthReductionTest: ok" : "StrengthReductionTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    TempAllocatorTest - The allocation of temporaries on small
+//                        functions of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "TempAllocator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// The temporaries carried by a loop (as those of the phis of the SSA
+// form, once lowered) are live across its back edge: those of the
+// body can not take their names, even where they are not read again
+// in the iteration. The others share one name.
+//
+//     READI t0; ILOAD t1 0; ILOAD t2 0      (n, i and s)
+//   while:
+//     LT t3 t1 t0; FJUMP t3 endwhile
+//     ADD t4 t2 t1; LOAD t2 t4
+//     ILOAD t5 1; ADD t6 t1 t5; LOAD t1 t6; UJUMP while
+//   endwhile:
+//     WRITEI t2; WRITEI t1; RETURN
+static bool testBackEdge() {
+  IrFunction fn("backedge");
+  IrList & code = fn.instructions();
+  IrOperand t[7];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  code.push_back(IrInstr::READI(t[0]));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("0")));
+  code.push_back(IrInstr::ILOAD(t[2], fn.constant("0")));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t[3], t[1], t[0]));
+  code.push_back(IrInstr::FJUMP(t[3], endLoop));
+  code.push_back(IrInstr::ADD(t[4], t[2], t[1]));
+  code.push_back(IrInstr::LOAD(t[2], t[4]));
+  code.push_back(IrInstr::ILOAD(t[5], fn.constant("1")));
+  code.push_back(IrInstr::ADD(t[6], t[1], t[5]));
+  code.push_back(IrInstr::LOAD(t[1], t[6]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(t[2]));
+  code.push_back(IrInstr::WRITEI(t[1]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  // n, i and s, and one name for the body
+  if (not TempAllocator(fn).run() or fn.numTemps() != 4)
+    return fail("back edge", "the temporaries do not get 4 names", fn);
+  std::string error;
+  for (double size : {0, 1, 5})
+    if (not sameOutput(before, fn, {size}, error))
+      return fail("back edge", error, fn);
+  return true;
+}
+
+// The destination of a copy can take the name of its source, read
+// there for the last time: the copy does nothing, and is removed.
+//
+//     READI t0; ILOAD t1 1; ADD t2 t0 t1; LOAD t3 t2; WRITEI t3; RETURN
+static bool testSelfCopy() {
+  IrFunction fn("selfcopy");
+  IrList & code = fn.instructions();
+  IrOperand t[4];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  code.push_back(IrInstr::READI(t[0]));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("1")));
+  code.push_back(IrInstr::ADD(t[2], t[0], t[1]));
+  code.push_back(IrInstr::LOAD(t[3], t[2]));
+  code.push_back(IrInstr::WRITEI(t[3]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  TempAllocator(fn).run();
+  for (const IrInstr & instr : fn.instructions())
+    if (instr.op == IrOp::LOAD)
+      return fail("self copy", "a copy is left: " + fn.instrText(instr), fn);
+  std::string error;
+  if (not sameOutput(before, fn, {41}, error))
+    return fail("self copy", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testBackEdge();
+  ok = testSelfCopy() and ok;
+  std::cout << (ok ? "TempAllocatorTest: ok" : "TempAllocatorTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
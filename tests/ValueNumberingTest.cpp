@@ -0,0 +1,189 @@
+//////////////////////////////////////////////////////////////////////
+//
+//    ValueNumberingTest - The value numbering on small functions
+//                         of t-code
+//
+//    Copyright (C) 2018  Universitat Politecnica de Catalunya
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU General Public License
+//    as published by the Free Software Foundation; either version 3
+//    of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Affero General Public License for more details.
+//
+//    You should have received a copy of the GNU Affero General Public
+//    License along with this library; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+//
+//    contact: José Miguel Rivero (rivero@cs.upc.edu)
+//             Computer Science Department
+//             Universitat Politecnica de Catalunya
+//             despatx Omega.110 - Campus Nord UPC
+//             08034 Barcelona.  SPAIN
+//
+//////////////////////////////////////////////////////////////////////
+
+
+#include "IrCode.h"
+#include "ControlFlowGraph.h"
+#include "SsaForm.h"
+#include "ValueNumbering.h"
+#include "DeadCodeEliminator.h"
+#include "IrInterpreter.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>    // EXIT_FAILURE, EXIT_SUCCESS
+
+
+// Each test builds the code of a function, runs the passes on it and
+// checks the result; it returns false, after writing what is wrong,
+// on failure.
+
+static bool fail(const std::string & test, const std::string & error, IrFunction & fn) {
+  std::cerr << test << ": " << error << std::endl;
+  for (const IrInstr & instr : fn.instructions())
+    std::cerr << "    " << fn.instrText(instr) << std::endl;
+  return false;
+}
+
+// Build the SSA form of 'fn', number its values, lower it and remove
+// what is left dead. Returns the number of values replaced, or -1 if
+// the form can not be built or is wrong after the pass
+static long numberValues(IrFunction & fn, std::string & error) {
+  ControlFlowGraph cfg(fn);
+  SsaForm ssa(fn, cfg);
+  if (not ssa.build(1000)) {
+    error = "over the budget";
+    return -1;
+  }
+  ValueNumbering numbering(fn, cfg, ssa);
+  numbering.run();
+  if (not ssa.verify(error))
+    return -1;
+  ssa.lower();
+  DeadCodeEliminator(fn).run();
+  return numbering.numReplaced();
+}
+
+// x+y is computed again in the same block, with the operands swapped,
+// and in a block that it dominates: both are replaced. The reads of
+// a[0] are not, since a[0] is written between them, or they are in
+// the block where the if joins, which starts a new epoch of memory.
+//
+//     READI x; READI y; ADD t0 x y
+//     ILOAD t1 0; XLOAD a t1 t0; LOADX t2 a t1
+//     ADD t3 y x                    (t0)
+//     LT t4 x y; FJUMP t4 endif
+//     ADD t5 x y                    (t0)
+//     ADD t6 t5 t5; XLOAD a t1 t6
+//     LOADX t7 a t1; WRITEI t7      (not t2)
+//   endif:
+//     LOADX t8 a t1                 (not t2)
+//     WRITEI t2; WRITEI t3; WRITEI t8; RETURN
+static bool testRedundant() {
+  IrFunction fn("redundant");
+  IrList & code = fn.instructions();
+  IrOperand x = fn.addVar("x", 1), y = fn.addVar("y", 1);
+  IrOperand a = fn.addVar("a", 2);
+  IrOperand t[9];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand endIf = fn.newLabel("endif");
+  code.push_back(IrInstr::READI(x));
+  code.push_back(IrInstr::READI(y));
+  code.push_back(IrInstr::ADD(t[0], x, y));
+  code.push_back(IrInstr::ILOAD(t[1], fn.constant("0")));
+  code.push_back(IrInstr::XLOAD(a, t[1], t[0]));
+  code.push_back(IrInstr::LOADX(t[2], a, t[1]));
+  code.push_back(IrInstr::ADD(t[3], y, x));
+  code.push_back(IrInstr::LT(t[4], x, y));
+  code.push_back(IrInstr::FJUMP(t[4], endIf));
+  code.push_back(IrInstr::ADD(t[5], x, y));
+  code.push_back(IrInstr::ADD(t[6], t[5], t[5]));
+  code.push_back(IrInstr::XLOAD(a, t[1], t[6]));
+  code.push_back(IrInstr::LOADX(t[7], a, t[1]));
+  code.push_back(IrInstr::WRITEI(t[7]));
+  code.push_back(IrInstr::LABEL(endIf));
+  code.push_back(IrInstr::LOADX(t[8], a, t[1]));
+  code.push_back(IrInstr::WRITEI(t[2]));
+  code.push_back(IrInstr::WRITEI(t[3]));
+  code.push_back(IrInstr::WRITEI(t[8]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  std::string error;
+  long replaced = numberValues(fn, error);
+  if (replaced < 0)
+    return fail("redundant", error, fn);
+  if (replaced < 2)
+    return fail("redundant", "x+y is computed again", fn);
+  for (const std::vector<double> & input :
+         std::vector<std::vector<double>>{{1, 2}, {3, 1}, {-4, 7}})
+    if (not sameOutput(before, fn, input, error))
+      return fail("redundant", error, fn);
+  return true;
+}
+
+// A value computed before a loop and again in it is replaced, but a
+// value that depends on the variable of the loop is not: each
+// iteration has its own.
+//
+//     READI n; LOAD i 0; ILOAD t0 3; MUL t1 n t0
+//   while:
+//     LT t2 i n; FJUMP t2 endwhile
+//     MUL t3 n t0                   (t1)
+//     MUL t4 i t0; ADD t5 t3 t4; WRITEI t5
+//     ILOAD t6 1; ADD i i t6; UJUMP while
+//   endwhile:
+//     WRITEI t1; RETURN
+static bool testLoop() {
+  IrFunction fn("loop");
+  IrList & code = fn.instructions();
+  IrOperand n = fn.addVar("n", 1), i = fn.addVar("i", 1);
+  IrOperand t[7];
+  for (IrOperand & o : t)
+    o = fn.newTemp();
+  IrOperand loop = fn.newLabel("while"), endLoop = fn.newLabel("endwhile");
+  code.push_back(IrInstr::READI(n));
+  code.push_back(IrInstr::LOAD(i, IrOperand::imm(0)));
+  code.push_back(IrInstr::ILOAD(t[0], fn.constant("3")));
+  code.push_back(IrInstr::MUL(t[1], n, t[0]));
+  code.push_back(IrInstr::LABEL(loop));
+  code.push_back(IrInstr::LT(t[2], i, n));
+  code.push_back(IrInstr::FJUMP(t[2], endLoop));
+  code.push_back(IrInstr::MUL(t[3], n, t[0]));
+  code.push_back(IrInstr::MUL(t[4], i, t[0]));
+  code.push_back(IrInstr::ADD(t[5], t[3], t[4]));
+  code.push_back(IrInstr::WRITEI(t[5]));
+  code.push_back(IrInstr::ILOAD(t[6], fn.constant("1")));
+  code.push_back(IrInstr::ADD(i, i, t[6]));
+  code.push_back(IrInstr::UJUMP(loop));
+  code.push_back(IrInstr::LABEL(endLoop));
+  code.push_back(IrInstr::WRITEI(t[1]));
+  code.push_back(IrInstr::RETURN());
+
+  IrFunction before = fn;
+  std::string error;
+  long replaced = numberValues(fn, error);
+  if (replaced < 0)
+    return fail("loop", error, fn);
+  if (replaced == 0)
+    return fail("loop", "n*3 is computed again in the loop", fn);
+  for (double size : {0, 1, 4})
+    if (not sameOutput(before, fn, {size}, error))
+      return fail("loop", error, fn);
+  return true;
+}
+
+int main() {
+  bool ok = testRedundant();
+  ok = testLoop() and ok;
+  std::cout << (ok ? "ValueNumberingTest: ok" : "ValueNumberingTest: FAILED") << std::endl;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}